@@ -0,0 +1,437 @@
+#pragma once
+
+/*
+AdaptiveCache：按负载自动选择淘汰策略（LRU / LRU-K / LFU）的缓存。
+
+有的负载由最近性主导（热点不断漂移），有的由频率主导（少量长期热点 + 大量一次性扫描），
+静态地选一种策略总有一类负载吃亏。这里在线模拟三种候选策略，当前谁的命中率高就用谁来淘汰：
+
+- 影子缓存：按 key 的哈希做空间采样（和 trace_sim 的 SHARDS 一样），只有落在前 sampleRate 比例内的 key
+  才进入影子缓存。三个影子分别是 LruCache、LruKCache（k = 2）和 LfuCache 本身，容量按采样率缩小，
+  只保存 key（值是一个字节的占位符）。影子只观察 get（未命中时按需填充）和 remove，
+  在释放主缓存的锁之后更新，不延长主缓存的持锁时间。采样到的访问先攒进缓冲区，每 kReplayBatch 个一起重放：
+  两次采样之间主缓存的访问早已把影子缓存的数据挤出 CPU 缓存，逐个重放时每次都是冷的，成批重放只冷一次；
+- 决策窗口：每 windowSamples 次采样 get 比较一次各影子的命中率。候选策略要比当前策略至少高出 switchMargin，
+  并且连续 patience 个窗口都是同一个候选者，才切换过去（滞后，避免在两种策略之间来回摆动）。
+  第一个窗口是影子缓存的冷启动，不参与比较；
+- 主缓存：所有条目放在一个连续数组里，每个条目记录最近一次访问、上一次访问的逻辑时间和（会老化的）访问次数，
+  三种策略需要的信息都在里面。淘汰时随机抽查 evictionSamples 个条目，按当前策略挑出最该淘汰的一个：
+  LRU 比较最近一次访问，LRU-2 先比较上一次访问（只访问过一次的最先淘汰），LFU 先比较访问次数。
+  所以切换策略是 O(1) 的，不需要迁移任何数据；代价是主缓存的淘汰是近似的。
+
+采样开销：每次 get 多算一次哈希；被采样的 get 再多做三次影子缓存操作（成批进行）。adaptiveStats() 报告采样比例、
+影子操作的总耗时和影子缓存的容量，用来确认开销在预算之内（adaptive_bench 测量吞吐量的下降）。
+sampleRate 为 0 时不建影子缓存，一直使用 initial 指定的策略。
+*/
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "KICachePolicy.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+#include "LruKCache.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+enum class AdaptivePolicy : uint8_t { Lru, LruK, Lfu };
+
+constexpr size_t kAdaptivePolicyNum = 3;
+
+inline const char* adaptivePolicyName(AdaptivePolicy policy) {
+    switch (policy) {
+    case AdaptivePolicy::Lru:  return "lru";
+    case AdaptivePolicy::LruK: return "lru-2";
+    default:                   return "lfu";
+    }
+}
+
+struct AdaptiveOptions {
+    double sampleRate = 0.005;    // 进入影子缓存的 key 比例，0 表示不采样
+    size_t windowSamples = 500;   // 每个决策窗口包含的采样 get 次数
+    double switchMargin = 0.01;   // 候选策略的命中率至少要高出这么多才算更好
+    int patience = 3;             // 连续这么多个窗口更好才切换
+    size_t evictionSamples = 8;   // 淘汰时随机抽查的条目数
+    AdaptivePolicy initial = AdaptivePolicy::Lru;
+};
+
+struct AdaptiveStats {
+    AdaptivePolicy active = AdaptivePolicy::Lru;
+    uint64_t switches = 0;        // 切换策略的次数
+    uint64_t windows = 0;         // 已完成的决策窗口数
+    uint64_t accesses = 0;        // 主缓存的 get 次数
+    uint64_t sampledAccesses = 0; // 其中进入影子缓存的次数
+    uint64_t shadowNanos = 0;     // 更新影子缓存花费的总时间
+    size_t shadowCapacity = 0;    // 每个影子缓存的容量
+    std::array<double, kAdaptivePolicyNum> windowHitRatio{}; // 最近一个窗口中各影子缓存的命中率
+
+    double sampledFraction() const {
+        return accesses == 0 ? 0.0 : static_cast<double>(sampledAccesses) / accesses;
+    }
+
+    // 平均摊到每次 get 上的影子缓存耗时（纳秒）
+    double shadowNanosPerAccess() const {
+        return accesses == 0 ? 0.0 : static_cast<double>(shadowNanos) / accesses;
+    }
+};
+
+template <typename Key, typename Value>
+class AdaptiveCache : public KICachePolicy<Key, Value>
+{
+public:
+    AdaptiveCache(int capacity, AdaptiveOptions options = AdaptiveOptions())
+    : capacity_(capacity > 0 ? static_cast<size_t>(capacity) : 0),
+      options_(options),
+      active_(options.initial),
+      tick_(0),
+      freqSum_(0),
+      rng_(0x9e3779b97f4a7c15ULL),
+      accesses_(0)
+    {
+        if (options_.evictionSamples == 0) options_.evictionSamples = 1;
+        if (options_.windowSamples == 0) options_.windowSamples = 1;
+        entries_.reserve(capacity_);
+        nodeMap_.reserve(capacity_);
+
+        double rate = options_.sampleRate < 1.0 ? options_.sampleRate : 1.0;
+        sampleThreshold_ = rate > 0 && capacity_ > 0 ? static_cast<uint64_t>(rate * kSampleModulus) : 0;
+        if (sampleThreshold_ > 0) {
+            int shadowCapacity = static_cast<int>(std::max<double>(std::llround(capacity_ * rate), 1));
+            shadowCapacity_ = static_cast<size_t>(shadowCapacity);
+            lruShadow_ = std::make_unique<LruCache<Key, Marker>>(shadowCapacity);
+            lruKShadow_ = std::make_unique<LruKCache<Key, Marker>>(shadowCapacity, shadowCapacity, 2);
+            lfuShadow_ = std::make_unique<LfuCache<Key, Marker>>(shadowCapacity);
+            samples_.reserve(kReplayBatch);
+        }
+    }
+
+    ~AdaptiveCache() override = default;
+
+    AdaptiveCache(const AdaptiveCache&) = delete;
+    AdaptiveCache& operator=(const AdaptiveCache&) = delete;
+
+    void put(Key key, Value value) override {
+        if (capacity_ == 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it != nodeMap_.end()) {
+            Entry& entry = entries_[it->second];
+            stats_.recordUpdate();
+            notifier_.record(entry.key, entry.value, RemovalCause::Replaced);
+            entry.value = std::move(value);
+            touch(entry);
+            return;
+        }
+
+        stats_.recordInsert();
+        if (entries_.size() >= capacity_) evictOne();
+        uint32_t slot = static_cast<uint32_t>(entries_.size());
+        entries_.push_back(Entry{key, std::move(value), ++tick_, 0, 1});
+        ++freqSum_;
+        nodeMap_.emplace(std::move(key), slot);
+    }
+
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        put(std::move(key), Value(std::forward<Args>(args)...));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return visit<Key>(key, [&value](const Value& v) { value = v; });
+    }
+
+    // 异构查找：例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 命中时在持锁状态下把值交给 visitor；被采样的 key 在解锁之后再更新影子缓存
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        bool hit = false;
+        {
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            ++accesses_;
+            auto it = findKey(nodeMap_, key);
+            if (it != nodeMap_.end()) {
+                Entry& entry = entries_[it->second];
+                touch(entry);
+                visitor(static_cast<const Value&>(entry.value));
+                stats_.recordHit();
+                hit = true;
+            } else {
+                stats_.recordMiss();
+            }
+        }
+        if (sampled(key)) record(Key(key), false);
+        return hit;
+    }
+
+    void remove(const Key& key) {
+        {
+            NotifyScope<Key, Value> notify(notifier_);
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            auto it = nodeMap_.find(key);
+            if (it != nodeMap_.end()) {
+                uint32_t slot = it->second;
+                notifier_.record(entries_[slot].key, entries_[slot].value, RemovalCause::Explicit);
+                eraseSlot(slot);
+                stats_.recordRemoval();
+            }
+        }
+        if (sampled(key)) record(key, true);
+    }
+
+    size_t size() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return entries_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // 当前用于淘汰的策略
+    AdaptivePolicy activePolicy() const { return active_.load(std::memory_order_relaxed); }
+
+    AdaptiveStats adaptiveStats() {
+        AdaptiveStats result;
+        {
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            result.accesses = accesses_;
+        }
+        std::lock_guard<std::mutex> lock(shadowMutex_);
+        result.active = activePolicy();
+        result.switches = switches_;
+        result.windows = windows_;
+        result.sampledAccesses = sampledAccesses_;
+        result.shadowNanos = shadowNanos_;
+        result.shadowCapacity = shadowCapacity_;
+        result.windowHitRatio = lastHitRatio_;
+        return result;
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+private:
+    using Marker = char; // 影子缓存只关心 key，值是一个字节的占位符
+
+    struct Sample {
+        Key key;
+        bool removed; // true 为 remove，false 为 get
+    };
+
+    struct Entry {
+        Key key;
+        Value value;
+        uint64_t last;  // 最近一次访问的逻辑时间
+        uint64_t prev;  // 上一次访问的逻辑时间，只访问过一次时为 0
+        uint32_t count; // 访问次数，平均值超过 kMaxAverageFreq 时整体减半
+    };
+
+    static constexpr size_t kReplayBatch = 64;
+    static constexpr uint64_t kMaxAverageFreq = 10; // 和 LfuCache 默认的 maxAverageNum 一致
+
+    template <typename K>
+    bool sampled(const K& key) const {
+        if (sampleThreshold_ == 0) return false;
+        return sampledHash(mixHash(static_cast<uint64_t>(KeyHash<Key>{}(key))), sampleThreshold_);
+    }
+
+    void touch(Entry& entry) {
+        entry.prev = entry.last;
+        entry.last = ++tick_;
+        if (entry.count != UINT32_MAX) {
+            ++entry.count;
+            if (++freqSum_ > kMaxAverageFreq * entries_.size()) age();
+        }
+    }
+
+    // 所有访问次数减半，让过去的热点逐渐让位给新的热点
+    void age() {
+        freqSum_ = 0;
+        for (Entry& entry : entries_) {
+            entry.count -= entry.count / 2;
+            freqSum_ += entry.count;
+        }
+    }
+
+    // a 是否比 b 更应该被淘汰
+    static bool evictBefore(AdaptivePolicy policy, const Entry& a, const Entry& b) {
+        switch (policy) {
+        case AdaptivePolicy::Lru:
+            return a.last < b.last;
+        case AdaptivePolicy::LruK:
+            return a.prev != b.prev ? a.prev < b.prev : a.last < b.last;
+        default:
+            return a.count != b.count ? a.count < b.count : a.last < b.last;
+        }
+    }
+
+    uint32_t randomSlot() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 7;
+        rng_ ^= rng_ << 17;
+        return static_cast<uint32_t>(rng_ % entries_.size());
+    }
+
+    // 随机抽查 evictionSamples 个条目，按当前策略淘汰其中最该淘汰的一个。调用者持有 mutex_
+    void evictOne() {
+        if (entries_.empty()) return;
+        AdaptivePolicy policy = active_.load(std::memory_order_relaxed);
+        uint32_t victim = randomSlot();
+        for (size_t i = 1; i < options_.evictionSamples; ++i) {
+            uint32_t slot = randomSlot();
+            if (evictBefore(policy, entries_[slot], entries_[victim])) victim = slot;
+        }
+        stats_.recordEviction();
+        notifier_.record(entries_[victim].key, entries_[victim].value, RemovalCause::Evicted);
+        eraseSlot(victim);
+    }
+
+    // 用数组最后一个条目填补空位，保持数组连续
+    void eraseSlot(uint32_t slot) {
+        freqSum_ -= entries_[slot].count;
+        nodeMap_.erase(entries_[slot].key);
+        uint32_t last = static_cast<uint32_t>(entries_.size() - 1);
+        if (slot != last) {
+            entries_[slot] = std::move(entries_[last]);
+            nodeMap_.find(entries_[slot].key)->second = slot;
+        }
+        entries_.pop_back();
+    }
+
+    // 攒够一批采样再重放
+    void record(Key key, bool removed) {
+        std::lock_guard<std::mutex> lock(shadowMutex_);
+        samples_.push_back(Sample{std::move(key), removed});
+        if (!removed) ++sampledAccesses_;
+        if (samples_.size() >= kReplayBatch) replay();
+    }
+
+    // 在影子缓存中重放采样到的访问：get 命中计数，未命中时按需填充。调用者持有 shadowMutex_
+    void replay() {
+        uint64_t start = statsNowNs();
+        for (const Sample& sample : samples_) {
+            const Key& key = sample.key;
+            if (sample.removed) {
+                lruShadow_->remove(key);
+                lruKShadow_->remove(key);
+                lfuShadow_->remove(key);
+                continue;
+            }
+            Marker marker = 0;
+            bool hits[kAdaptivePolicyNum];
+            hits[0] = lruShadow_->get(key, marker);
+            if (!hits[0]) lruShadow_->put(key, marker);
+            // LRU-K 的 get 和 put 各算一次访问，用 getOrPut 只算一次
+            hits[1] = lruKShadow_->getOrPut(key, marker);
+            hits[2] = lfuShadow_->get(key, marker);
+            if (!hits[2]) lfuShadow_->put(key, marker);
+
+            for (size_t i = 0; i < kAdaptivePolicyNum; ++i) windowHits_[i] += hits[i];
+            if (++windowCount_ >= options_.windowSamples) decide();
+        }
+        samples_.clear();
+        shadowNanos_ += statsNowNs() - start;
+    }
+
+    // 一个窗口结束：候选者连续 patience 个窗口领先 switchMargin 以上才切换。调用者持有 shadowMutex_
+    void decide() {
+        size_t active = static_cast<size_t>(active_.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < kAdaptivePolicyNum; ++i) {
+            lastHitRatio_[i] = static_cast<double>(windowHits_[i]) / windowCount_;
+        }
+        size_t best = active;
+        for (size_t i = 0; i < kAdaptivePolicyNum; ++i) {
+            if (lastHitRatio_[i] > lastHitRatio_[best]) best = i;
+        }
+        ++windows_;
+        windowHits_.fill(0);
+        windowCount_ = 0;
+        // 第一个窗口里影子缓存还是冷的，LRU-K 要访问两次才能命中，比较没有意义
+        if (windows_ == 1) return;
+
+        if (best == active || lastHitRatio_[best] < lastHitRatio_[active] + options_.switchMargin) {
+            streak_ = 0;
+            return;
+        }
+        streak_ = best == candidate_ ? streak_ + 1 : 1;
+        candidate_ = best;
+        if (streak_ >= options_.patience) {
+            active_.store(static_cast<AdaptivePolicy>(best), std::memory_order_relaxed);
+            ++switches_;
+            streak_ = 0;
+        }
+    }
+
+private:
+    size_t capacity_;
+    AdaptiveOptions options_;
+    std::atomic<AdaptivePolicy> active_; // 持 shadowMutex_ 时切换，淘汰时（持 mutex_）读取
+
+    // 主缓存，由 mutex_ 保护
+    std::mutex mutex_;
+    std::vector<Entry> entries_;                              // 所有条目，连续存放
+    FlatHashMap<Key, uint32_t, KeyHash<Key>, KeyEqual> nodeMap_; // key -> entries_ 下标
+    uint64_t tick_;                                           // 逻辑时钟，每次访问加一
+    uint64_t freqSum_;                                        // 所有条目访问次数之和
+    uint64_t rng_;                                            // 淘汰抽样用的 xorshift 状态
+    uint64_t accesses_;
+
+    // 影子缓存和决策状态，由 shadowMutex_ 保护
+    uint64_t sampleThreshold_;
+    size_t shadowCapacity_ = 0;
+    std::mutex shadowMutex_;
+    std::unique_ptr<LruCache<Key, Marker>> lruShadow_;
+    std::unique_ptr<LruKCache<Key, Marker>> lruKShadow_;
+    std::unique_ptr<LfuCache<Key, Marker>> lfuShadow_;
+    std::vector<Sample> samples_; // 等待重放的采样
+    std::array<uint64_t, kAdaptivePolicyNum> windowHits_{};
+    std::array<double, kAdaptivePolicyNum> lastHitRatio_{};
+    size_t windowCount_ = 0;
+    size_t candidate_ = 0;
+    int streak_ = 0;
+    uint64_t windows_ = 0;
+    uint64_t switches_ = 0;
+    uint64_t sampledAccesses_ = 0;
+    uint64_t shadowNanos_ = 0;
+
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
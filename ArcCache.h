@@ -0,0 +1,263 @@
+#pragma once
+
+/*
+ArcCache：自适应替换缓存（Adaptive Replacement Cache, Megiddo & Modha）。
+
+维护四个链表：
+- T1：只被访问过一次的常驻数据（偏向最近性）
+- T2：被访问过至少两次的常驻数据（偏向频率）
+- B1：从 T1 淘汰出去的 key（幽灵链表，只保存 key）
+- B2：从 T2 淘汰出去的 key（幽灵链表，只保存 key）
+
+p_ 是 T1 的目标大小：B1 命中说明 T1 太小，p_ 增大；B2 命中说明 T2 太小，p_ 减小。
+一次性的扫描只会进入 T1，不会冲掉 T2 中的热点数据。所有操作都是 O(1)。
+
+节点和链表复用 LruCache 中的 LruNode：链表头部是最久未使用的节点，尾部是最近访问的节点。
+*/
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "KICachePolicy.h"
+#include "LruCache.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+template <typename Key, typename Value>
+class ArcCache : public KICachePolicy<Key, Value>
+{
+public:
+    using NodePtr = std::shared_ptr<LruNode<Key, Value>>;
+
+    // 节点当前所在的链表
+    enum class Where { T1, T2, B1, B2 };
+
+    struct Entry {
+        NodePtr node;
+        Where where;
+    };
+
+    ArcCache(int capacity) : capacity_(capacity > 0 ? capacity : 0), p_(0) {}
+
+    ~ArcCache() override = default;
+
+    void put(Key key, Value value) override {
+        if (capacity_ == 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) {
+            stats_.recordInsert();
+            addNewNode(std::move(key), std::move(value));
+            return;
+        }
+
+        Entry& entry = it->second;
+        if (entry.where == Where::B1 || entry.where == Where::B2) {
+            stats_.recordInsert(); // 幽灵命中：值重新进入缓存
+        }
+        switch (entry.where) {
+        case Where::T1:
+        case Where::T2:
+            // 常驻命中：更新值并移到 T2
+            stats_.recordUpdate();
+            notifier_.record(entry.node->getKey(), entry.node->getValue(), RemovalCause::Replaced);
+            entry.node->setValue(std::move(value));
+            moveToT2(entry);
+            break;
+        case Where::B1: {
+            // B1 幽灵命中：最近性不够，增大 T1 的目标大小
+            size_t delta = std::max<size_t>(b2_.size() / b1_.size(), 1);
+            p_ = std::min(capacity_, p_ + delta);
+            b1_.remove(entry.node);
+            replace(false);
+            entry.node->setValue(std::move(value));
+            entry.where = Where::T2;
+            t2_.pushBack(entry.node);
+            break;
+        }
+        case Where::B2: {
+            // B2 幽灵命中：频率不够，减小 T1 的目标大小
+            size_t delta = std::max<size_t>(b1_.size() / b2_.size(), 1);
+            p_ = p_ > delta ? p_ - delta : 0;
+            b2_.remove(entry.node);
+            replace(true);
+            entry.node->setValue(std::move(value));
+            entry.where = Where::T2;
+            t2_.pushBack(entry.node);
+            break;
+        }
+        }
+    }
+
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        put(std::move(key), Value(std::forward<Args>(args)...));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    // 异构查找：例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 零拷贝读取：命中时在持锁状态下把值的 const 引用交给 visitor
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = findKey(nodeMap_, key);
+        if (it == nodeMap_.end()) {
+            stats_.recordMiss();
+            return false;
+        }
+
+        Entry& entry = it->second;
+        if (entry.where == Where::B1 || entry.where == Where::B2) {
+            stats_.recordMiss();
+            return false; // 幽灵链表中只有 key，没有值
+        }
+        moveToT2(entry);
+        visitor(entry.node->getValue());
+        stats_.recordHit();
+        return true;
+    }
+
+    void remove(const Key& key) {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) return;
+        if (it->second.where == Where::T1 || it->second.where == Where::T2) {
+            stats_.recordRemoval();
+            notifier_.record(it->second.node->getKey(), it->second.node->getValue(), RemovalCause::Explicit);
+        }
+        listOf(it->second.where).remove(it->second.node);
+        nodeMap_.erase(it);
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    // 只通知常驻数据；进入幽灵链表算作淘汰，幽灵节点被丢弃时不再通知
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+    // T1 的目标大小，主要用于观察自适应过程
+    size_t target() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return p_;
+    }
+
+private:
+    LruList<Key, Value>& listOf(Where where) {
+        switch (where) {
+        case Where::T1: return t1_;
+        case Where::T2: return t2_;
+        case Where::B1: return b1_;
+        default:        return b2_;
+        }
+    }
+
+    void moveToT2(Entry& entry) {
+        listOf(entry.where).remove(entry.node);
+        entry.where = Where::T2;
+        t2_.pushBack(entry.node);
+    }
+
+    // 完全不在四个链表中的新 key
+    void addNewNode(Key key, Value value) {
+        size_t l1 = t1_.size() + b1_.size();
+        size_t total = l1 + t2_.size() + b2_.size();
+
+        if (l1 >= capacity_) {
+            if (t1_.size() < capacity_) {
+                dropGhost(b1_);
+                replace(false);
+            } else {
+                // B1 为空，T1 已占满容量：直接丢弃 T1 的最久未使用节点
+                NodePtr node = t1_.popFront();
+                notifier_.record(node->getKey(), node->getValue(), RemovalCause::Evicted);
+                nodeMap_.erase(node->getKey());
+                stats_.recordEviction();
+            }
+        } else if (total >= capacity_) {
+            if (total >= 2 * capacity_) {
+                dropGhost(b2_);
+            }
+            replace(false);
+        }
+
+        NodePtr node = std::make_shared<LruNode<Key, Value>>(key, std::move(value));
+        t1_.pushBack(node);
+        nodeMap_.emplace(std::move(key), Entry{std::move(node), Where::T1});
+    }
+
+    // 常驻数据已满时，根据 p_ 从 T1 或 T2 淘汰一个节点到对应的幽灵链表
+    void replace(bool hitInB2) {
+        if (t1_.size() + t2_.size() < capacity_) return;
+
+        if (t1_.size() > 0 && (t1_.size() > p_ || (hitInB2 && t1_.size() == p_))) {
+            demote(t1_, b1_, Where::B1);
+        } else if (t2_.size() > 0) {
+            demote(t2_, b2_, Where::B2);
+        } else {
+            demote(t1_, b1_, Where::B1);
+        }
+    }
+
+    void demote(LruList<Key, Value>& from, LruList<Key, Value>& to, Where where) {
+        NodePtr node = from.popFront();
+        if (!node) return;
+        stats_.recordEviction();
+        notifier_.record(node->getKey(), node->getValue(), RemovalCause::Evicted);
+        node->setValue(Value()); // 幽灵节点不再持有值
+        to.pushBack(node);
+        nodeMap_[node->getKey()].where = where;
+    }
+
+    void dropGhost(LruList<Key, Value>& ghost) {
+        NodePtr node = ghost.popFront();
+        if (node) nodeMap_.erase(node->getKey());
+    }
+
+private:
+    size_t capacity_;
+    size_t p_;          // T1 的目标大小
+    std::mutex mutex_;
+    LruList<Key, Value> t1_;
+    LruList<Key, Value> t2_;
+    LruList<Key, Value> b1_;
+    LruList<Key, Value> b2_;
+    std::unordered_map<Key, Entry, KeyHash<Key>, KeyEqual> nodeMap_;
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
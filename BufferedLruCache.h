@@ -0,0 +1,328 @@
+#pragma once
+
+/*
+BufferedLruCache：读路径不拿全局锁的 LRU 缓存。
+
+- 索引按 key 的哈希分成 segmentNum_ 个段，每段一个 shared_mutex，get 只拿段的读锁。
+- get 命中后并不立即移动链表节点，而是把节点指针放进该段的环形缓冲区（read buffer），
+  之后在持有链表锁 listMutex_ 时批量回放（drain），把这些节点移到最近访问的位置。
+- 缓冲区满时直接丢弃这次提升，不阻塞读者；因此 LRU 顺序是近似的。
+
+内存安全：节点只会在持有 listMutex_ 和所在段写锁时被释放，
+释放前会先把该段缓冲区完全回放，因此缓冲区里不会留下悬空指针。
+
+链表头部（head_->next_）表示最久未使用的节点，尾部（tail_->prev_）表示最近访问的节点。
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "KICachePolicy.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+template <typename Key, typename Value>
+class BufferedLruCache : public KICachePolicy<Key, Value>
+{
+private:
+    struct Node {
+        Key key_;
+        Value value_;
+        Node* prev_ = nullptr;
+        Node* next_ = nullptr;
+        bool linked_ = false; // 是否还在 LRU 链表中，只在持有 listMutex_ 时读写
+
+        Node() = default;
+        Node(Key key, Value value) : key_(std::move(key)), value_(std::move(value)) {}
+    };
+
+    // 每个段缓冲区的槽位数，必须是 2 的幂
+    static constexpr uint64_t kBufferSize = 32;
+    // 缓冲区中积压到这个数量时，读者尝试回放
+    static constexpr uint64_t kDrainThreshold = kBufferSize / 2;
+
+    // 多生产者、单消费者的环形缓冲区：生产者是 get，消费者是持有 listMutex_ 的线程
+    struct ReadBuffer {
+        alignas(64) std::atomic<uint64_t> writeIndex_{0};
+        alignas(64) std::atomic<uint64_t> readIndex_{0};
+        std::atomic<Node*> slots_[kBufferSize];
+
+        ReadBuffer() {
+            for (auto& slot : slots_) slot.store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    struct Segment {
+        std::shared_mutex mutex_;
+        std::unordered_map<Key, std::unique_ptr<Node>, KeyHash<Key>, KeyEqual> nodeMap_;
+        ReadBuffer buffer_;
+    };
+
+public:
+    // segmentNum 会向上取整为 2 的幂
+    BufferedLruCache(int capacity, int segmentNum = 16)
+    : capacity_(capacity),
+    size_(0)
+    {
+        size_t n = 1;
+        while (n < static_cast<size_t>(segmentNum > 0 ? segmentNum : 1)) n <<= 1;
+        segmentMask_ = n - 1;
+        segments_.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            segments_.emplace_back(std::make_unique<Segment>());
+        }
+        head_.next_ = &tail_;
+        tail_.prev_ = &head_;
+    }
+
+    ~BufferedLruCache() override = default;
+
+    void put(Key key, Value value) override {
+        if (capacity_ <= 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> listLock(listMutex_, stats_);
+        Segment& segment = segmentFor(key);
+
+        {
+            std::unique_lock<std::shared_mutex> segmentLock(segment.mutex_);
+            auto it = segment.nodeMap_.find(key);
+            if (it != segment.nodeMap_.end()) {
+                Node* node = it->second.get();
+                stats_.recordUpdate();
+                notifier_.record(node->key_, node->value_, RemovalCause::Replaced);
+                node->value_ = std::move(value);
+                moveToMostRecent(node);
+                return;
+            }
+        }
+
+        stats_.recordInsert();
+        if (size_ >= capacity_) {
+            evictLeastRecent();
+        }
+
+        auto newNode = std::make_unique<Node>(key, std::move(value));  // 节点和哈希表各存一份 key
+        Node* node = newNode.get();
+        insertNode(node);
+        {
+            std::unique_lock<std::shared_mutex> segmentLock(segment.mutex_);
+            segment.nodeMap_.emplace(std::move(key), std::move(newNode));
+        }
+        ++size_;
+    }
+
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        put(std::move(key), Value(std::forward<Args>(args)...));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    // 异构查找：例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 读路径：只拿段读锁，最近访问顺序的更新被推迟到缓冲区中。
+    // visitor 在段读锁内被调用，拿到的是值的 const 引用，不拷贝
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        Segment& segment = segmentFor(key);
+        bool pushed;
+        {
+            std::shared_lock<std::shared_mutex> segmentLock(segment.mutex_);
+            auto it = findKey(segment.nodeMap_, key);
+            if (it == segment.nodeMap_.end()) {
+                stats_.recordMiss();
+                return false;
+            }
+            stats_.recordHit();
+            visitor(static_cast<const Value&>(it->second->value_));
+            // 必须在持有读锁时入队，保证节点在被释放前一定能被回放
+            pushed = recordAccess(segment.buffer_, it->second.get());
+        }
+
+        // 缓冲区积压较多或已满时，尝试回放；锁被占用就交给持锁者，不等待
+        if (!pushed || pendingCount(segment.buffer_) >= kDrainThreshold) {
+            std::unique_lock<std::mutex> listLock(listMutex_, std::try_to_lock);
+            if (listLock.owns_lock()) {
+                drainBuffer(segment.buffer_);
+            }
+        }
+        return true;
+    }
+
+    void remove(const Key& key) {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> listLock(listMutex_, stats_);
+        Segment& segment = segmentFor(key);
+        std::unique_ptr<Node> removed;
+        {
+            std::unique_lock<std::shared_mutex> segmentLock(segment.mutex_);
+            auto it = segment.nodeMap_.find(key);
+            if (it == segment.nodeMap_.end()) return;
+            // 写锁下没有进行中的入队，把缓冲区清空后再释放节点
+            drainBuffer(segment.buffer_);
+            removeNode(it->second.get());
+            removed = std::move(it->second);
+            segment.nodeMap_.erase(it);
+        }
+        --size_;
+        stats_.recordRemoval();
+        notifier_.record(removed->key_, removed->value_, RemovalCause::Explicit);
+    }
+
+    // 回放所有段的缓冲区，使 LRU 顺序与之前的访问一致
+    void flush() {
+        TimedLockGuard<std::mutex> listLock(listMutex_, stats_);
+        for (auto& segment : segments_) {
+            drainBuffer(segment->buffer_);
+        }
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+    size_t size() {
+        TimedLockGuard<std::mutex> listLock(listMutex_, stats_);
+        return static_cast<size_t>(size_);
+    }
+
+    // 由于缓冲区已满而被丢弃的提升次数
+    uint64_t droppedPromotions() const {
+        return droppedPromotions_.load(std::memory_order_relaxed);
+    }
+
+private:
+    template <typename K>
+    Segment& segmentFor(const K& key) {
+        // 和其他分段结构一样取混合后哈希的高 32 位，整数 key 的恒等哈希不会只落在少数段上
+        uint64_t hash = mixHash(static_cast<uint64_t>(KeyHash<Key>{}(key)));
+        return *segments_[(hash >> 32) & segmentMask_];
+    }
+
+    // 生产者：申请一个槽位并写入节点指针，缓冲区满时返回 false（丢弃这次提升）
+    bool recordAccess(ReadBuffer& buffer, Node* node) {
+        uint64_t tail = buffer.writeIndex_.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t head = buffer.readIndex_.load(std::memory_order_acquire);
+            if (tail - head >= kBufferSize) {
+                droppedPromotions_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (buffer.writeIndex_.compare_exchange_weak(tail, tail + 1,
+                                                         std::memory_order_acq_rel,
+                                                         std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        buffer.slots_[tail & (kBufferSize - 1)].store(node, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t pendingCount(const ReadBuffer& buffer) const {
+        return buffer.writeIndex_.load(std::memory_order_relaxed)
+             - buffer.readIndex_.load(std::memory_order_relaxed);
+    }
+
+    // 消费者：必须持有 listMutex_。遇到尚未写入完成的槽位就停下，下次再继续
+    void drainBuffer(ReadBuffer& buffer) {
+        uint64_t head = buffer.readIndex_.load(std::memory_order_relaxed);
+        uint64_t tail = buffer.writeIndex_.load(std::memory_order_acquire);
+        for (; head < tail; ++head) {
+            Node* node = buffer.slots_[head & (kBufferSize - 1)].exchange(nullptr, std::memory_order_acquire);
+            if (!node) break;
+            if (node->linked_) moveToMostRecent(node);
+        }
+        buffer.readIndex_.store(head, std::memory_order_release);
+    }
+
+    // 淘汰最久未使用的节点，调用者持有 listMutex_
+    void evictLeastRecent() {
+        std::unique_ptr<Node> evicted;
+        while (!evicted) {
+            Node* victim = head_.next_;
+            if (victim == &tail_) return;
+
+            Segment& segment = segmentFor(victim->key_);
+            std::unique_lock<std::shared_mutex> segmentLock(segment.mutex_);
+            drainBuffer(segment.buffer_);
+            // 回放后被提升了，说明它最近被访问过，重新挑选
+            if (victim != head_.next_) continue;
+
+            removeNode(victim);
+            auto it = segment.nodeMap_.find(victim->key_);
+            evicted = std::move(it->second);
+            segment.nodeMap_.erase(it);
+        }
+        --size_;
+        stats_.recordEviction();
+        notifier_.record(evicted->key_, evicted->value_, RemovalCause::Evicted);
+    }
+
+    void moveToMostRecent(Node* node) {
+        removeNode(node);
+        insertNode(node);
+    }
+
+    void removeNode(Node* node) {
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        node->linked_ = false;
+    }
+
+    void insertNode(Node* node) {
+        node->next_ = &tail_;
+        node->prev_ = tail_.prev_;
+        tail_.prev_->next_ = node;
+        tail_.prev_ = node;
+        node->linked_ = true;
+    }
+
+private:
+    int capacity_;
+    int size_;                   // 当前节点数，只在持有 listMutex_ 时修改
+    std::mutex listMutex_;       // 保护 LRU 链表
+    Node head_;
+    Node tail_;
+    size_t segmentMask_;
+    std::vector<std::unique_ptr<Segment>> segments_;
+    std::atomic<uint64_t> droppedPromotions_{0};
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
@@ -0,0 +1,270 @@
+#pragma once
+
+/*
+CacheStats：缓存的运行统计（可选）。
+
+编译时定义 KAMACACHE_ENABLE_STATS 才会真正计数，否则 CacheStats 是一个空类，
+所有 record* 都是空的内联函数，TimedLockGuard 就是普通的加锁/解锁，也不会读时钟，
+开销为零。两种情况下 stats() 接口都存在，关闭时返回全零的快照。
+
+这个开关会改变 CacheStats 以及所有持有它的缓存类的定义，应该在整个项目里统一设置。
+依赖它的头文件都把内容放在内联命名空间 KAMACACHE_STATS_ABI（stats_on / stats_off）里：
+设置不同的翻译单元看到的是不同的类型，不会悄悄违反 ODR；它们之间传递缓存对象时链接失败。
+
+- 计数器：命中、未命中、新插入、更新、淘汰、删除、TTL 过期、超重拒绝；
+- 直方图：get/put 耗时和等锁耗时，按 2 的幂分桶（第 i 个桶是 [2^(i-1), 2^i) 纳秒）；
+- 条带化：计数器分成 kStatsStripes 份，每份独占缓存行，线程按自己的编号选择一份，
+  不同线程的计数不会在同一个缓存行上来回争抢。snapshot() 把所有条带加起来。
+*/
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifdef KAMACACHE_ENABLE_STATS
+#define KAMACACHE_STATS_ABI stats_on
+#else
+#define KAMACACHE_STATS_ABI stats_off
+#endif
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+#ifdef KAMACACHE_ENABLE_STATS
+constexpr bool kStatsEnabled = true;
+#else
+constexpr bool kStatsEnabled = false;
+#endif
+
+constexpr size_t kLatencyBuckets = 40;  // 最大桶约 2^39 纳秒（约 9 分钟）
+constexpr size_t kStatsStripes = 16;    // 必须是 2 的幂
+
+// 直方图快照
+struct LatencyHistogram {
+    std::array<uint64_t, kLatencyBuckets> buckets{};
+
+    // 纳秒数落在哪个桶
+    static size_t bucketOf(uint64_t ns) {
+        size_t bucket = 0;
+        while (ns != 0 && bucket + 1 < kLatencyBuckets) {
+            ns >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    // 桶的上界（纳秒）
+    static uint64_t bucketUpperBound(size_t bucket) {
+        return bucket == 0 ? 0 : (uint64_t(1) << bucket) - 1;
+    }
+
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (uint64_t n : buckets) total += n;
+        return total;
+    }
+
+    // 近似分位数：返回第 p 分位所在桶的上界（纳秒），p 取 [0, 1]
+    uint64_t percentile(double p) const {
+        uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kLatencyBuckets; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) return bucketUpperBound(i);
+        }
+        return bucketUpperBound(kLatencyBuckets - 1);
+    }
+
+    LatencyHistogram& operator+=(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kLatencyBuckets; ++i) buckets[i] += other.buckets[i];
+        return *this;
+    }
+};
+
+// 某一时刻的统计快照；计数器单调递增，定期抓取时可以对两次快照做差
+struct CacheStatsSnapshot {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t inserts = 0;    // 新 key 写入
+    uint64_t updates = 0;    // 已有 key 被覆盖
+    uint64_t evictions = 0;  // 因容量不足被淘汰
+    uint64_t removals = 0;   // 被 remove 显式删除
+    uint64_t expirations = 0; // TTL 到期被回收
+    uint64_t rejections = 0;  // 单个条目的权重超过总容量，拒绝写入
+    LatencyHistogram getLatency;
+    LatencyHistogram putLatency;
+    LatencyHistogram lockWait;
+
+    double hitRatio() const {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+    }
+
+    // 合并多个分片的统计
+    CacheStatsSnapshot& operator+=(const CacheStatsSnapshot& other) {
+        hits += other.hits;
+        misses += other.misses;
+        inserts += other.inserts;
+        updates += other.updates;
+        evictions += other.evictions;
+        removals += other.removals;
+        expirations += other.expirations;
+        rejections += other.rejections;
+        getLatency += other.getLatency;
+        putLatency += other.putLatency;
+        lockWait += other.lockWait;
+        return *this;
+    }
+};
+
+// 当前线程使用的条带编号：线程第一次记录时按顺序分配
+inline size_t statsStripe() {
+    static std::atomic<size_t> nextStripe{0};
+    thread_local size_t stripe = nextStripe.fetch_add(1, std::memory_order_relaxed) & (kStatsStripes - 1);
+    return stripe;
+}
+
+inline uint64_t statsNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#ifdef KAMACACHE_ENABLE_STATS
+
+class CacheStats
+{
+public:
+    enum Counter { Hits, Misses, Inserts, Updates, Evictions, Removals, Expirations, Rejections, CounterNum };
+    enum Histogram { GetLatency, PutLatency, LockWait, HistogramNum };
+
+    CacheStats() : stripes_(new Stripe[kStatsStripes]) {}
+
+    void recordHit(uint64_t n = 1)       { add(Hits, n); }
+    void recordMiss(uint64_t n = 1)      { add(Misses, n); }
+    void recordInsert()                  { add(Inserts, 1); }
+    void recordUpdate()                  { add(Updates, 1); }
+    void recordEviction()                { add(Evictions, 1); }
+    void recordRemoval()                 { add(Removals, 1); }
+    void recordExpiration()              { add(Expirations, 1); }
+    void recordRejection()               { add(Rejections, 1); }
+    void recordLatency(Histogram histogram, uint64_t ns) {
+        stripes_[statsStripe()].histograms_[histogram][LatencyHistogram::bucketOf(ns)]
+            .fetch_add(1, std::memory_order_relaxed);
+    }
+
+    CacheStatsSnapshot snapshot() const {
+        CacheStatsSnapshot snap;
+        for (size_t s = 0; s < kStatsStripes; ++s) {
+            const Stripe& stripe = stripes_[s];
+            snap.hits += stripe.counters_[Hits].load(std::memory_order_relaxed);
+            snap.misses += stripe.counters_[Misses].load(std::memory_order_relaxed);
+            snap.inserts += stripe.counters_[Inserts].load(std::memory_order_relaxed);
+            snap.updates += stripe.counters_[Updates].load(std::memory_order_relaxed);
+            snap.evictions += stripe.counters_[Evictions].load(std::memory_order_relaxed);
+            snap.removals += stripe.counters_[Removals].load(std::memory_order_relaxed);
+            snap.expirations += stripe.counters_[Expirations].load(std::memory_order_relaxed);
+            snap.rejections += stripe.counters_[Rejections].load(std::memory_order_relaxed);
+            for (size_t i = 0; i < kLatencyBuckets; ++i) {
+                snap.getLatency.buckets[i] += stripe.histograms_[GetLatency][i].load(std::memory_order_relaxed);
+                snap.putLatency.buckets[i] += stripe.histograms_[PutLatency][i].load(std::memory_order_relaxed);
+                snap.lockWait.buckets[i] += stripe.histograms_[LockWait][i].load(std::memory_order_relaxed);
+            }
+        }
+        return snap;
+    }
+
+private:
+    void add(Counter counter, uint64_t n) {
+        stripes_[statsStripe()].counters_[counter].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> counters_[CounterNum] = {};
+        std::atomic<uint64_t> histograms_[HistogramNum][kLatencyBuckets] = {};
+    };
+
+    std::unique_ptr<Stripe[]> stripes_;
+};
+
+#else
+
+// 关闭统计时的空实现：调用点全部内联为空
+class CacheStats
+{
+public:
+    enum Histogram { GetLatency, PutLatency, LockWait, HistogramNum };
+
+    void recordHit(uint64_t = 1) {}
+    void recordMiss(uint64_t = 1) {}
+    void recordInsert() {}
+    void recordUpdate() {}
+    void recordEviction() {}
+    void recordRemoval() {}
+    void recordExpiration() {}
+    void recordRejection() {}
+    void recordLatency(Histogram, uint64_t) {}
+    CacheStatsSnapshot snapshot() const { return CacheStatsSnapshot(); }
+};
+
+#endif
+
+// 作用域计时：构造时读时钟，析构时把耗时记入指定直方图；关闭统计时什么都不做
+class ScopedLatency
+{
+public:
+#ifdef KAMACACHE_ENABLE_STATS
+    ScopedLatency(CacheStats& stats, CacheStats::Histogram histogram)
+    : stats_(stats), histogram_(histogram), start_(statsNowNs()) {}
+    ~ScopedLatency() { stats_.recordLatency(histogram_, statsNowNs() - start_); }
+
+private:
+    CacheStats& stats_;
+    CacheStats::Histogram histogram_;
+    uint64_t start_;
+#else
+    ScopedLatency(CacheStats&, CacheStats::Histogram) {}
+#endif
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+};
+
+// 代替 std::lock_guard：开启统计时记录等锁耗时
+template <typename Mutex>
+class TimedLockGuard
+{
+public:
+    TimedLockGuard(Mutex& mutex, CacheStats& stats) : mutex_(mutex) {
+#ifdef KAMACACHE_ENABLE_STATS
+        if (mutex_.try_lock()) {
+            // 没有竞争：不读时钟，记为 0
+            stats.recordLatency(CacheStats::LockWait, 0);
+            return;
+        }
+        uint64_t start = statsNowNs();
+        mutex_.lock();
+        stats.recordLatency(CacheStats::LockWait, statsNowNs() - start);
+#else
+        (void)stats;
+        mutex_.lock();
+#endif
+    }
+
+    ~TimedLockGuard() { mutex_.unlock(); }
+
+    TimedLockGuard(const TimedLockGuard&) = delete;
+    TimedLockGuard& operator=(const TimedLockGuard&) = delete;
+
+private:
+    Mutex& mutex_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
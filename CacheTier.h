@@ -0,0 +1,34 @@
+#pragma once
+
+/*
+CacheTier：内存缓存之下的二级缓存接口。
+
+挂上二级缓存之后（LruCache / LfuCache 的 setSecondTier）：
+- 条目因为容量被淘汰时交给 offer，而不是直接丢掉（带 TTL 的条目不下沉，避免过期后还能从二级缓存读到）；
+- 内存未命中时，在释放缓存锁之后调用 take，命中的条目从二级缓存取出并放回内存；
+- 写入和 remove 时调用 erase，二级缓存里的旧值一起作废（新值可能不经过 offer 就离开内存，例如 TTL 到期）。
+
+offer 在缓存锁内调用，实现不能做 IO，也不能等待（放不下时直接丢弃）；
+take 在锁外调用，可以读磁盘。
+*/
+
+namespace KamaCache
+{
+
+template <typename Key, typename Value>
+class CacheTier
+{
+public:
+    virtual ~CacheTier() = default;
+
+    // 接收一个被淘汰的条目，不阻塞
+    virtual void offer(const Key& key, Value value) = 0;
+
+    // 取出 key 对应的条目，取出后二级缓存中不再保留；不存在时返回 false
+    virtual bool take(const Key& key, Value& value) = 0;
+
+    // 作废 key 在二级缓存中的条目
+    virtual void erase(const Key& key) = 0;
+};
+
+} // namespace KamaCache
@@ -0,0 +1,574 @@
+#pragma once
+
+/*
+FileTier：基于本地文件的二级缓存（CacheTier 的实现），日志结构存储。
+
+- 写入：offer 只把条目放进内存中的待写队列（有上限，满了直接丢弃，从不等待）；
+  后台写线程持锁把一批值移出队列，解锁后编码并顺序追加到当前段文件的末尾，写完再把 key 的位置登记到索引。
+  写线程每次持锁只做 O(kBatch) 次哈希表操作，不在锁内编码、读写文件，前台的 offer/erase 不会等在磁盘后面；
+- 索引：内存中的 FlatHashMap，每个 key 只记 (段号, 偏移, 长度)，值都在磁盘上；
+- 读取：take 先查待写队列，再查索引，在锁外用 pread 读出记录。取出即删除（条目回到内存层）；
+- 回收：被取出、被覆盖或被作废的记录只在段上记为无效。已封存的段有效数据比例低于 compactBelow 时，
+  后台线程把其中仍然有效的记录搬到当前段，然后删除整个段文件；
+  所有段的总大小超过 maxBytes 时，优先压缩最稀疏的段，没有可压缩的段就丢弃最旧的段（其中的条目随之失效）。
+
+段文件放在 directory 下新建的临时子目录中，对象析构时全部删除：二级缓存只是内存缓存的延伸，重启后不保留。
+
+记录格式：长度(u32) | key | value，key/value 用 Serializer 编码（见 Snapshot.h）。
+*/
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "CacheTier.h"
+#include "FlatHashMap.h"
+#include "Snapshot.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+struct FileTierOptions {
+    std::string directory = "/tmp";  // 段文件所在目录（必须已存在）
+    size_t segmentBytes = 64 << 20;  // 单个段文件的大小上限
+    size_t maxBytes = 1ull << 30;    // 所有段文件的总大小上限
+    size_t queueCapacity = 4096;     // 待写队列的条目上限，满了直接丢弃
+    double compactBelow = 0.5;       // 已封存段的有效数据比例低于它时压缩
+};
+
+struct FileTierStats {
+    uint64_t written = 0;     // 写入磁盘的条目数
+    uint64_t dropped = 0;     // 待写队列满（或写盘失败）被丢弃的条目数
+    uint64_t hits = 0;        // take 命中
+    uint64_t misses = 0;      // take 未命中
+    uint64_t compactions = 0; // 压缩的段数
+    uint64_t evicted = 0;     // 因总大小超限随段一起丢弃的条目数
+    size_t entries = 0;       // 磁盘上的有效条目数
+    size_t pending = 0;       // 待写队列中的条目数
+    size_t diskBytes = 0;     // 所有段文件的总大小
+};
+
+template <typename Key, typename Value>
+class FileTier : public CacheTier<Key, Value>
+{
+public:
+    explicit FileTier(FileTierOptions options = FileTierOptions())
+    : options_(std::move(options)),
+      ok_(false),
+      stop_(false),
+      idle_(true),
+      seq_(0),
+      diskBytes_(0),
+      nextSegmentId_(0),
+      activeOffset_(0)
+    {
+        options_.segmentBytes = std::max<size_t>(options_.segmentBytes, 4096);
+        options_.maxBytes = std::max(options_.maxBytes, options_.segmentBytes * 2);
+        std::string pattern = options_.directory + "/kamacache-tier-XXXXXX";
+        std::vector<char> path(pattern.begin(), pattern.end());
+        path.push_back('\0');
+        if (!::mkdtemp(path.data())) return;
+        dir_ = path.data();
+        active_ = openSegment();
+        if (!active_) return;
+        ok_ = true;
+        batchValues_.reserve(kBatch); // 写盘期间待写队列里的条目指向这里的值，不能重新分配
+        writer_ = std::thread([this]() { run(); });
+    }
+
+    ~FileTier() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wakeup_.notify_one();
+        if (writer_.joinable()) writer_.join();
+        active_.reset();
+        segments_.clear(); // 段析构时删除文件
+        if (!dir_.empty()) ::rmdir(dir_.c_str());
+    }
+
+    FileTier(const FileTier&) = delete;
+    FileTier& operator=(const FileTier&) = delete;
+
+    // 段文件目录创建失败时为 false，此时 offer 全部丢弃
+    bool ok() const { return ok_; }
+
+    void offer(const Key& key, Value value) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pending_.find(key);
+        if (it != pending_.end()) {
+            // 新值替换还没写盘的旧值；换一个序号，写线程手里的旧值写完后不会覆盖它
+            it->second.value = std::move(value);
+            it->second.writing = nullptr;
+            it->second.seq = ++seq_;
+            order_.emplace_back(key, it->second.seq);
+            if (order_.size() == 1) wakeup_.notify_one();
+            return;
+        }
+        if (!ok_ || pending_.size() >= options_.queueCapacity) {
+            // 丢弃新值时磁盘上的旧版本也要作废，否则之后会读到旧数据
+            eraseIndexed(key);
+            ++dropped_;
+            return;
+        }
+        pending_.emplace(key, Pending{std::move(value), ++seq_, nullptr});
+        order_.emplace_back(key, seq_);
+        // 写线程只在 order_ 为空时等待：队列从空变为非空时唤醒它
+        if (order_.size() == 1) wakeup_.notify_one();
+    }
+
+    bool take(const Key& key, Value& value) override {
+        std::shared_ptr<Segment> segment;
+        Location location;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto pending = pending_.find(key);
+            if (pending != pending_.end()) {
+                // 正在写盘的值归写线程所有，它只读不改，这里拷贝一份
+                if (pending->second.writing) {
+                    value = *pending->second.writing;
+                } else {
+                    value = std::move(pending->second.value);
+                }
+                pending_.erase(pending);
+                eraseIndexed(key); // 可能还有更旧的版本在磁盘上
+                ++hits_;
+                return true;
+            }
+            auto it = index_.find(key);
+            if (it == index_.end()) {
+                ++misses_;
+                return false;
+            }
+            location = it->second;
+            auto found = segments_.find(location.segment);
+            if (found == segments_.end()) {
+                // 所在的段已经丢弃（见 evictSegment），这是一条失效的索引
+                index_.erase(it);
+                ++misses_;
+                return false;
+            }
+            segment = found->second;
+            segment->liveBytes -= location.size;
+            index_.erase(it);
+            ++hits_;
+        }
+
+        // 锁外读盘：持有段的 shared_ptr，即使段在此期间被压缩删除，文件也要等这里读完才关闭
+        buffer_t record(location.size);
+        if (!readAt(segment->fd, record.data(), record.size(), location.offset)) return false;
+        ByteReader in(record.data(), record.size());
+        Key storedKey;
+        return Serializer<Key>::read(in, storedKey) && Serializer<Value>::read(in, value);
+    }
+
+    void erase(const Key& key) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.erase(key);
+        eraseIndexed(key);
+    }
+
+    // 等待待写队列清空（测试和基准测试用）
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idleCv_.wait(lock, [this]() { return order_.empty() && idle_; });
+    }
+
+    FileTierStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FileTierStats stats;
+        stats.written = written_;
+        stats.dropped = dropped_;
+        stats.hits = hits_;
+        stats.misses = misses_;
+        stats.compactions = compactions_;
+        stats.evicted = evicted_;
+        stats.entries = index_.size();
+        stats.pending = pending_.size();
+        stats.diskBytes = diskBytes_;
+        return stats;
+    }
+
+private:
+    using buffer_t = std::vector<char>;
+
+    // 段文件：最后一个持有者释放时关闭并删除
+    struct Segment {
+        uint32_t id;
+        int fd;
+        std::string path;
+        size_t bytes = 0;     // 已写入的字节数（只在持锁时修改）
+        size_t liveBytes = 0; // 其中仍被索引引用的记录字节数
+
+        Segment(uint32_t segmentId, int file, std::string filePath)
+        : id(segmentId), fd(file), path(std::move(filePath)) {}
+
+        ~Segment() {
+            ::close(fd);
+            ::unlink(path.c_str());
+        }
+    };
+
+    struct Location {
+        uint32_t segment;
+        uint32_t size;   // 记录（key + value）的长度，不含长度前缀
+        uint64_t offset; // 记录在段文件中的偏移，不含长度前缀
+    };
+
+    struct Pending {
+        Value value;
+        uint64_t seq;
+        const Value* writing; // 写线程正在写这一版时指向 batchValues_ 中的值，value 已被移走
+    };
+
+    // 一批要写盘的记录：编码结果在 encoded_ 中的区间，以及写入后的位置
+    struct Record {
+        Key key;
+        uint64_t seq;
+        size_t begin;
+        uint32_t size;
+        Location location;
+        Location from;     // 压缩时记录原来的位置
+        bool live = true;  // 压缩时是否还被索引引用
+    };
+
+    static constexpr size_t kBatch = 256;
+    static constexpr uint32_t kHeader = sizeof(uint32_t);
+
+    // ---------------- 写线程 ----------------
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            if (order_.empty()) {
+                idle_ = true;
+                idleCv_.notify_all();
+                wakeup_.wait(lock, [this]() { return stop_ || !order_.empty(); });
+                continue;
+            }
+            idle_ = false;
+
+            // 持锁只把一批值移出待写队列，不拷贝、不编码；take 在写盘期间仍能通过 writing 读到它们
+            records_.clear();
+            batchValues_.clear();
+            while (!order_.empty() && records_.size() < kBatch) {
+                std::pair<Key, uint64_t> item = std::move(order_.front());
+                order_.pop_front();
+                auto it = pending_.find(item.first);
+                if (it == pending_.end() || it->second.seq != item.second) continue; // 已被取走或替换
+                batchValues_.push_back(std::move(it->second.value));
+                it->second.writing = &batchValues_.back();
+                records_.push_back(Record{std::move(item.first), item.second, 0, 0, Location{}, Location{}});
+            }
+            lock.unlock();
+
+            encoded_.clear();
+            ByteWriter out(encoded_);
+            for (size_t i = 0; i < records_.size(); ++i) {
+                Record& record = records_[i];
+                record.begin = encoded_.size();
+                Serializer<Key>::write(out, record.key);
+                Serializer<Value>::write(out, batchValues_[i]);
+                record.size = static_cast<uint32_t>(encoded_.size() - record.begin);
+            }
+            bool written = appendRecords();
+            lock.lock();
+
+            // 序号一致的条目这时仍指向 batchValues_，在这里全部移出待写队列，下一批之前不再有人引用它们
+            for (Record& record : records_) {
+                auto it = pending_.find(record.key);
+                if (it == pending_.end() || it->second.seq != record.seq) continue; // 写盘期间被取走或替换：这条记录无效
+                pending_.erase(it);
+                if (!written) {
+                    ++dropped_;
+                    eraseIndexed(record.key);
+                    continue;
+                }
+                eraseIndexed(record.key);
+                segments_[record.location.segment]->liveBytes += record.size;
+                index_.emplace(record.key, record.location);
+                ++written_;
+            }
+            lock.unlock();
+            maintain();
+            lock.lock();
+        }
+    }
+
+    // 把 records_ 顺序追加到当前段，段写满时换新段。只在写线程、不持锁时调用
+    bool appendRecords() {
+        out_.clear();
+        for (Record& record : records_) {
+            if (activeOffset_ + out_.size() + kHeader + record.size > options_.segmentBytes &&
+                activeOffset_ + out_.size() > 0) {
+                if (!flushActive() || !rollSegment()) return false;
+            }
+            uint32_t size = record.size;
+            const char* header = reinterpret_cast<const char*>(&size);
+            out_.insert(out_.end(), header, header + kHeader);
+            record.location = Location{active_->id, record.size, activeOffset_ + out_.size()};
+            out_.insert(out_.end(), encoded_.begin() + record.begin, encoded_.begin() + record.begin + record.size);
+        }
+        return flushActive();
+    }
+
+    bool flushActive() {
+        if (out_.empty()) return true;
+        bool ok = writeAt(active_->fd, out_.data(), out_.size(), activeOffset_);
+        if (ok) {
+            activeOffset_ += out_.size();
+            std::lock_guard<std::mutex> lock(mutex_);
+            diskBytes_ += out_.size();
+            active_->bytes = activeOffset_;
+        }
+        out_.clear();
+        return ok;
+    }
+
+    // 封存当前段，打开下一个段
+    bool rollSegment() {
+        std::shared_ptr<Segment> next = openSegment();
+        if (!next) return false;
+        active_ = std::move(next);
+        activeOffset_ = 0;
+        return true;
+    }
+
+    // 新建一个段文件并登记到段表；只在构造函数和写线程中调用
+    std::shared_ptr<Segment> openSegment() {
+        char name[32];
+        uint32_t id = nextSegmentId_++;
+        std::snprintf(name, sizeof(name), "/%08u.seg", id);
+        std::string path = dir_ + name;
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) return nullptr;
+        auto segment = std::make_shared<Segment>(id, fd, path);
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments_[id] = segment;
+        return segment;
+    }
+
+    // ---------------- 空间回收 ----------------
+
+    // 删除空段；压缩稀疏的段；总大小超限时压缩或丢弃最旧的段。只在写线程调用
+    void maintain() {
+        for (;;) {
+            std::shared_ptr<Segment> target;
+            bool drop = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Segment* sparsest = nullptr;
+                for (auto& entry : segments_) {
+                    Segment* segment = entry.second.get();
+                    if (segment == active_.get()) continue;
+                    if (segment->liveBytes == 0) {
+                        sparsest = segment;
+                        break;
+                    }
+                    if (!sparsest || liveRatio(segment) < liveRatio(sparsest)) sparsest = segment;
+                }
+                if (!sparsest) return;
+                if (sparsest->liveBytes == 0) {
+                    dropSegmentLocked(sparsest->id);
+                    continue;
+                }
+                if (liveRatio(sparsest) < options_.compactBelow) {
+                    target = segments_[sparsest->id];
+                } else if (diskBytes_ > options_.maxBytes) {
+                    target = segments_.begin()->second; // 最旧的已封存段
+                    drop = true;
+                } else {
+                    return;
+                }
+            }
+            if (!(drop ? evictSegment(target) : compactSegment(target))) return;
+        }
+    }
+
+    static double liveRatio(const Segment* segment) {
+        return segment->bytes == 0 ? 1.0 : static_cast<double>(segment->liveBytes) / static_cast<double>(segment->bytes);
+    }
+
+    // 读出整个段并逐条解析；handle(key, 位置) 在不持锁时调用
+    template <typename Handle>
+    bool scanSegment(const std::shared_ptr<Segment>& segment, Handle&& handle) {
+        size_t bytes;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bytes = segment->bytes;
+        }
+        scan_.resize(bytes);
+        if (!readAt(segment->fd, scan_.data(), bytes, 0)) return false;
+        size_t pos = 0;
+        while (pos + kHeader <= bytes) {
+            uint32_t size;
+            std::memcpy(&size, scan_.data() + pos, kHeader);
+            pos += kHeader;
+            if (size > bytes - pos) return false;
+            ByteReader in(scan_.data() + pos, size);
+            Key key;
+            if (!Serializer<Key>::read(in, key)) return false;
+            handle(std::move(key), Location{segment->id, size, pos});
+            pos += size;
+        }
+        return true;
+    }
+
+    // 把段中仍然有效的记录搬到当前段，然后删除这个段
+    bool compactSegment(const std::shared_ptr<Segment>& segment) {
+        records_.clear();
+        encoded_.clear();
+        bool ok = scanSegment(segment, [this](Key key, Location location) {
+            size_t begin = encoded_.size();
+            encoded_.insert(encoded_.end(), scan_.begin() + location.offset,
+                            scan_.begin() + location.offset + location.size);
+            records_.push_back(Record{std::move(key), 0, begin, location.size, Location{}, location});
+        });
+        if (!ok) return false;
+
+        // 只搬还被索引引用的记录
+        forEachRecordLocked([this](Record& record) { record.live = isIndexedAt(record.key, record.from); });
+        records_.erase(std::remove_if(records_.begin(), records_.end(), [](const Record& record) { return !record.live; }),
+                       records_.end());
+        if (!appendRecords()) return false;
+
+        forEachRecordLocked([this](Record& record) {
+            // 搬运期间被取走或替换的记录不再更新
+            if (!isIndexedAt(record.key, record.from)) return;
+            index_.find(record.key)->second = record.location;
+            segments_[record.location.segment]->liveBytes += record.size;
+        });
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropSegmentLocked(segment->id);
+        ++compactions_;
+        return true;
+    }
+
+    // 整段丢弃：其中仍然有效的条目从索引中删除。
+    // 段文件读不出来时不去索引里逐个查找，直接丢弃段：指向它的索引项成为失效项，被 take、erase 或新的写入碰到时清理
+    bool evictSegment(const std::shared_ptr<Segment>& segment) {
+        records_.clear();
+        bool ok = scanSegment(segment, [this](Key key, Location location) {
+            records_.push_back(Record{std::move(key), 0, 0, location.size, Location{}, location});
+        });
+        if (ok) {
+            forEachRecordLocked([this](Record& record) {
+                if (!isIndexedAt(record.key, record.from)) return;
+                index_.erase(index_.find(record.key));
+                ++evicted_;
+            });
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropSegmentLocked(segment->id);
+        return true;
+    }
+
+    // 分段持锁处理 records_：每次持锁最多处理 kBatch 条，前台的 offer/erase 不会等一整个段
+    template <typename Fn>
+    void forEachRecordLocked(Fn&& fn) {
+        for (size_t begin = 0; begin < records_.size(); begin += kBatch) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t end = std::min(records_.size(), begin + kBatch);
+            for (size_t i = begin; i < end; ++i) fn(records_[i]);
+        }
+    }
+
+    // ---------------- 持锁调用的辅助函数 ----------------
+
+    bool isIndexedAt(const Key& key, const Location& location) {
+        auto it = index_.find(key);
+        return it != index_.end() && it->second.segment == location.segment && it->second.offset == location.offset;
+    }
+
+    void eraseIndexed(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) return;
+        auto segment = segments_.find(it->second.segment);
+        if (segment != segments_.end()) segment->second->liveBytes -= it->second.size;
+        index_.erase(it);
+    }
+
+    void dropSegmentLocked(uint32_t id) {
+        auto it = segments_.find(id);
+        diskBytes_ -= it->second->bytes;
+        segments_.erase(it);
+    }
+
+    // ---------------- 文件读写 ----------------
+
+    static bool readAt(int fd, char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = ::pread(fd, data, size, static_cast<off_t>(offset));
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    static bool writeAt(int fd, const char* data, size_t size, uint64_t offset) {
+        while (size > 0) {
+            ssize_t n = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+private:
+    FileTierOptions options_;
+    std::string dir_;
+    bool ok_;
+
+    std::mutex mutex_; // 保护下面的队列、索引、段表和计数
+    std::condition_variable wakeup_;
+    std::condition_variable idleCv_;
+    bool stop_;
+    bool idle_;
+    FlatHashMap<Key, Pending, KeyHash<Key>, KeyEqual> pending_;
+    std::deque<std::pair<Key, uint64_t>> order_; // 写盘顺序；序号和 pending_ 中不一致的是过时记录
+    uint64_t seq_;
+    FlatHashMap<Key, Location, KeyHash<Key>, KeyEqual> index_;
+    std::map<uint32_t, std::shared_ptr<Segment>> segments_; // 按段号排序，第一个最旧
+    size_t diskBytes_;
+    uint64_t written_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t compactions_ = 0;
+    uint64_t evicted_ = 0;
+
+    // 以下只由写线程使用
+    uint32_t nextSegmentId_;
+    std::shared_ptr<Segment> active_;
+    uint64_t activeOffset_;
+    std::vector<Record> records_;
+    std::vector<Value> batchValues_; // 正在写盘的一批值，和 records_ 一一对应（只在持锁时增删）
+    buffer_t encoded_;
+    buffer_t out_;
+    buffer_t scan_;
+    std::thread writer_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
@@ -0,0 +1,338 @@
+#pragma once
+
+/*
+FlatHashMap：缓存核心使用的开放寻址哈希表，代替 std::unordered_map 作为 key -> 节点句柄的索引。
+
+- 所有 (key, value) 直接存放在一个连续的槽位数组里，没有单独分配的链表节点：
+  一次查找只需要访问控制字节和槽位，而不是 桶数组 -> 链表节点 -> 缓存节点 三次依赖的内存访问；
+- 每个槽位有一个控制字节：最高位为 1 表示空槽，否则低 7 位是哈希值的 7 位指纹（H2）。
+  查找时一次比较 16 个控制字节（有 SSE2 时用 SIMD，否则逐字节），只有指纹相同的槽位才比较 key；
+- 线性探测：key 从哈希值决定的起始位置（H1）开始放在第一个空槽。
+  删除时把后面的元素向前移（backward shift），不留墓碑，淘汰频繁时探测长度不会越来越长；
+- 控制字节数组末尾多复制 16 个字节（镜像开头的 16 个），分组读取跨过数组末尾时不需要特殊处理。
+
+注意：插入可能扩容，删除会移动其他元素，两者都会使迭代器和元素的引用失效。
+缓存节点本身仍然单独分配，保存的只是节点指针，所以节点指针不受影响。
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "KICachePolicy.h"
+
+namespace KamaCache
+{
+
+template <typename Key, typename Value, typename Hash = KeyHash<Key>, typename Equal = KeyEqual>
+class FlatHashMap
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    // first 不能在表外被修改，否则位置和哈希值对不上
+    using value_type = std::pair<Key, Value>;
+
+    class iterator
+    {
+    public:
+        iterator() : map_(nullptr), index_(0) {}
+
+        value_type& operator*() const { return map_->slots_[index_]; }
+        value_type* operator->() const { return &map_->slots_[index_]; }
+
+        iterator& operator++() {
+            index_ = map_->nextFull(index_ + 1);
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const iterator& other) const { return index_ != other.index_; }
+
+    private:
+        friend class FlatHashMap;
+        iterator(FlatHashMap* map, size_t index) : map_(map), index_(index) {}
+
+        FlatHashMap* map_;
+        size_t index_;
+    };
+
+    FlatHashMap() : ctrl_(nullptr), slots_(nullptr), capacity_(0), size_(0), growthLeft_(0) {}
+
+    ~FlatHashMap() {
+        destroyAll();
+        release();
+    }
+
+    FlatHashMap(const FlatHashMap&) = delete;
+    FlatHashMap& operator=(const FlatHashMap&) = delete;
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    // 槽位个数（2 的幂），不是元素个数
+    size_t capacity() const { return capacity_; }
+
+    // 表本身占用的字节数：槽位数组加控制字节
+    size_t memoryBytes() const {
+        return capacity_ == 0 ? 0 : capacity_ * sizeof(value_type) + capacity_ + kGroupWidth;
+    }
+
+    iterator begin() { return iterator(this, nextFull(0)); }
+    iterator end() { return iterator(this, capacity_); }
+
+    // 支持异构查找：Hash 和 Equal 都是透明的时候，K 可以是 std::string_view 之类
+    template <typename K>
+    iterator find(const K& key) {
+        return iterator(this, findIndex(key));
+    }
+
+    // 已经用 hash() 算好哈希值时的查找，批量查找时配合 prefetch 使用
+    template <typename K>
+    iterator find(const K& key, size_t hash) {
+        return iterator(this, findIndex(key, hash));
+    }
+
+    template <typename K>
+    size_t hash(const K& key) const {
+        return hashOf(key);
+    }
+
+    // 预取 hash 对应的第一组控制字节和起始槽位。插入和扩容不会让它出错，只是可能白预取
+    void prefetch(size_t hash) const {
+        if (capacity_ == 0) return;
+        size_t pos = h1(hash);
+        KamaCache::prefetch(ctrl_ + pos);
+        KamaCache::prefetch(slots_ + pos);
+    }
+
+    template <typename K>
+    size_t count(const K& key) {
+        return findIndex(key) == capacity_ ? 0 : 1;
+    }
+
+    // key 已存在时不插入，返回已有元素
+    template <typename K, typename V>
+    std::pair<iterator, bool> emplace(K&& key, V&& value) {
+        size_t hash = hashOf(key);
+        size_t index = findIndex(key, hash);
+        if (index != capacity_) return {iterator(this, index), false};
+
+        if (growthLeft_ == 0) {
+            rehash(capacity_ == 0 ? kGroupWidth : capacity_ * 2);
+        }
+        index = findEmpty(hash);
+        new (&slots_[index]) value_type(std::forward<K>(key), std::forward<V>(value));
+        setCtrl(index, h2(hash));
+        ++size_;
+        --growthLeft_;
+        return {iterator(this, index), true};
+    }
+
+    void erase(iterator it) {
+        eraseIndex(it.index_);
+    }
+
+    template <typename K>
+    size_t erase(const K& key) {
+        size_t index = findIndex(key);
+        if (index == capacity_) return 0;
+        eraseIndex(index);
+        return 1;
+    }
+
+    // 清空元素，保留已分配的空间
+    void clear() {
+        destroyAll();
+        if (capacity_ != 0) {
+            std::memset(ctrl_, kEmpty, capacity_ + kGroupWidth);
+            growthLeft_ = maxLoad(capacity_);
+        }
+    }
+
+    // 预留至少 n 个元素的空间，之后插入 n 个元素不会扩容
+    void reserve(size_t n) {
+        size_t capacity = kGroupWidth;
+        while (maxLoad(capacity) < n) capacity *= 2;
+        if (capacity > capacity_) rehash(capacity);
+    }
+
+private:
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr int8_t kEmpty = static_cast<int8_t>(0x80);
+
+    // 最大装载率 7/8
+    static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+
+    // 对 Hash 的结果再混合一次，低 7 位做指纹，其余位选起始位置
+    template <typename K>
+    size_t hashOf(const K& key) const {
+        return static_cast<size_t>(mixHash(static_cast<uint64_t>(Hash{}(key))));
+    }
+
+    static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    size_t h1(size_t hash) const { return (hash >> 7) & (capacity_ - 1); }
+
+    // 一组 16 个控制字节，返回匹配位置的位图
+    struct Group {
+        explicit Group(const int8_t* ctrl) : ctrl_(ctrl) {}
+
+        uint32_t match(int8_t tag) const {
+#if defined(__SSE2__)
+            __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), group)));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < kGroupWidth; ++i) {
+                if (ctrl_[i] == tag) mask |= uint32_t(1) << i;
+            }
+            return mask;
+#endif
+        }
+
+        uint32_t matchEmpty() const {
+#if defined(__SSE2__)
+            // 空槽的最高位为 1，满槽的最高位为 0
+            __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl_));
+            return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+            return match(kEmpty);
+#endif
+        }
+
+        const int8_t* ctrl_;
+    };
+
+    template <typename K>
+    size_t findIndex(const K& key) const {
+        return capacity_ == 0 ? 0 : findIndex(key, hashOf(key));
+    }
+
+    // 从 H1 开始逐组比较指纹；遇到空槽说明 key 不存在（线性探测中同一起点的元素之间没有空槽）。
+    // 找不到时返回 capacity_（即 end()）
+    template <typename K>
+    size_t findIndex(const K& key, size_t hash) const {
+        if (capacity_ == 0) return 0;
+        int8_t tag = h2(hash);
+        size_t pos = h1(hash);
+        for (;;) {
+            Group group(ctrl_ + pos);
+            for (uint32_t mask = group.match(tag); mask != 0; mask &= mask - 1) {
+                size_t index = (pos + lowestBit(mask)) & (capacity_ - 1);
+                if (Equal{}(slots_[index].first, key)) return index;
+            }
+            if (group.matchEmpty() != 0) return capacity_;
+            pos = (pos + kGroupWidth) & (capacity_ - 1);
+        }
+    }
+
+    // 从 H1 开始的第一个空槽；装载率小于 1，一定能找到
+    size_t findEmpty(size_t hash) const {
+        size_t pos = h1(hash);
+        for (;;) {
+            uint32_t mask = Group(ctrl_ + pos).matchEmpty();
+            if (mask != 0) return (pos + lowestBit(mask)) & (capacity_ - 1);
+            pos = (pos + kGroupWidth) & (capacity_ - 1);
+        }
+    }
+
+    // 同时更新末尾的镜像字节
+    void setCtrl(size_t index, int8_t value) {
+        ctrl_[index] = value;
+        if (index < kGroupWidth) ctrl_[capacity_ + index] = value;
+    }
+
+    bool isFull(size_t index) const { return ctrl_[index] >= 0; }
+
+    size_t nextFull(size_t index) const {
+        while (index < capacity_ && !isFull(index)) ++index;
+        return index;
+    }
+
+    // 删除后向前移动：空出的位置之后，凡是能放到空位上（空位在它的起点和当前位置之间）的元素都前移一格，
+    // 直到遇到空槽。这样表中永远没有墓碑
+    void eraseIndex(size_t index) {
+        size_t mask = capacity_ - 1;
+        slots_[index].~value_type();
+        --size_;
+        ++growthLeft_;
+
+        size_t hole = index;
+        for (size_t next = (index + 1) & mask; isFull(next); next = (next + 1) & mask) {
+            size_t home = h1(hashOf(slots_[next].first));
+            // next 离起点的距离不小于离空位的距离：空位在 [home, next) 之间，可以前移
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                new (&slots_[hole]) value_type(std::move(slots_[next]));
+                slots_[next].~value_type();
+                setCtrl(hole, ctrl_[next]);
+                hole = next;
+            }
+        }
+        setCtrl(hole, kEmpty);
+    }
+
+    void rehash(size_t newCapacity) {
+        int8_t* oldCtrl = ctrl_;
+        value_type* oldSlots = slots_;
+        size_t oldCapacity = capacity_;
+
+        ctrl_ = static_cast<int8_t*>(::operator new(newCapacity + kGroupWidth));
+        std::memset(ctrl_, kEmpty, newCapacity + kGroupWidth);
+        slots_ = static_cast<value_type*>(::operator new(newCapacity * sizeof(value_type),
+                                                         std::align_val_t(alignof(value_type))));
+        capacity_ = newCapacity;
+        growthLeft_ = maxLoad(newCapacity) - size_;
+
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldCtrl[i] < 0) continue;
+            size_t hash = hashOf(oldSlots[i].first);
+            size_t index = findEmpty(hash);
+            new (&slots_[index]) value_type(std::move(oldSlots[i]));
+            oldSlots[i].~value_type();
+            setCtrl(index, h2(hash));
+        }
+        if (oldCapacity != 0) {
+            ::operator delete(oldCtrl);
+            ::operator delete(oldSlots, std::align_val_t(alignof(value_type)));
+        }
+    }
+
+    void destroyAll() {
+        if (size_ == 0) return;
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (isFull(i)) slots_[i].~value_type();
+        }
+        size_ = 0;
+    }
+
+    void release() {
+        if (capacity_ == 0) return;
+        ::operator delete(ctrl_);
+        ::operator delete(slots_, std::align_val_t(alignof(value_type)));
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        growthLeft_ = 0;
+    }
+
+private:
+    int8_t* ctrl_;        // capacity_ + kGroupWidth 个控制字节
+    value_type* slots_;   // capacity_ 个槽位，只有控制字节为满的槽位里有对象
+    size_t capacity_;     // 槽位个数，0 或 2 的幂（至少 kGroupWidth）
+    size_t size_;
+    size_t growthLeft_;   // 达到最大装载率之前还能插入的个数
+};
+
+// 缓存统一通过 findKey 做异构查找；FlatHashMap 本身支持透明查找，不需要构造临时 Key
+template <typename Key, typename Value, typename Hash, typename Equal, typename K>
+typename FlatHashMap<Key, Value, Hash, Equal>::iterator findKey(FlatHashMap<Key, Value, Hash, Equal>& map, const K& key) {
+    return map.find(key);
+}
+
+} // namespace KamaCache
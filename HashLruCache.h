@@ -1,13 +1,232 @@
 #pragma once
 
-#include "LruKCache.h" // 引入 KLruKCache
+/*
+HashLruCache：分片（sharded）LRU 缓存。
+总容量被均分到 sliceNum_ 个独立的 LruCache 分片中，每个分片有自己的 mutex_。
+通过 key 的哈希值选择分片，不同分片上的 put/get 可以并行执行，
+吞吐量随核数增长，而不是被单个锁串行化。
+*/
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "KICachePolicy.h"
+#include "LruCache.h"
 
 namespace KamaCache {
+inline namespace KAMACACHE_STATS_ABI {
 
-// 定义 KHashLruCache 类
 template <typename Key, typename Value>
-class HashLruCache : public LruKCache<Key, Value> {
-    // KHashLruCache 的声明和实现
+class HashLruCache : public KICachePolicy<Key, Value> {
+
+public:
+    // capacity 为总容量，sliceNum 为分片数；sliceNum <= 0 时使用硬件线程数
+    HashLruCache(size_t capacity, int sliceNum = 0)
+    : capacity_(capacity),
+    sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency())
+    {
+        if (sliceNum_ == 0) sliceNum_ = 1;
+
+        // 每个分片的容量向上取整，保证总容量不小于 capacity；LruCache 的容量是 int，超出的部分截到 INT_MAX
+        size_t sliceSize = static_cast<size_t>(std::ceil(capacity_ / static_cast<double>(sliceNum_)));
+        int sliceCapacity = static_cast<int>(std::min<size_t>(sliceSize, INT_MAX));
+        for (size_t i = 0; i < sliceNum_; ++i) {
+            lruSliceCaches_.emplace_back(std::make_unique<LruCache<Key, Value>>(sliceCapacity));
+        }
+    }
+
+    // 按权重限制容量：maxWeight 为所有分片权重之和的上限，同样均分到各个分片，每个分片 ceil(maxWeight / sliceNum)。
+    // 注意单个条目的上限是一个分片的预算而不是 maxWeight：比 sliceWeight() 重的条目会被它所在的分片拒绝
+    // （计入 rejections），即使它放得进总预算。需要存放大条目时减少分片数或加大 maxWeight
+    HashLruCache(size_t maxWeight, Weigher<Key, Value> weigher, int sliceNum = 0)
+    : capacity_(maxWeight),
+    sliceNum_(sliceNum > 0 ? sliceNum : std::thread::hardware_concurrency())
+    {
+        if (sliceNum_ == 0) sliceNum_ = 1;
+
+        for (size_t i = 0; i < sliceNum_; ++i) {
+            lruSliceCaches_.emplace_back(std::make_unique<LruCache<Key, Value>>(sliceWeight(), weigher));
+        }
+    }
+
+    // 每个分片的容量（按权重限制时是权重预算），也是单个条目能被接受的最大权重
+    size_t sliceWeight() const {
+        return (capacity_ + sliceNum_ - 1) / sliceNum_;
+    }
+
+    ~HashLruCache() override = default;
+
+    // 插入数据：只锁住 key 所在的分片
+    void put(Key key, Value value) override {
+        size_t sliceIndex = Hash(key) % sliceNum_;
+        lruSliceCaches_[sliceIndex]->put(std::move(key), std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        size_t sliceIndex = Hash(key) % sliceNum_;
+        lruSliceCaches_[sliceIndex]->emplace(std::move(key), std::forward<Args>(args)...);
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return get<Key>(key, value);
+    }
+
+    // 异构查找：分片选择和分片内查找都不构造临时 Key
+    template <typename K>
+    bool get(const K& key, Value& value) {
+        size_t sliceIndex = Hash(key) % sliceNum_;
+        return lruSliceCaches_[sliceIndex]->get(key, value);
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        size_t sliceIndex = Hash(key) % sliceNum_;
+        return lruSliceCaches_[sliceIndex]->visit(key, std::forward<Visitor>(visitor));
+    }
+
+    // 批量获取：按分片分组，每个分片只加一次锁。
+    // 分片直接按下标读 keys、写 values 和 hits，不拷贝 key，也不经过中间数组
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* hits) override {
+        SliceGroups groups = groupBySlice(keys, count);
+        size_t hitCount = 0;
+        for (size_t s = 0; s < sliceNum_; ++s) {
+            size_t begin = groups.offsets[s];
+            size_t end = groups.offsets[s + 1];
+            if (begin == end) continue;
+            hitCount += lruSliceCaches_[s]->getMany(keys, groups.order.data() + begin, end - begin, values, hits);
+        }
+        releaseGroups(std::move(groups));
+        return hitCount;
+    }
+
+    // 批量插入：按分片分组，每个分片只加一次锁，key 和值只在写入分片时拷贝一次
+    void putMany(const Key* keys, const Value* values, size_t count) override {
+        SliceGroups groups = groupBySlice(keys, count);
+        for (size_t s = 0; s < sliceNum_; ++s) {
+            size_t begin = groups.offsets[s];
+            size_t end = groups.offsets[s + 1];
+            if (begin == end) continue;
+            lruSliceCaches_[s]->putMany(keys, values, groups.order.data() + begin, end - begin);
+        }
+        releaseGroups(std::move(groups));
+    }
+
+    void remove(const Key& key) {
+        size_t sliceIndex = Hash(key) % sliceNum_;
+        lruSliceCaches_[sliceIndex]->remove(key);
+    }
+
+    // 汇总所有分片的统计
+    CacheStatsSnapshot stats() const override {
+        CacheStatsSnapshot total;
+        for (const auto& slice : lruSliceCaches_) {
+            total += slice->stats();
+        }
+        return total;
+    }
+
+    // 各分片在自己解锁之后把通知交给这里，再按 delivery 投递（Background 时整个缓存只有一个通知线程）
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        bool enabled = static_cast<bool>(listener);
+        notifier_.setListener(std::move(listener), delivery);
+        for (auto& slice : lruSliceCaches_) {
+            if (enabled) {
+                slice->setRemovalListener([this](std::vector<RemovalNotification<Key, Value>>& batch) {
+                    notifier_.deliver(batch);
+                });
+            } else {
+                slice->setRemovalListener(nullptr);
+            }
+        }
+    }
+
+    size_t sliceNum() const { return sliceNum_; }
+
+    // 所有分片的权重之和
+    size_t totalWeight() {
+        size_t total = 0;
+        for (auto& slice : lruSliceCaches_) {
+            total += slice->totalWeight();
+        }
+        return total;
+    }
+
+private:
+    // 一批 key 按分片分好组的下标：order[offsets[s], offsets[s + 1]) 是落在分片 s 上的那些下标
+    struct SliceGroups {
+        std::vector<size_t> order;
+        std::vector<size_t> offsets;
+        std::vector<size_t> slices; // 每个 key 所在的分片，第二遍不用重新计算哈希
+    };
+
+    // 每个线程复用一份分组缓冲区，稳定之后批量接口不再分配。用的时候整个取出、用完放回：
+    // 删除监听器在分片解锁后被调用，它在同一个线程里再次调用批量接口时拿到的是一份空的缓冲区
+    static SliceGroups& groupScratch() {
+        thread_local SliceGroups scratch;
+        return scratch;
+    }
+
+    // 计数排序：先数出每个分片有几个 key，再把下标放进各自的区间，组内保持原来的顺序
+    SliceGroups groupBySlice(const Key* keys, size_t count) const {
+        SliceGroups groups = std::move(groupScratch());
+        groups.order.resize(count);
+        groups.slices.resize(count);
+        groups.offsets.assign(sliceNum_ + 1, 0);
+        for (size_t i = 0; i < count; ++i) {
+            size_t slice = Hash(keys[i]) % sliceNum_;
+            groups.slices[i] = slice;
+            ++groups.offsets[slice + 1];
+        }
+        for (size_t s = 0; s < sliceNum_; ++s) {
+            groups.offsets[s + 1] += groups.offsets[s];
+        }
+        // offsets[s] 当作分片 s 的写指针，放完之后它指向分片 s + 1 的起点，再整体右移一格还原
+        for (size_t i = 0; i < count; ++i) {
+            groups.order[groups.offsets[groups.slices[i]]++] = i;
+        }
+        for (size_t s = sliceNum_ - 1; s > 0; --s) {
+            groups.offsets[s] = groups.offsets[s - 1];
+        }
+        groups.offsets[0] = 0;
+        return groups;
+    }
+
+    static void releaseGroups(SliceGroups groups) {
+        groupScratch() = std::move(groups);
+    }
+
+    // 将 key 映射到分片下标。std::hash 对整数是恒等映射，先混合，否则步长与分片数相关的 key 会挤在少数几个分片上；
+    // 再取高 32 位，分片内 FlatHashMap 的指纹和选桶用的是低位，同一个分片的 key 在那些位上不能有共同的规律
+    template <typename K>
+    size_t Hash(const K& key) const {
+        return static_cast<size_t>(mixHash(static_cast<uint64_t>(KeyHash<Key>{}(key))) >> 32);
+    }
+
+private:
+    size_t capacity_;  // 总容量
+    size_t sliceNum_;  // 分片数量
+    RemovalNotifier<Key, Value> notifier_; // 声明在分片之前：分片析构时投递的最后一批通知还要经过它
+    std::vector<std::unique_ptr<LruCache<Key, Value>>> lruSliceCaches_; // 各个分片的 LRU 缓存
 };
 
+} // inline namespace KAMACACHE_STATS_ABI
+
 } // namespace KamaCache
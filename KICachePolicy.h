@@ -1,5 +1,15 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include "CacheStats.h"
+#include "RemovalListener.h"
+
 /*
 KICachePolicy 是一个模板基类，定义了缓存策略的接口。
 任何缓存策略（如 LRU、LFU）都可以继承这个基类，并实现其虚函数。
@@ -7,6 +17,7 @@ KICachePolicy 是一个模板基类，定义了缓存策略的接口。
 */
 
 namespace KamaCache {
+inline namespace KAMACACHE_STATS_ABI {
 
 template <typename Key, typename Value>
 class KICachePolicy {
@@ -16,18 +27,154 @@ public:
     virtual ~KICachePolicy() {};
 
     // 虚函数： 继承这个类的后续的LRU，LFU，都必须override这个虚函数
-    // 插入键值对到缓存中
+    // 插入键值对到缓存中。key/value 按值传入：调用者传右值时只有移动，没有拷贝，
+    // 派生类内部应继续 std::move 下去
     virtual void put(Key key, Value value) = 0;
 
     // 查找缓存中的键
-    virtual bool get(Key key, Value& value) = 0;
+    virtual bool get(const Key& key, Value& value) = 0;
 
     // 返回键对应的值，适用于不需要区分缓存命中与否的情况：
     // 如果未命中，派生类可以选择抛出异常或返回默认值。
-    virtual Value get(Key key) = 0;
+    virtual Value get(const Key& key) = 0;
+
+    // 命中时在缓存内部直接以 const 引用把值交给 visitor，不拷贝值；返回是否命中。
+    // visitor 在持锁期间被调用，不能再访问同一个缓存。
+    // 默认实现退化为 get 一份拷贝，派生类应重写。
+    virtual bool visit(const Key& key, const std::function<void(const Value&)>& visitor) {
+        Value value;
+        if (!get(key, value)) return false;
+        visitor(value);
+        return true;
+    }
+
+    // 批量查找：keys[i] 命中时写入 values[i]，并置 hits[i] 为 true，返回命中个数。
+    // 默认实现逐个调用 get，派生类可以重写为整批只加一次锁。
+    virtual size_t getMany(const Key* keys, size_t count, Value* values, bool* hits) {
+        size_t hitCount = 0;
+        for (size_t i = 0; i < count; ++i) {
+            hits[i] = get(keys[i], values[i]);
+            if (hits[i]) ++hitCount;
+        }
+        return hitCount;
+    }
+
+    // 批量插入：依次插入 (keys[i], values[i])
+    virtual void putMany(const Key* keys, const Value* values, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            put(keys[i], values[i]);
+        }
+    }
+
+    // 统计快照：命中/未命中/插入/淘汰等计数和延迟直方图。
+    // 只有定义了 KAMACACHE_ENABLE_STATS 时才会计数，否则返回全零
+    virtual CacheStatsSnapshot stats() const {
+        return CacheStatsSnapshot();
+    }
 
+    // 删除通知：条目被淘汰、过期、被新值覆盖或被 remove 删除时，在释放锁之后把 (key, 旧值, 原因)
+    // 整批交给 listener（见 RemovalListener.h）。传入空的 listener 取消。
+    // 默认实现不产生任何通知，派生类应重写
+    virtual void setRemovalListener(RemovalListener<Key, Value> listener,
+                                    ListenerDelivery delivery = ListenerDelivery::Caller) {
+        (void)listener;
+        (void)delivery;
+    }
 };
 
+// 计算条目权重（例如占用的字节数）的函数。缓存的容量是所有条目权重之和的上限；
+// 不提供 weigher 时每个条目的权重为 1，容量就是条目个数
+template <typename Key, typename Value>
+using Weigher = std::function<size_t(const Key&, const Value&)>;
+
+// 支持异构查找的哈希：例如 Key 为 std::string 时，可以直接用 std::string_view 或 const char* 查找。
+// std::hash<std::string> 与 std::hash<std::string_view> 对相同内容保证结果一致。
+template <typename Key>
+struct KeyHash {
+    using is_transparent = void;
+
+    size_t operator()(const Key& key) const {
+        return std::hash<Key>{}(key);
+    }
+
+    template <typename K,
+              typename = std::enable_if_t<!std::is_same<std::decay_t<K>, Key>::value>>
+    size_t operator()(const K& key) const {
+        if constexpr (std::is_convertible<const Key&, std::string_view>::value &&
+                      std::is_convertible<const K&, std::string_view>::value) {
+            return std::hash<std::string_view>{}(std::string_view(key));
+        } else {
+            return std::hash<Key>{}(Key(key));
+        }
+    }
+};
+
+// 对哈希值再做一次混合（murmur3 的 fmix64）：std::hash 对整数是恒等映射，
+// 开放寻址表和组相联缓存要用哈希值的不同位选位置和指纹，直接用的话低位和高位都很差
+inline uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// 按 key 的哈希做空间采样（SHARDS）：只看混合后哈希的高 24 位。
+// 分片/分段用 32 位以上的少数几位，FlatHashMap 用低位选桶和指纹，都和这 24 位无关，
+// 否则被采样的 key 在索引里挤在少数几个桶上。threshold = 采样率 * kSampleModulus
+constexpr uint64_t kSampleModulus = uint64_t(1) << 24;
+
+inline bool sampledHash(uint64_t hash, uint64_t threshold) {
+    return (hash >> 40) < threshold;
+}
+
+// 最低位 1 的下标，mask 不能为 0。GCC/Clang 用内建指令，其它编译器逐位查找
+inline unsigned lowestBit(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+#else
+    unsigned bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// 节点哈希表统一使用的相等比较，std::equal_to<> 本身就支持异构比较
+using KeyEqual = std::equal_to<>;
+
+// 在 map 中查找与 Key 可比较的 k。
+// 标准库支持无序容器的异构查找（C++20）时不构造临时 Key，否则退化为先构造 Key。
+template <typename Map, typename K>
+auto findKey(Map& map, const K& key) -> decltype(map.find(std::declval<const typename Map::key_type&>())) {
+#if defined(__cpp_lib_generic_unordered_lookup)
+    return map.find(key);
+#else
+    if constexpr (std::is_same<std::decay_t<K>, typename Map::key_type>::value) {
+        return map.find(key);
+    } else {
+        return map.find(typename Map::key_type(key));
+    }
+#endif
+}
+
+// 软件预取：批量操作中先发出预取，再访问节点（GCC/Clang 之外为空操作）
+inline void prefetch(const void* addr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(addr);
+#else
+    (void)addr;
+#endif
+}
+
+// 批量查找的预取距离：探查第 j 个 key 时预取第 j + kPrefetchDistance 个 key 的哈希槽
+constexpr size_t kPrefetchDistance = 8;
+
+} // inline namespace KAMACACHE_STATS_ABI
+
 } // namespace KameCache
 
 
@@ -1,15 +1,25 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "CacheTier.h"
+#include "FlatHashMap.h"
 #include "KICachePolicy.h"
+#include "Snapshot.h"
+#include "TimingWheel.h"
 
 namespace KamaCache {
+inline namespace KAMACACHE_STATS_ABI {
 
 // 1. LFU类里用到的频率list
 template <typename Key, typename Value>
@@ -18,29 +28,41 @@ class FreqList {
 public:
     // Node 的作用是封装一个缓存节点
     struct Node {
-        int freq; // 访问频率
+        int64_t freq; // 访问频率（LfuCache 中是相对于老化基准 freqOffset_ 的“绝对”频率）
         Key key;
         Value value;
         std::shared_ptr<Node> pre;
         std::shared_ptr<Node> next;
+        FreqList* owner; // 节点当前所在的频率链表，省去一次按频次的查找
+        uint64_t expireAt = 0; // TTL 到期的 tick，0 表示不过期
+        uint64_t scheduledAt = 0; // 时间轮里这个节点唯一有效记录的到期 tick，0 表示没有记录
+        size_t weight = 1;     // 条目权重，由缓存的 weigher 计算
 
         // 默认构造函数，初始化频率为1
-        Node() : freq(1), pre(nullptr), next(nullptr) {}
+        Node() : freq(1), pre(nullptr), next(nullptr), owner(nullptr) {}
 
         // 带参数构造函数，初始化key，并设置频率为1
-        Node(Key key, Value value) : freq(1), key(key), value(value), pre(nullptr), next(nullptr) {}
+        Node(Key key, Value value) : freq(1), key(std::move(key)), value(std::move(value)), pre(nullptr), next(nullptr), owner(nullptr) {}
+
+        // 原地构造 value，供 emplace 使用
+        template <typename... Args>
+        Node(Key key, std::in_place_t, Args&&... args)
+        : freq(1), key(std::move(key)), value(std::forward<Args>(args)...), pre(nullptr), next(nullptr), owner(nullptr) {}
     };
 
     using NodePtr = std::shared_ptr<Node>;
 
 private:
-    int freq_;   // 表示当前链表管理的访问频率
+    int64_t freq_;   // 表示当前链表管理的访问频率
     NodePtr head_;
     NodePtr tail_;
+    // LfuCache 中所有非空的频率链表按频次升序串成一个双向链表
+    FreqList* prevList_;
+    FreqList* nextList_;
 
 public:
     // 构造函数
-    explicit FreqList(int n) : freq_(n) {
+    explicit FreqList(int64_t n) : freq_(n), prevList_(nullptr), nextList_(nullptr) {
         // 初始化双向链表
         head_ = std::make_shared<Node>();
         tail_ = std::make_shared<Node>();
@@ -48,6 +70,17 @@ public:
         tail_->pre = head_;
     }
 
+    // 析构：断开 shared_ptr 组成的环，否则哨兵和剩余节点都不会被释放
+    ~FreqList() {
+        NodePtr node = head_;
+        while (node) {
+            NodePtr next = node->next;
+            node->pre = nullptr;
+            node->next = nullptr;
+            node = next;
+        }
+    }
+
     // 检查链表是否为空
     bool isEmpty() const {
         return head_->next == tail_;
@@ -66,6 +99,7 @@ public:
         node->next = tail_;
         tail_->pre->next = node;
         tail_->pre = node;
+        node->owner = this;
     }
 
     // 从链表中移除节点
@@ -84,6 +118,7 @@ public:
         // 清空node指针
         node->pre = nullptr;
         node->next = nullptr;
+        node->owner = nullptr;
     }
 
     // 返回链表中的第一个有效节点
@@ -96,6 +131,10 @@ public:
         return tail_;
     }
 
+    int64_t getFreq() const {
+        return freq_;
+    }
+
     template <typename K, typename V>
     friend class LfuCache; // 修正 friend 声明
 };
@@ -109,173 +148,804 @@ class LfuCache : public KICachePolicy<Key, Value> {
 public:
     using Node = typename FreqList<Key, Value>::Node; // 定义频率链表 FreqList 中的节点类型
     using NodePtr = std::shared_ptr<Node>; // 指向Node的指针
-    using NodeMap = std::unordered_map<Key, NodePtr>; // 定义哈希表，用于将键 Key 映射到对应的缓存节点
+    using NodeMap = FlatHashMap<Key, NodePtr, KeyHash<Key>, KeyEqual>; // 定义哈希表（开放寻址），用于将键 Key 映射到对应的缓存节点，支持异构查找
 
     // 构造函数: 目的 为 LFU 缓存的运行提供初始化参数
     LfuCache(int capacity, int maxAverageNum = 10)
-    : capacity_(capacity),  // 初始化缓存容量
-    minFreq_(INT8_MAX),  // 初始化为一个极大值，用于追踪当前最小访问频次
+    : capacity_(capacity > 0 ? capacity : 0),  // 初始化缓存容量
+    totalWeight_(0),
     maxAverageNum_(maxAverageNum),
     curAverageNum_(0), 
-    curTotalNum_(0) // 分别用于管理和记录访问频次
+    curTotalNum_(0), // 分别用于管理和记录访问频次
+    freqOffset_(0),
+    headList_(nullptr),
+    floorList_(nullptr)
+    {}
+
+    // 按权重限制容量：maxWeight 是所有条目权重之和的上限
+    LfuCache(size_t maxWeight, Weigher<Key, Value> weigher, int maxAverageNum = 10)
+    : capacity_(maxWeight),
+    totalWeight_(0),
+    weigher_(std::move(weigher)),
+    maxAverageNum_(maxAverageNum),
+    curAverageNum_(0),
+    curTotalNum_(0),
+    freqOffset_(0),
+    headList_(nullptr),
+    floorList_(nullptr)
     {}
 
     // 析构
-    ~LfuCache() override = default;
+    ~LfuCache() override {
+        purge();
+    }
 
     // Put: 将键值对存入缓存，如果键已存在，则更新对应值
     void put(Key key, Value value) override {
         // 1. 容量检查：如果容量为 0，直接返回。
-        // 2. 线程安全：使用 std::lock_guard<std::mutex> 对缓存操作加锁。
+        // 2. 线程安全：使用 TimedLockGuard（等同于 std::lock_guard，开启统计时记录等锁耗时）对缓存操作加锁。
         // 3. 查找键：如果存在，就调用getInternal 更新。如果不存在，就用putInternal 添加新缓存
 
         if(capacity_ == 0){
             return;
         }
 
-        // 更新缓存值时，需要加锁
-        std::lock_guard<std::mutex> lock(mutex_);
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        // 更新缓存值时，需要加锁。notify 先于锁构造、后于锁析构：这次操作产生的删除通知在解锁之后才投递
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        invalidateTier(key);
         auto it = nodeMap_.find(key);
 
         // 如果it不为空，说明找到了key值. 则更新key对应的值（也就是频率）
         if(it != nodeMap_.end()){
             //解释：it->second 的作用是访问哈希表 nodeMap_ 中，键对应的缓存节点指针 NodePtr
-            it->second->value = value;  
-            getInternal(it->second, value);
+            updateInternal(it->second, std::move(value), 0);
             return;
         }
 
-        putInternal(key, value);
+        putInternal(std::make_shared<Node>(std::move(key), std::move(value)));
 
     }
 
+    // 带过期时间的插入：ttl 之后条目由时间轮主动回收，不再占用容量。
+    // 不带 ttl 的 put 会把已有条目改回不过期
+    void put(Key key, Value value, std::chrono::milliseconds ttl) {
+        if(capacity_ == 0){
+            return;
+        }
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        invalidateTier(key);
+        uint64_t deadline = timingWheel_.deadlineAfter(ttl);
+
+        auto it = nodeMap_.find(key);
+        if(it != nodeMap_.end()){
+            scheduleExpiry(*it->second, deadline); // 新值被拒绝时这条记录成为过时记录
+            updateInternal(it->second, std::move(value), deadline);
+            return;
+        }
+
+        NodePtr node = std::make_shared<Node>(std::move(key), std::move(value));
+        node->expireAt = deadline;
+        scheduleExpiry(*node, deadline);
+        putInternal(std::move(node));
+    }
+
+    // 原地构造 value：key 已存在时用参数构造新值替换旧值
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        if(capacity_ == 0){
+            return;
+        }
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        invalidateTier(key);
+        auto it = nodeMap_.find(key);
+        if(it != nodeMap_.end()){
+            updateInternal(it->second, Value(std::forward<Args>(args)...), 0);
+            return;
+        }
+
+        putInternal(std::make_shared<Node>(std::move(key), std::in_place, std::forward<Args>(args)...));
+    }
+
     // 用于直接判断键是否存在，并通过引用参数返回值。
-    bool get(Key key, Value& value) override {
+    bool get(const Key& key, Value& value) override {
+        return get<Key>(key, value);
+    }
+
+    // 异构查找：K 可以是任何能与 Key 比较的类型，例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
         // 思路：查找键 key 是否存在于缓存中
         // 如果在，存入Value，更新频率，并返回true
         // 如果不在，返回false
         
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto it = nodeMap_.find(key);
-        if(it != nodeMap_.end()){
-            getInternal(it->second, value);
-            return true;
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        std::shared_ptr<CacheTier<Key, Value>> tier;
+        uint64_t writes;
+        {
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            reclaimExpired(); // 先回收已到期的条目，保证不会返回过期数据
+            auto it = findKey(nodeMap_, key);
+            if(it != nodeMap_.end()){
+                getInternal(it->second, value);
+                stats_.recordHit();
+                return true;
+            }
+
+            stats_.recordMiss();
+            if(!tier_) return false;
+            tier = tier_;
+            writes = beginPromotion(Key(key));
         }
-
-        return false;
+        // 内存未命中：释放锁之后再查二级缓存
+        return promoteFromTier(*tier, Key(key), value, writes);
     }
 
     // 通过键直接返回对应的值
-    Value get(Key key) override {
-        Value value;
+    Value get(const Key& key) override {
+        Value value{};
         get(key, value);
         return value;
 
     }
 
+    // 零拷贝读取：命中时在持锁状态下把值的 const 引用交给 visitor，并更新频次
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 二级缓存命中时 visitor 在锁外被调用，拿到的是取回的值
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        std::shared_ptr<CacheTier<Key, Value>> tier;
+        uint64_t writes;
+        {
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            reclaimExpired();
+            auto it = findKey(nodeMap_, key);
+            if(it != nodeMap_.end()){
+                increaseFreq(it->second);
+                visitor(it->second->value);
+                stats_.recordHit();
+                return true;
+            }
+            stats_.recordMiss();
+            if(!tier_) return false;
+            tier = tier_;
+            writes = beginPromotion(Key(key));
+        }
+        Value value;
+        if(!promoteFromTier(*tier, Key(key), value, writes)) return false;
+        visitor(static_cast<const Value&>(value));
+        return true;
+    }
+
+    // 批量获取：整批只加一次锁。先算出所有哈希值，查找时提前 kPrefetchDistance 个 key 预取哈希槽，
+    // 并预取所有命中节点，再依次更新频次
+    // 挂了二级缓存时，未命中的 key 在释放锁之后逐个到二级缓存中查找
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* hits) override {
+        size_t hitCount = 0;
+        NotifyScope<Key, Value> notify(notifier_);
+        std::shared_ptr<CacheTier<Key, Value>> tier;
+        std::vector<uint64_t> writes; // 每个未命中 key 开始取回时的写入计数
+        {
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            reclaimExpired();
+            batchNodes_.resize(count);
+            batchHashes_.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                batchHashes_[i] = nodeMap_.hash(keys[i]);
+                if (i < kPrefetchDistance) nodeMap_.prefetch(batchHashes_[i]);
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (i + kPrefetchDistance < count) nodeMap_.prefetch(batchHashes_[i + kPrefetchDistance]);
+                auto it = nodeMap_.find(keys[i], batchHashes_[i]);
+                if (it != nodeMap_.end()) {
+                    prefetch(it->second.get());
+                    batchNodes_[i] = &it->second;
+                } else {
+                    batchNodes_[i] = nullptr;
+                }
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                hits[i] = batchNodes_[i] != nullptr;
+                if (!hits[i]) continue;
+                getInternal(*batchNodes_[i], values[i]);
+                ++hitCount;
+            }
+            stats_.recordHit(hitCount);
+            stats_.recordMiss(count - hitCount);
+            if (!tier_ || hitCount == count) return hitCount;
+            tier = tier_;
+            writes.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (!hits[i]) writes[i] = beginPromotion(keys[i]);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (hits[i]) continue;
+            hits[i] = promoteFromTier(*tier, keys[i], values[i], writes[i]);
+            if (hits[i]) ++hitCount;
+        }
+        return hitCount;
+    }
+
+    // 只在 key 已存在时替换它的值，返回是否存在。不算一次访问：频次、TTL 和命中统计都不变，
+    // 供后台刷新这类"值过时了、但没有人读它"的写入使用。新值变重时淘汰其他条目，不淘汰它自己
+    bool replace(const Key& key, Value value) {
+        return replaceIf(key, std::move(value), [](const Value&) { return true; });
+    }
+
+    // 比较后替换：key 存在且 expected(当前值) 为 true 时才替换，返回是否替换（或因新值过重而删除）。
+    // expected 在持锁期间被调用，后台刷新用它确认加载期间条目没有被别的写入换掉
+    template <typename Expected>
+    bool replaceIf(const Key& key, Value value, Expected expected) {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end() || !expected(it->second->value)) {
+            return false;
+        }
+        recordWrite(key);
+        NodePtr node = it->second;
+        size_t weight = weigh(node->key, value);
+        if (weight > capacity_) {
+            notifier_.record(node->key, node->value, RemovalCause::Evicted);
+            removeInternal(node);
+            stats_.recordRejection();
+            return true;
+        }
+        stats_.recordUpdate();
+        notifier_.record(node->key, node->value, RemovalCause::Replaced);
+        totalWeight_ = totalWeight_ - node->weight + weight;
+        node->weight = weight;
+        node->value = std::move(value);
+        while (totalWeight_ > capacity_ && headList_) {
+            kickOut(node.get());
+        }
+        return true;
+    }
+
+    // 批量插入：整批只加一次锁
+    void putMany(const Key* keys, const Value* values, size_t count) override {
+        if(capacity_ == 0){
+            return;
+        }
+
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        for (size_t i = 0; i < count; ++i) {
+            invalidateTier(keys[i]);
+            auto it = nodeMap_.find(keys[i]);
+            if(it != nodeMap_.end()){
+                updateInternal(it->second, values[i], 0);
+            } else {
+                putInternal(std::make_shared<Node>(keys[i], values[i]));
+            }
+        }
+    }
+
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+    // 挂上二级缓存：之后因容量被淘汰的条目交给它，内存未命中时先查它（见 CacheTier.h）。
+    // 传入 nullptr 取消
+    void setSecondTier(std::shared_ptr<CacheTier<Key, Value>> tier) {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        tier_ = std::move(tier);
+    }
+
+    // 删除数据（二级缓存中的旧值一起作废）
+    void remove(const Key& key) {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        invalidateTier(key);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) {
+            return;
+        }
+        NodePtr node = it->second;
+        notifier_.record(node->key, node->value, RemovalCause::Explicit);
+        removeInternal(node);
+        stats_.recordRemoval();
+    }
+
+    // 维护接口：不等下一次 get/put，立即回收所有已到期的条目，返回回收的个数
+    size_t purgeExpired() {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return reclaimExpired();
+    }
+
+    // 当前所有条目的权重之和；没有 weigher 时就是条目个数
+    size_t totalWeight() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return totalWeight_;
+    }
+
+    // 时间轮里还没触发的到期记录数（包括已经过时的）
+    size_t scheduledExpirations() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return timingWheel_.size();
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    // 快照：按淘汰顺序（频次从低到高，同频次内从久到新）写出每个条目和它的有效频次。
+    // 带 TTL 的条目记录剩余时间，已到期的不写。写出期间持有锁
+    bool saveSnapshot(const std::string& path);
+
+    // 用快照替换当前内容：整个加载过程只加一次锁，按频次直接挂到对应的频率链表上。
+    // 快照比容量大时，频次最低的一端被淘汰。文件损坏时已读出的条目保留，返回 false
+    bool loadSnapshot(const std::string& path);
+
     // 清空缓存，回收资源
     void purge() {
-        // .clear() 是 C++中容器的清除函数，如map, set, string, vector, list 等
-        nodeMap_.clear(); // 清空键值对
-        freqToFreqList_.clear();  // 清空映射
-
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        clearInternal();
     }
 
 // 私有成员变量
 private:
-    int capacity_;
-    int minFreq_;  // 当前最小访问频次，用于找到需要淘汰的节点
+    void clearInternal() {
+        // .clear() 是 C++中容器的清除函数，如map, set, string, vector, list 等
+        nodeMap_.clear(); // 清空键值对
+        timingWheel_.clear(); // 到期记录一起清掉，否则之后每次 get/put 都要推进时间轮把它们逐个丢弃
+        // 释放所有频率链表（包括池中的空链表）
+        while (headList_) {
+            FreqList<Key, Value>* next = headList_->nextList_;
+            delete headList_;
+            headList_ = next;
+        }
+        floorList_ = nullptr;
+        for (auto list : freeLists_) {
+            delete list;
+        }
+        freeLists_.clear();
+        curAverageNum_ = 0;
+        curTotalNum_ = 0;
+        totalWeight_ = 0;
+        freqOffset_ = 0;
+    }
+
+    size_t capacity_;    // 总权重上限；没有 weigher 时就是条目个数
+    size_t totalWeight_; // 当前所有条目的权重之和
+    Weigher<Key, Value> weigher_;
     int maxAverageNum_;
-    int curAverageNum_;
-    int curTotalNum_;
+    int64_t curAverageNum_;
+    int64_t curTotalNum_;
+    // 老化基准：每次老化只把它增大 maxAverageNum_ / 2，节点的有效频次为 max(1, freq - freqOffset_)，
+    // 这样老化是 O(1) 的，不需要遍历所有节点
+    int64_t freqOffset_;
     std::mutex mutex_;
     NodeMap nodeMap_; //存储键到缓存节点的映射
-    // 存储 频率到频率链表的映射: key是访问频次，Value是指向一个 FreqList 对象的指针
-    std::unordered_map<int, FreqList<Key, Value>*> freqToFreqList_;
+    // 非空的频率链表按频次升序串成双向链表：headList_ 就是最小频次，用于淘汰
+    FreqList<Key, Value>* headList_;
+    // 频次不超过老化基准 freqOffset_ + 1 的最后一个链表（新节点插入的位置），可能为空
+    FreqList<Key, Value>* floorList_;
+    // 回收的空链表，复用其哨兵节点，避免反复分配
+    std::vector<FreqList<Key, Value>*> freeLists_;
+    std::vector<const NodePtr*> batchNodes_; // getMany 的查找结果，复用以避免每批分配
+    std::vector<size_t> batchHashes_; // getMany 预先算好的哈希值
+    CacheStats stats_;
+    TimingWheel<Key> timingWheel_; // 驱动 TTL 过期
+    std::shared_ptr<CacheTier<Key, Value>> tier_; // 二级缓存，可以为空
+    // 正在从二级缓存取回的 key：inFlight 是进行中的取回个数，writes 是取回期间对它的写入次数
+    struct Promotion {
+        size_t inFlight = 0;
+        uint64_t writes = 0;
+    };
+    std::unordered_map<Key, Promotion> promotions_;
+    RemovalNotifier<Key, Value> notifier_; // 删除通知：锁内记录，锁外投递
     
 
 // 私有方法声明 
 private:
-    void putInternal(Key key, Value value); // 添加缓存
-    void getInternal(NodePtr node, Value& value); // 获取缓存
-    void kickOut(); // 移除缓存中的过期数据
+    void putInternal(NodePtr node); // 添加缓存
+    void invalidateTier(const Key& key); // 写入和删除时作废二级缓存中的旧值
+    void recordWrite(const Key& key); // 给正在取回这个 key 的读者记一次写入
+    uint64_t beginPromotion(const Key& key); // 登记一次即将进行的二级缓存取回，返回此刻的写入计数
+    bool endPromotion(const Key& key, uint64_t writes); // 取回结束，返回期间这个 key 有没有被写入
+    bool promoteFromTier(CacheTier<Key, Value>& tier, Key key, Value& value, uint64_t writes); // 从二级缓存取回并放回内存
+    void updateInternal(NodePtr node, Value value, uint64_t expireAt); // 更新已有缓存的值
+    void removeInternal(const NodePtr& node); // 从频率链表和哈希表中删除节点
+    size_t weigh(const Key& key, const Value& value) const; // 计算条目权重
+    void getInternal(const NodePtr& node, Value& value); // 获取缓存
+    void increaseFreq(const NodePtr& node); // 访问一次：频次加一
+    void kickOut(const Node* keep = nullptr); // 淘汰频次最低的数据，跳过 keep
+    size_t reclaimExpired(); // 推进时间轮，批量回收 TTL 到期的数据
+    void scheduleExpiry(Node& node, uint64_t deadline); // 在时间轮里登记到期时间，每个节点最多一条有效记录
     void removeFromFreqList(NodePtr node); // 从频率列表中移除节点
-    void addToFreqList(NodePtr node); // 添加到频率列表
+    FreqList<Key, Value>* insertListAfter(FreqList<Key, Value>* prev, int64_t freq); // 新建（或复用）一个频率链表
+    void recycleList(FreqList<Key, Value>* list); // 回收空的频率链表
     void addFreqNum(); // 增加平均访问等频率
-    void decreaseFreqNum(int num); // 减少平均访问等频率
+    void decreaseFreqNum(int64_t num); // 减少平均访问等频率
+    int64_t effectiveFreq(const NodePtr& node) const; // 扣除老化基准后的有效频次
     void handleOverMaxAverageNum(); // 处理当前平均访问频率超过上限的情况
-    void updateMinFreq();
+    void advanceFloorList(); // 老化基准变化后移动 floorList_
 
 
 };
 
+template<typename Key, typename Value>
+bool LfuCache<Key, Value>::saveSnapshot(const std::string& path)
+{
+    NotifyScope<Key, Value> notify(notifier_);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    reclaimExpired();
+    SnapshotWriter out(path, SnapshotPolicy::Lfu);
+    for (FreqList<Key, Value>* list = headList_; list; list = list->nextList_) {
+        for (Node* node = list->head_->next.get(); node != list->tail_.get(); node = node->next.get()) {
+            uint64_t ttlMs = 0;
+            if (node->expireAt != 0) {
+                ttlMs = std::chrono::ceil<std::chrono::milliseconds>(timingWheel_.remaining(node->expireAt)).count();
+                if (ttlMs == 0) continue;
+            }
+            out.writePod<uint64_t>(std::max<int64_t>(node->freq - freqOffset_, 1));
+            out.writePod(ttlMs);
+            Serializer<Key>::write(out, node->key);
+            Serializer<Value>::write(out, node->value);
+            out.endRecord();
+        }
+    }
+    return out.finish();
+}
+
+// 快照按频次升序排列，每个节点只可能挂到最后一个链表或在它之后新建的链表上，O(1)
+template<typename Key, typename Value>
+bool LfuCache<Key, Value>::loadSnapshot(const std::string& path)
+{
+    SnapshotReader in(path, SnapshotPolicy::Lfu);
+    if (!in.ok()) return false;
+
+    NotifyScope<Key, Value> notify(notifier_);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    clearInternal();
+    if (capacity_ == 0) return true;
+    // 每条记录至少有频次和剩余 TTL 两个 8 字节字段，文件头里的条目数不可信
+    uint64_t count = in.boundedCount(2 * sizeof(uint64_t));
+    nodeMap_.reserve(weigher_ ? count : std::min<uint64_t>(count, capacity_));
+    FreqList<Key, Value>* last = nullptr; // 频次最高的链表
+    bool ok = true;
+    for (uint64_t i = 0; i < in.count(); ++i) {
+        uint64_t freq, ttlMs;
+        NodePtr node = std::make_shared<Node>();
+        if (!in.readPod(freq) || !in.readPod(ttlMs) ||
+            !Serializer<Key>::read(in, node->key) || !Serializer<Value>::read(in, node->value)) {
+            ok = false;
+            break;
+        }
+        if (nodeMap_.count(node->key)) continue; // 损坏的快照里重复的 key
+        invalidateTier(node->key);
+
+        size_t weight = weigh(node->key, node->value);
+        if (weight > capacity_) {
+            stats_.recordRejection();
+            continue;
+        }
+        while (totalWeight_ + weight > capacity_ && headList_) {
+            kickOut();
+        }
+        // 淘汰总是从最低频次开始，last 只有在所有链表都被清空时才会被回收
+        if (!headList_) last = nullptr;
+
+        node->weight = weight;
+        totalWeight_ += weight;
+        node->freq = std::max<int64_t>(static_cast<int64_t>(freq), last ? last->getFreq() : 1);
+        if (!last || last->getFreq() != node->freq) {
+            last = insertListAfter(last, node->freq);
+        }
+        last->addNode(node);
+        if (ttlMs != 0) {
+            node->expireAt = timingWheel_.deadlineAfter(std::chrono::milliseconds(ttlMs));
+            scheduleExpiry(*node, node->expireAt);
+        }
+        nodeMap_.emplace(node->key, node);
+        stats_.recordInsert();
+        curTotalNum_ += node->freq;
+    }
+    curAverageNum_ = nodeMap_.empty() ? 0 : curTotalNum_ / static_cast<int64_t>(nodeMap_.size());
+    return ok;
+}
+
 // 处理 缓存读取（get） 操作：根据提供的 node，返回对应的 value
 template<typename Key, typename Value>
-void LfuCache<Key, Value>::getInternal(NodePtr node, Value& value){
+void LfuCache<Key, Value>::getInternal(const NodePtr& node, Value& value){
 
     value = node->value;
+    increaseFreq(node);
+}
+
+template<typename Key, typename Value>
+void LfuCache<Key, Value>::increaseFreq(const NodePtr& node){
+
+    // 老化后有效频次已降到 1 的节点，先对齐到基准再加一
+    int64_t floor = freqOffset_ + 1;
+    FreqList<Key, Value>* cur = node->owner;
+    FreqList<Key, Value>* target;
+    if (node->freq >= floor) {
+        // 频次加一：目标链表只可能是当前链表的下一个
+        node->freq++;
+        target = cur->nextList_;
+        if (!target || target->getFreq() != node->freq)
+            target = insertListAfter(cur, node->freq);
+    } else {
+        // 频次对齐到 floor + 1：目标链表紧跟在 floorList_ 之后
+        node->freq = floor + 1;
+        target = floorList_ ? floorList_->nextList_ : headList_;
+        if (!target || target->getFreq() != node->freq)
+            target = insertListAfter(floorList_, node->freq);
+    }
+
     removeFromFreqList(node);
-    node->freq++;
-    addToFreqList(node);
-    if (node->freq - 1 == minFreq_ && freqToFreqList_[node->freq - 1]->isEmpty())
-    minFreq_++;
+    target->addNode(node);
     addFreqNum();
 }
 
+// 新值之后可能不经过 offer 就离开内存（TTL 到期、变重被拒绝），旧值留在二级缓存里，
+// 下一次未命中就会把它读回来。调用者持有锁
 template<typename Key, typename Value>
-void LfuCache<Key, Value>::putInternal(Key key, Value value) {
-    if(nodeMap_.size() == capacity_){
-        // 如果缓存已满，调用 kickOut() 函数移除最不常访问的节点
-        kickOut();
+void LfuCache<Key, Value>::invalidateTier(const Key& key) {
+    if (tier_) tier_->erase(key);
+    recordWrite(key);
+}
+
+// put、replace、remove 都算写入。调用者持有锁
+template<typename Key, typename Value>
+void LfuCache<Key, Value>::recordWrite(const Key& key) {
+    if (promotions_.empty()) {
+        return;
+    }
+    auto it = promotions_.find(key);
+    if (it != promotions_.end()) {
+        ++it->second.writes;
     }
-    // 构造新节点，包含 key 和 value，并将其加入缓存的 nodeMap_
-    NodePtr node = std::make_shared<Node>(key, value);
-    nodeMap_[key] = node;
+}
+
+template<typename Key, typename Value>
+uint64_t LfuCache<Key, Value>::beginPromotion(const Key& key) {
+    Promotion& promotion = promotions_[key];
+    ++promotion.inFlight;
+    return promotion.writes;
+}
+
+template<typename Key, typename Value>
+bool LfuCache<Key, Value>::endPromotion(const Key& key, uint64_t writes) {
+    auto it = promotions_.find(key);
+    bool written = it->second.writes != writes;
+    if (--it->second.inFlight == 0) {
+        promotions_.erase(it);
+    }
+    return written;
+}
+
+// 在不持锁时调用，之前已经 beginPromotion 登记过，writes 是它的返回值。取回期间 key 被重新写入时
+// 以内存中的值为准；期间这个 key 被写入或 remove 过、又已经不在内存里时只返回值、不放回内存：
+// 新值可能已经被淘汰进二级缓存，被删除的 key 也不该因为这次读取回到缓存里。写别的 key 不影响这次取回
+template<typename Key, typename Value>
+bool LfuCache<Key, Value>::promoteFromTier(CacheTier<Key, Value>& tier, Key key, Value& value, uint64_t writes) {
+    bool found = tier.take(key, value);
+    TimedLockGuard<std::mutex> lock(mutex_, stats_);
+    bool written = endPromotion(key, writes);
+    if (!found) {
+        return false;
+    }
+    auto it = nodeMap_.find(key);
+    if (it != nodeMap_.end()) {
+        getInternal(it->second, value);
+        return true;
+    }
+    if (!written && capacity_ > 0) {
+        putInternal(std::make_shared<Node>(std::move(key), value));
+    }
+    return true;
+}
 
-    addToFreqList(node);
+template<typename Key, typename Value>
+void LfuCache<Key, Value>::putInternal(NodePtr node) {
+    // 单个条目比整个缓存还重：拒绝写入
+    size_t weight = weigh(node->key, node->value);
+    if (weight > capacity_) {
+        stats_.recordRejection();
+        return;
+    }
+    stats_.recordInsert();
+    // 如果放不下，调用 kickOut() 函数移除最不常访问的节点，直到放得下为止
+    while (totalWeight_ + weight > capacity_ && headList_) {
+        kickOut();
+    }
+    node->weight = weight;
+    totalWeight_ += weight;
+    // 新节点（包含 key 和 value）由调用者构造，这里将其加入缓存的 nodeMap_
+    // 新节点的有效频次为 1
+    node->freq = freqOffset_ + 1;
+    nodeMap_.emplace(node->key, node);
+
+    FreqList<Key, Value>* target = floorList_;
+    if (!target || target->getFreq() != node->freq)
+        target = insertListAfter(floorList_, node->freq);
+    target->addNode(node);
     addFreqNum();
-    // 对于新插入的节点，最小频率设置为 1
-    minFreq_ = std::min(minFreq_, 1);
+}
+
+// 新值的权重超过总容量时拒绝写入，旧值也一并删除。
+// 新值变重时淘汰其他数据腾出空间，被更新的节点即使频次仍然最低也保留（和 LruCache 一致）
+template<typename Key, typename Value>
+void LfuCache<Key, Value>::updateInternal(NodePtr node, Value value, uint64_t expireAt) {
+    size_t weight = weigh(node->key, value);
+    if (weight > capacity_) {
+        notifier_.record(node->key, node->value, RemovalCause::Evicted);
+        removeInternal(node);
+        stats_.recordRejection();
+        return;
+    }
 
+    stats_.recordUpdate();
+    notifier_.record(node->key, node->value, RemovalCause::Replaced);
+    totalWeight_ = totalWeight_ - node->weight + weight;
+    node->weight = weight;
+    node->value = std::move(value);
+    node->expireAt = expireAt;
+    increaseFreq(node);
+    // node 单独放得下（weight <= capacity_），所以超重时一定还有别的节点可以淘汰
+    while (totalWeight_ > capacity_ && headList_) {
+        kickOut(node.get());
+    }
 }
 
-// 根据 minFreq_ 找到访问频率最低的节点并删除
 template<typename Key, typename Value>
-void LfuCache<Key, Value>::kickOut() {
-    NodePtr node = freqToFreqList_[minFreq_]->getFirstNode();
+void LfuCache<Key, Value>::removeInternal(const NodePtr& node) {
     removeFromFreqList(node);
+    totalWeight_ -= node->weight;
+    decreaseFreqNum(effectiveFreq(node));
+    // 最后从哈希表删除：node 可能就是表中元素的引用，删除后失效
     nodeMap_.erase(node->key);
-    decreaseFreqNum(node->freq);
+}
 
+template<typename Key, typename Value>
+size_t LfuCache<Key, Value>::weigh(const Key& key, const Value& value) const {
+    return weigher_ ? weigher_(key, value) : 1;
 }
 
+// 没有带 TTL 的条目时不读时钟；到期 tick 和节点当前那条记录不一致说明是过时的记录
 template<typename Key, typename Value>
-void LfuCache<Key, Value>::removeFromFreqList(NodePtr node)
-{
-    if(!node){
+size_t LfuCache<Key, Value>::reclaimExpired() {
+    if (timingWheel_.empty()) {
+        return 0;
+    }
+    size_t reclaimed = 0;
+    timingWheel_.advance([this, &reclaimed](const Key& key, uint64_t deadline) {
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end() || it->second->scheduledAt != deadline) {
+            return;
+        }
+        NodePtr node = it->second;
+        node->scheduledAt = 0;
+        // 到期时间后来被推迟或取消：按现在的到期时间放回去
+        if (node->expireAt != deadline) {
+            if (node->expireAt != 0) {
+                scheduleExpiry(*node, node->expireAt);
+            }
+            return;
+        }
+        notifier_.record(node->key, node->value, RemovalCause::Expired);
+        removeInternal(node);
+        stats_.recordExpiration();
+        ++reclaimed;
+    });
+    return reclaimed;
+}
+
+// 已有一条不晚于 deadline 的记录时不再登记，它触发时发现 expireAt 推后了再放回去；
+// 反复用 TTL 覆盖同一个 key 不会让时间轮越来越大
+template<typename Key, typename Value>
+void LfuCache<Key, Value>::scheduleExpiry(Node& node, uint64_t deadline) {
+    if (node.scheduledAt != 0 && node.scheduledAt <= deadline) {
         return;
     }
+    node.scheduledAt = deadline;
+    timingWheel_.schedule(node.key, deadline);
+}
 
-    auto freq = node->freq;
-    freqToFreqList_[freq]->removeNode(node);
+// 最小频次链表（headList_）中最久未访问的节点就是淘汰对象。
+// 它恰好是 keep 时换成它后面的一个：同一链表的下一个节点，或者下一个链表的第一个节点
+template<typename Key, typename Value>
+void LfuCache<Key, Value>::kickOut(const Node* keep) {
+    if (!headList_) {
+        return;
+    }
+    NodePtr node = headList_->getFirstNode();
+    if (node.get() == keep) {
+        if (node->next != headList_->getTail()) {
+            node = node->next;
+        } else if (headList_->nextList_) {
+            node = headList_->nextList_->getFirstNode();
+        } else {
+            return;
+        }
+    }
+    notifier_.record(node->key, node->value, RemovalCause::Evicted);
+    removeInternal(node);
+    stats_.recordEviction();
+    // 有二级缓存时交给它；带 TTL 的条目不下沉
+    if (tier_ && node->expireAt == 0) {
+        tier_->offer(node->key, std::move(node->value));
+    }
 }
-// 管理节点在访问频率链表中的添加和移除。
+
 template<typename Key, typename Value>
-void LfuCache<Key, Value>::addToFreqList(NodePtr node)
+void LfuCache<Key, Value>::removeFromFreqList(NodePtr node)
 {
-    // 检查结点是否为空
-    if (!node) 
+    if(!node || !node->owner){
         return;
+    }
 
-    // 添加进入相应的频次链表前需要判断该频次链表是否存在
-    auto freq = node->freq;
-    if (freqToFreqList_.find(node->freq) == freqToFreqList_.end())
-    {
-        // 不存在则创建
-        freqToFreqList_[node->freq] = new FreqList<Key, Value>(node->freq);
+    FreqList<Key, Value>* list = node->owner;
+    list->removeNode(node);
+
+    // 空链表从有序链表中摘下，放回池中
+    if (list->isEmpty()) {
+        recycleList(list);
     }
+}
+
+// 在 prev 之后插入一个频次为 freq 的空链表；prev 为空时插在最前面
+template<typename Key, typename Value>
+FreqList<Key, Value>* LfuCache<Key, Value>::insertListAfter(FreqList<Key, Value>* prev, int64_t freq)
+{
+    FreqList<Key, Value>* list;
+    if (!freeLists_.empty()) {
+        list = freeLists_.back();
+        freeLists_.pop_back();
+        list->freq_ = freq;
+    } else {
+        list = new FreqList<Key, Value>(freq);
+    }
+
+    list->prevList_ = prev;
+    list->nextList_ = prev ? prev->nextList_ : headList_;
+    if (list->nextList_) list->nextList_->prevList_ = list;
+    if (prev) prev->nextList_ = list;
+    else headList_ = list;
 
-    freqToFreqList_[freq]->addNode(node);
+    // 维护 floorList_：频次不超过 floor 的最后一个链表
+    if (freq <= freqOffset_ + 1 && (!floorList_ || freq > floorList_->getFreq()))
+        floorList_ = list;
+    return list;
+}
+
+template<typename Key, typename Value>
+void LfuCache<Key, Value>::recycleList(FreqList<Key, Value>* list)
+{
+    if (floorList_ == list) floorList_ = list->prevList_;
+    if (headList_ == list) headList_ = list->nextList_;
+    if (list->prevList_) list->prevList_->nextList_ = list->nextList_;
+    if (list->nextList_) list->nextList_->prevList_ = list->prevList_;
+    list->prevList_ = nullptr;
+    list->nextList_ = nullptr;
+
+    // 池的大小不超过历史上同时存在的链表数，而链表数不超过节点数，因此内存有上界
+    freeLists_.push_back(list);
 }
 
 // 更新总访问频次和平均访问频次，用于统计和优化。
@@ -286,7 +956,7 @@ void LfuCache<Key, Value>::addFreqNum()
     if (nodeMap_.empty())
         curAverageNum_ = 0;
     else
-        curAverageNum_ = curTotalNum_ / nodeMap_.size();
+        curAverageNum_ = curTotalNum_ / static_cast<int64_t>(nodeMap_.size());
 
     if (curAverageNum_ > maxAverageNum_)
     {
@@ -295,60 +965,54 @@ void LfuCache<Key, Value>::addFreqNum()
 }
 
 template<typename Key, typename Value>
-void LfuCache<Key, Value>::decreaseFreqNum(int num)
+void LfuCache<Key, Value>::decreaseFreqNum(int64_t num)
 {
     // 减少平均访问频次和总访问频次
-    curTotalNum_ -= num;
+    curTotalNum_ = std::max<int64_t>(curTotalNum_ - num, 0);
     if (nodeMap_.empty())
         curAverageNum_ = 0;
     else
-        curAverageNum_ = curTotalNum_ / nodeMap_.size();
+        curAverageNum_ = curTotalNum_ / static_cast<int64_t>(nodeMap_.size());
 }
 
+// 当前平均访问频次超过上限时，所有结点的访问频次 - (maxAverageNum_ / 2)。
+// 不再逐个移动节点：只抬高老化基准 freqOffset_，所有节点的有效频次同时下降，O(1)。
+// 节点之间的相对顺序不变，链表也不需要调整；
+// 有效频次降到 1 以下的节点按 1 计算，在下次被访问时才对齐到基准。
 template<typename Key, typename Value>
 void LfuCache<Key, Value>::handleOverMaxAverageNum()
 {
     if (nodeMap_.empty())
         return;
 
-    // 当前平均访问频次已经超过了最大平均访问频次，所有结点的访问频次- (maxAverageNum_ / 2)
-    for (auto it = nodeMap_.begin(); it != nodeMap_.end(); ++it)
-    {
-        // 检查结点是否为空
-        if (!it->second)
-            continue;
-
-        NodePtr node = it->second;
-
-        // 先从当前频率列表中移除
-        removeFromFreqList(node);
-
-        // 减少频率
-        node->freq -= maxAverageNum_ / 2;
-        if (node->freq < 1) node->freq = 1;
+    int64_t delta = std::max(maxAverageNum_ / 2, 1);
+    int64_t size = static_cast<int64_t>(nodeMap_.size());
+    freqOffset_ += delta;
+    advanceFloorList();
 
-        // 添加到新的频率列表
-        addToFreqList(node);
-    }
-
-    // 更新最小频率
-    updateMinFreq();
+    // 每个节点的有效频次至少为 1
+    curTotalNum_ = std::max(curTotalNum_ - delta * size, size);
+    curAverageNum_ = curTotalNum_ / size;
 }
 
+template<typename Key, typename Value>
+int64_t LfuCache<Key, Value>::effectiveFreq(const NodePtr& node) const
+{
+    return std::max<int64_t>(node->freq - freqOffset_, 1);
+}
 
+// floor 增大了 delta，floorList_ 最多向后移动 delta + 1 个链表（频次互不相同），与容量无关
 template<typename Key, typename Value>
-void LfuCache<Key, Value>::updateMinFreq() 
+void LfuCache<Key, Value>::advanceFloorList()
 {
-    minFreq_ = INT8_MAX;
-    for (const auto& pair : freqToFreqList_) 
-    {
-        if (pair.second && !pair.second->isEmpty()) 
-        {
-            minFreq_ = std::min(minFreq_, pair.first);
-        }
+    int64_t floor = freqOffset_ + 1;
+    FreqList<Key, Value>* next = floorList_ ? floorList_->nextList_ : headList_;
+    while (next && next->getFreq() <= floor) {
+        floorList_ = next;
+        next = next->nextList_;
     }
-    if (minFreq_ == INT8_MAX) 
-        minFreq_ = 1;
 }
 
+} // inline namespace KAMACACHE_STATS_ABI
+
 } // namespace KamaCache
@@ -6,12 +6,21 @@
 */
 
 // make_shared()
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <mutex>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "CacheTier.h"
+#include "FlatHashMap.h"
 #include "KICachePolicy.h"
+#include "Snapshot.h"
+#include "TimingWheel.h"
 
 
 using namespace std;
@@ -19,6 +28,7 @@ using namespace std;
 
 namespace KamaCache 
 {
+inline namespace KAMACACHE_STATS_ABI {
 
 // 1. 定义Cache 节点类
 template <typename Key, typename Value>
@@ -28,6 +38,9 @@ private:
     Key key_;
     Value value_;
     size_t accessCount_;
+    uint64_t expireAt_;  // TTL 到期的 tick，0 表示不过期
+    uint64_t scheduledAt_; // 时间轮里这个节点唯一有效记录的到期 tick，0 表示没有记录
+    size_t weight_;      // 条目权重，由缓存的 weigher 计算
     // 创建两个只能指针，用做双向链表的指针
     std::shared_ptr<LruNode<Key, Value>> prev_;
     std::shared_ptr<LruNode<Key, Value>> next_;
@@ -36,25 +49,141 @@ private:
 public:
     // 1. 类的构造函数，与类名一样
     LruNode(Key key, Value value):
-    key_(key),
-    value_(value),
+    key_(std::move(key)),
+    value_(std::move(value)),
     accessCount_(1),
+    expireAt_(0),
+    scheduledAt_(0),
+    weight_(1),
+    prev_(nullptr),
+    next_(nullptr)
+    {}
+
+    // 原地构造 value，供 emplace 使用
+    template <typename... Args>
+    LruNode(Key key, std::in_place_t, Args&&... args):
+    key_(std::move(key)),
+    value_(std::forward<Args>(args)...),
+    accessCount_(1),
+    expireAt_(0),
+    scheduledAt_(0),
+    weight_(1),
     prev_(nullptr),
     next_(nullptr)
     {}
 
     // 2. 提供必要的访问器： 为了确保成员变量的可读性
-    Key getKey() const {return key_;}
-    Value getValue() const {return value_;}
-    void setValue(const Value& value) {value_ = value;}
+    // 返回引用，避免每次访问都拷贝 key 和 value
+    const Key& getKey() const {return key_;}
+    const Value& getValue() const {return value_;}
+    void setValue(Value value) {value_ = std::move(value);}
     size_t getAccessCount() const {return accessCount_;}
     void increaseAccessCount() {++accessCount_;}
+    void setAccessCount(size_t count) {accessCount_ = count;}
 
     // friend class LruCache<Key, Value>;
     template <typename K, typename V>
     friend class LruCache; // 修正 friend 声明
+    template <typename K, typename V>
+    friend class LruList;  // ARC、LRU-K 复用同样的节点和链表
+};
+
+// 基于 LruNode 的双向链表，和 LruCache 的链表操作一致，供 ArcCache、LruKCache 复用
+template <typename Key, typename Value>
+class LruList {
+public:
+    using NodePtr = std::shared_ptr<LruNode<Key, Value>>;
+
+    LruList() : size_(0) {
+        dummyHead_ = std::make_shared<LruNode<Key, Value>>(Key(), Value());
+        dummyTail_ = std::make_shared<LruNode<Key, Value>>(Key(), Value());
+        dummyHead_->next_ = dummyTail_;
+        dummyTail_->prev_ = dummyHead_;
+    }
+
+    ~LruList() {
+        // 断开 shared_ptr 的环，避免内存泄漏
+        NodePtr node = dummyHead_;
+        while (node) {
+            NodePtr next = node->next_;
+            node->prev_.reset();
+            node->next_.reset();
+            node = next;
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    // 插入到尾部（最近访问）
+    void pushBack(NodePtr node) {
+        node->next_ = dummyTail_;
+        node->prev_ = dummyTail_->prev_;
+        dummyTail_->prev_->next_ = node;
+        dummyTail_->prev_ = node;
+        ++size_;
+    }
+
+    void remove(NodePtr node) {
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        node->prev_.reset();
+        node->next_.reset();
+        --size_;
+    }
+
+    // 移到尾部：直接改指针，不经过 reset，少几次引用计数操作
+    void moveToBack(const NodePtr& node) {
+        if (node == dummyTail_->prev_) return;
+        node->prev_->next_ = node->next_;
+        node->next_->prev_ = node->prev_;
+        node->next_ = dummyTail_;
+        node->prev_ = dummyTail_->prev_;
+        dummyTail_->prev_->next_ = node;
+        dummyTail_->prev_ = node;
+    }
+
+    // 头部（最久未使用）节点，链表为空时返回 nullptr
+    NodePtr front() const {
+        return size_ == 0 ? nullptr : dummyHead_->next_;
+    }
+
+    // 弹出头部（最久未使用）
+    NodePtr popFront() {
+        if (size_ == 0) return nullptr;
+        NodePtr node = dummyHead_->next_;
+        remove(node);
+        return node;
+    }
+
+    // 从头部（最久未使用）到尾部依次访问每个节点
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (LruNode<Key, Value>* node = dummyHead_->next_.get(); node != dummyTail_.get(); node = node->next_.get()) {
+            fn(*node);
+        }
+    }
+
+    // 摘下所有节点，同时断开它们之间的 shared_ptr
+    void clear() {
+        NodePtr node = dummyHead_->next_;
+        while (node != dummyTail_) {
+            NodePtr next = node->next_;
+            node->prev_.reset();
+            node->next_.reset();
+            node = next;
+        }
+        dummyHead_->next_ = dummyTail_;
+        dummyTail_->prev_ = dummyHead_;
+        size_ = 0;
+    }
+
+private:
+    NodePtr dummyHead_;
+    NodePtr dummyTail_;
+    size_t size_;
 };
 
+
 template<typename Key, typename Value>
 // 继承时，要传递递模板参数<>，这样基类能知道键值类型
 class LruCache : public KICachePolicy<Key, Value>
@@ -63,6 +192,8 @@ class LruCache : public KICachePolicy<Key, Value>
 // 在main里，创建示例要这样：
 // 创建一个容量为 3 的 LRU 缓存，Key 类型为 int，Value 类型为 std::string
 // LruCache<int, std::string> cache(3);  括号里是构造函数里定义的capacity_
+// 按字节限制容量时传入 weigher：
+// LruCache<int, std::string> cache(64 << 20, [](const int&, const std::string& v) { return v.size(); });
 
 public:
 
@@ -71,72 +202,354 @@ public:
     using LruNodeType = LruNode<Key, Value>;
     // 这个是指向链表的指针
     using NodePtr = std::shared_ptr<LruNodeType>;
-    // 定义一个关联容器unordered map，里面有Key和Value，Value是一个链表指针类型
-    using NodeMap = std::unordered_map<Key, NodePtr>;
+    // 定义一个关联容器，里面有Key和Value，Value是一个链表指针类型。
+    // FlatHashMap 是开放寻址的哈希表，节点指针直接存在槽位里；KeyHash/KeyEqual 支持异构查找（如用 std::string_view 查 std::string）
+    using NodeMap = FlatHashMap<Key, NodePtr, KeyHash<Key>, KeyEqual>;
 
 
     // 1. 构造函数
-    LruCache(int capacity) : capacity_(capacity) {
+    LruCache(int capacity) : capacity_(capacity > 0 ? capacity : 0), totalWeight_(0) {
         // 用来创建虚拟链表
         initializeList();
     }
 
+    // 按权重限制容量：maxWeight 是所有条目权重之和的上限
+    LruCache(size_t maxWeight, Weigher<Key, Value> weigher)
+    : capacity_(maxWeight), totalWeight_(0), weigher_(std::move(weigher)) {
+        initializeList();
+    }
+
     ~LruCache() override = default;
 
 
     // 2. 业务逻辑：插入数据
     void put(Key key, Value value){
         // 如果缓存为0，直接返回，不执行操作
-        if(capacity_ <= 0) return;
-
-        // 使用 std::lock_guard，自动加锁，代替了手动加锁
-        std::lock_guard<std::mutex> lock(mutex_);
+        if(capacity_ == 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        // 使用 TimedLockGuard 自动加锁（和 std::lock_guard 一样），开启统计时顺便记录等锁耗时
+        // notify 先于锁构造、后于锁析构：这次操作产生的删除通知在解锁之后才投递
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        invalidateTier(key);
         // 在哈希表中找key
         auto it = nodeMap_.find(key);
 
         // 如果找到了key，就更新节点，并将节点移动到链表头部，标记为最近使用
         if(it != nodeMap_.end()){
-            updateExistingNode(it->second, value);
+            updateExistingNode(it, std::move(value));
             return;
         }
 
-        addNewNode(key, value);  // 如果key不存在，就add new
+        addNewNode(std::move(key), std::move(value));  // 如果key不存在，就add new
     }
 
-    // 3. 获取数据
-    bool get(Key key, Value& value) override {
+    // 带过期时间的插入：ttl 之后条目由时间轮主动回收，不再占用容量。
+    // 不带 ttl 的 put 会把已有条目改回不过期
+    void put(Key key, Value value, std::chrono::milliseconds ttl){
+        if(capacity_ == 0) return;
 
-        // 1. 加锁保护共享资源（如 nodeMap_ 和链表）不被多个线程同时修改
-        std::lock_guard<std::mutex> lock(mutex_);
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        invalidateTier(key);
+        uint64_t deadline = timingWheel_.deadlineAfter(ttl);
 
-        // 在哈希表 nodeMap_ 中查找键 key 是否存在，返回迭代器it
+        LruNodeType* node;
         auto it = nodeMap_.find(key);
+        if(it != nodeMap_.end()){
+            node = updateExistingNode(it, std::move(value));
+        } else {
+            node = addNewNode(std::move(key), std::move(value));
+        }
+        if(node){
+            node->expireAt_ = deadline;
+            scheduleExpiry(*node, deadline);
+        }
+    }
+
+    // 原地构造 value：key 已存在时用参数构造新值替换旧值
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        if(capacity_ == 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        invalidateTier(key);
+        auto it = nodeMap_.find(key);
+        if(it != nodeMap_.end()){
+            updateExistingNode(it, Value(std::forward<Args>(args)...));
+            return;
+        }
+
+        // 先原地构造，才能计算权重
+        NodePtr newNode = std::make_shared<LruNodeType>(key, std::in_place, std::forward<Args>(args)...);
+        size_t weight = weigh(newNode->getKey(), newNode->getValue());
+        if(weight > capacity_){
+            stats_.recordRejection();
+            return;
+        }
+        stats_.recordInsert();
+        evictUntilFits(weight);
+        newNode->weight_ = weight;
+        totalWeight_ += weight;
+        insertNode(newNode);
+        nodeMap_.emplace(std::move(key), std::move(newNode));
+    }
 
-        // 如果找到了key
-        if (it != nodeMap_.end()) {
-            moveToMostRecent(it->second); // 将节点移动到链表头部
-            value = it->second->getValue(); // 通过引用参数返回值
-            return true; // 返回成功
+    // 3. 获取数据
+    bool get(const Key& key, Value& value) override {
+        return get<Key>(key, value);
+    }
+
+    // 异构查找：K 可以是任何能与 Key 比较的类型，例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
+
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        std::shared_ptr<CacheTier<Key, Value>> tier;
+        uint64_t writes;
+        {
+            // 1. 加锁保护共享资源（如 nodeMap_ 和链表）不被多个线程同时修改
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            // 先回收已到期的条目，保证不会返回过期数据
+            reclaimExpired();
+
+            // 在哈希表 nodeMap_ 中查找键 key 是否存在，返回迭代器it
+            auto it = findKey(nodeMap_, key);
+
+            // 如果找到了key
+            if (it != nodeMap_.end()) {
+                moveToMostRecent(it->second); // 将节点移动到链表头部
+                value = it->second->getValue(); // 通过引用参数返回值
+                stats_.recordHit();
+                return true; // 返回成功
+            }
+            stats_.recordMiss();
+            if (!tier_) return false;
+            tier = tier_;
+            writes = beginPromotion(Key(key));
         }
-        return false;
+        // 内存未命中：释放锁之后再查二级缓存
+        return promoteFromTier(*tier, Key(key), value, writes);
 
     }
 
     // 第二个get函数
-    Value get(Key key) override {
+    Value get(const Key& key) override {
         Value value{}; // 构造函数，设置初始，比如0或空字符串" "
         get(key, value);
         return value;
     }
 
+    // 零拷贝读取：命中时在持锁状态下把值的 const 引用交给 visitor
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 二级缓存命中时 visitor 在锁外被调用，拿到的是取回的值
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        std::shared_ptr<CacheTier<Key, Value>> tier;
+        uint64_t writes;
+        {
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            reclaimExpired();
+            auto it = findKey(nodeMap_, key);
+            if (it != nodeMap_.end()) {
+                moveToMostRecent(it->second);
+                visitor(it->second->getValue());
+                stats_.recordHit();
+                return true;
+            }
+            stats_.recordMiss();
+            if (!tier_) return false;
+            tier = tier_;
+            writes = beginPromotion(Key(key));
+        }
+        Value value;
+        if (!promoteFromTier(*tier, Key(key), value, writes)) return false;
+        visitor(static_cast<const Value&>(value));
+        return true;
+    }
+
+
+    // 批量获取：整批只加一次锁。
+    // 先算出所有哈希值；第一遍查找第 j 个 key 时预取后面第 kPrefetchDistance 个 key 的哈希槽，
+    // 并预取命中的节点，第二遍再统一更新链表、拷贝值
+    // 挂了二级缓存时，未命中的 key 在释放锁之后逐个到二级缓存中查找
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* hits) override {
+        return getManyAt(keys, count, values, hits, [](size_t j) { return j; });
+    }
+
+    // 只处理 indices 指出的位置：第 j 个 key 是 keys[indices[j]]，结果写回 values、hits 的同一位置。
+    // 分片缓存把下标按分片分组后直接传进来，不用拷贝 key 和值
+    size_t getMany(const Key* keys, const size_t* indices, size_t count, Value* values, bool* hits) {
+        return getManyAt(keys, count, values, hits, [indices](size_t j) { return indices[j]; });
+    }
+
+    // 只在 key 已存在时替换它的值，返回是否存在。不算一次访问：LRU 位置、TTL 和命中统计都不变，
+    // 供后台刷新这类"值过时了、但没有人读它"的写入使用。新值变重时淘汰其他条目，不淘汰它自己
+    bool replace(const Key& key, Value value){
+        return replaceIf(key, std::move(value), [](const Value&) { return true; });
+    }
 
-    // 4. 删除数据
-    void remove(Key key){
-        std::lock_guard<std::mutex> lock(mutex_);
+    // 比较后替换：key 存在且 expected(当前值) 为 true 时才替换，返回是否替换（或因新值过重而删除）。
+    // expected 在持锁期间被调用，后台刷新用它确认加载期间条目没有被别的写入换掉
+    template <typename Expected>
+    bool replaceIf(const Key& key, Value value, Expected expected){
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        auto it = nodeMap_.find(key);
+        if(it == nodeMap_.end() || !expected(it->second->getValue())) return false;
+        recordWrite(key);
+
+        const NodePtr& node = it->second;
+        size_t weight = weigh(node->getKey(), value);
+        if(weight > capacity_){
+            notifier_.record(node->getKey(), node->getValue(), RemovalCause::Evicted);
+            removeNode(node);
+            totalWeight_ -= node->weight_;
+            nodeMap_.erase(it);
+            stats_.recordRejection();
+            return true;
+        }
+        stats_.recordUpdate();
+        notifier_.record(node->getKey(), node->getValue(), RemovalCause::Replaced);
+        totalWeight_ = totalWeight_ - node->weight_ + weight;
+        node->weight_ = weight;
+        node->setValue(std::move(value));
+        LruNodeType* kept = node.get(); // 淘汰会移动哈希表中的元素，node 这个引用之后失效
+        while(totalWeight_ > capacity_){
+            evictLeastRecent(kept);
+        }
+        return true;
+    }
+
+    // 批量插入：整批只加一次锁
+    void putMany(const Key* keys, const Value* values, size_t count) override {
+        putManyAt(keys, values, count, [](size_t j) { return j; });
+    }
+
+    // 只写入 indices 指出的位置：第 j 个条目是 (keys[indices[j]], values[indices[j]])
+    void putMany(const Key* keys, const Value* values, const size_t* indices, size_t count) {
+        putManyAt(keys, values, count, [indices](size_t j) { return indices[j]; });
+    }
+
+    // 维护接口：不等下一次 get/put，立即回收所有已到期的条目，返回回收的个数。
+    // 可以由后台线程定期调用
+    size_t purgeExpired(){
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return reclaimExpired();
+    }
+
+    // 当前所有条目的权重之和；没有 weigher 时就是条目个数
+    size_t totalWeight(){
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return totalWeight_;
+    }
+
+    // 时间轮里还没触发的到期记录数（包括已经过时的）
+    size_t scheduledExpirations(){
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return timingWheel_.size();
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    // 快照：从最久未使用到最近使用依次写出，加载时按同样的顺序插入，恢复原来的 LRU 顺序。
+    // 带 TTL 的条目记录剩余时间，已到期的不写。写出期间持有锁
+    bool saveSnapshot(const std::string& path){
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        SnapshotWriter out(path, SnapshotPolicy::Lru);
+        for(LruNodeType* node = dummyHead_->next_.get(); node != dummyTail_.get(); node = node->next_.get()){
+            uint64_t ttlMs = 0;
+            if(node->expireAt_ != 0){
+                ttlMs = std::chrono::ceil<std::chrono::milliseconds>(timingWheel_.remaining(node->expireAt_)).count();
+                if(ttlMs == 0) continue;
+            }
+            out.writePod(ttlMs);
+            Serializer<Key>::write(out, node->key_);
+            Serializer<Value>::write(out, node->value_);
+            out.endRecord();
+        }
+        return out.finish();
+    }
+
+    // 用快照替换当前内容：整个加载过程只加一次锁。
+    // 快照比容量大时，最久未使用的一端被淘汰。文件损坏时已读出的条目保留，返回 false
+    bool loadSnapshot(const std::string& path){
+        SnapshotReader in(path, SnapshotPolicy::Lru);
+        if(!in.ok()) return false;
+
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        clearInternal();
+        if(capacity_ == 0) return true;
+        // 每条记录至少有 8 字节的剩余 TTL，文件头里的条目数不可信
+        uint64_t count = in.boundedCount(sizeof(uint64_t));
+        nodeMap_.reserve(weigher_ ? count : std::min<uint64_t>(count, capacity_));
+        for(uint64_t i = 0; i < in.count(); ++i){
+            uint64_t ttlMs;
+            Key key;
+            Value value;
+            if(!in.readPod(ttlMs) || !Serializer<Key>::read(in, key) || !Serializer<Value>::read(in, value)){
+                return false;
+            }
+            invalidateTier(key);
+            LruNodeType* node;
+            auto it = nodeMap_.find(key);
+            if(it != nodeMap_.end()){
+                node = updateExistingNode(it, std::move(value));
+            } else {
+                node = addNewNode(std::move(key), std::move(value));
+            }
+            if(node && ttlMs != 0){
+                node->expireAt_ = timingWheel_.deadlineAfter(std::chrono::milliseconds(ttlMs));
+                scheduleExpiry(*node, node->expireAt_);
+            }
+        }
+        return true;
+    }
+
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+    // 挂上二级缓存：之后因容量被淘汰的条目交给它，内存未命中时先查它（见 CacheTier.h）。
+    // 传入 nullptr 取消
+    void setSecondTier(std::shared_ptr<CacheTier<Key, Value>> tier){
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        tier_ = std::move(tier);
+    }
+
+    // 4. 删除数据（二级缓存中的旧值一起作废）
+    void remove(const Key& key){
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        invalidateTier(key);
         auto it = nodeMap_.find(key);
         if(it != nodeMap_.end()){
+            notifier_.record(it->second->getKey(), it->second->getValue(), RemovalCause::Explicit);
             removeNode(it->second); // 删除链表的node
+            totalWeight_ -= it->second->weight_;
             nodeMap_.erase(it); // 删除哈希表的key
+            stats_.recordRemoval();
         }
 
     }
@@ -151,26 +564,233 @@ private:
         dummyTail_->prev_ = dummyHead_;
     }
 
-    // 作用是，插入一个新的Node，要更新Node到链表头部
-    void updateExistingNode(NodePtr node, const Value& value){
-        node->setValue(value);
+    size_t weigh(const Key& key, const Value& value) const {
+        return weigher_ ? weigher_(key, value) : 1;
+    }
+
+    // 删除所有条目，时间轮里的记录一起清掉
+    void clearInternal(){
+        NodePtr node = dummyHead_->next_;
+        while(node != dummyTail_){
+            NodePtr next = node->next_;
+            node->prev_.reset();
+            node->next_.reset();
+            node = next;
+        }
+        dummyHead_->next_ = dummyTail_;
+        dummyTail_->prev_ = dummyHead_;
+        nodeMap_.clear();
+        timingWheel_.clear();
+        totalWeight_ = 0;
+    }
+
+    // 作用是，插入一个新的Node，要更新Node到链表头部。
+    // 新值的权重超过总容量时拒绝写入，旧值也一并删除，返回 nullptr
+    LruNodeType* updateExistingNode(typename NodeMap::iterator it, Value value){
+        const NodePtr& node = it->second;
+        size_t weight = weigh(node->getKey(), value);
+        if(weight > capacity_){
+            notifier_.record(node->getKey(), node->getValue(), RemovalCause::Evicted);
+            removeNode(node);
+            totalWeight_ -= node->weight_;
+            nodeMap_.erase(it);
+            stats_.recordRejection();
+            return nullptr;
+        }
+
+        stats_.recordUpdate();
+        notifier_.record(node->getKey(), node->getValue(), RemovalCause::Replaced);
+        totalWeight_ = totalWeight_ - node->weight_ + weight;
+        node->weight_ = weight;
+        node->setValue(std::move(value));
+        node->expireAt_ = 0;
         moveToMostRecent(node);
+        // 淘汰会移动哈希表中的其他元素，it 和 node 这个引用之后失效，先取出节点指针
+        LruNodeType* result = node.get();
+        // 新值变重了：从最久未使用的一端淘汰，node 在最近一端且单独放得下，不会被淘汰
+        evictUntilFits(0);
+        return result;
     }
 
-    // 添加新节点
-    void addNewNode(const Key& key, const Value& value){
-        // 1. 先检查缓存，如果缓存已满，就删除最久未使用的
-        if(nodeMap_.size() >= capacity_){
-            evictLeastRecent(); //  删除掉最久远的（在Head）
+    // 添加新节点，返回新节点；权重超过总容量时拒绝写入，返回 nullptr
+    LruNodeType* addNewNode(Key key, Value value){
+        size_t weight = weigh(key, value);
+        if(weight > capacity_){
+            stats_.recordRejection();
+            return nullptr;
         }
+        stats_.recordInsert();
+        // 1. 先检查缓存，如果放不下，就删除最久未使用的，直到放得下为止
+        evictUntilFits(weight);
         // 新增节点
-        NodePtr newNode = std::make_shared<LruNodeType>(key, value);
+        NodePtr newNode = std::make_shared<LruNodeType>(key, std::move(value));
+        newNode->weight_ = weight;
+        totalWeight_ += weight;
+        LruNodeType* node = newNode.get();
         insertNode(newNode);  // 插入链表尾部
-        nodeMap_[key] = newNode; //哈希表加入新节点
+        nodeMap_.emplace(std::move(key), std::move(newNode)); //哈希表加入新节点
+        return node;
     }
 
+    // getMany 的实现：at(j) 给出第 j 个 key 在调用者数组中的位置
+    template <typename At>
+    size_t getManyAt(const Key* keys, size_t count, Value* values, bool* hits, At at){
+        size_t hitCount = 0;
+        NotifyScope<Key, Value> notify(notifier_);
+        std::shared_ptr<CacheTier<Key, Value>> tier;
+        std::vector<uint64_t> writes; // 每个未命中 key 开始取回时的写入计数
+        {
+            TimedLockGuard<std::mutex> lock(mutex_, stats_);
+            reclaimExpired();
+            batchNodes_.resize(count);
+            batchHashes_.resize(count);
+            for (size_t j = 0; j < count; ++j) {
+                batchHashes_[j] = nodeMap_.hash(keys[at(j)]);
+                if (j < kPrefetchDistance) nodeMap_.prefetch(batchHashes_[j]);
+            }
+            for (size_t j = 0; j < count; ++j) {
+                if (j + kPrefetchDistance < count) nodeMap_.prefetch(batchHashes_[j + kPrefetchDistance]);
+                auto it = nodeMap_.find(keys[at(j)], batchHashes_[j]);
+                if (it != nodeMap_.end()) {
+                    prefetch(it->second.get());
+                    batchNodes_[j] = &it->second;
+                } else {
+                    batchNodes_[j] = nullptr;
+                }
+            }
+
+            for (size_t j = 0; j < count; ++j) {
+                size_t i = at(j);
+                hits[i] = batchNodes_[j] != nullptr;
+                if (!hits[i]) continue;
+                const NodePtr& node = *batchNodes_[j];
+                moveToMostRecent(node);
+                values[i] = node->value_;
+                ++hitCount;
+            }
+            stats_.recordHit(hitCount);
+            stats_.recordMiss(count - hitCount);
+            if (!tier_ || hitCount == count) return hitCount;
+            tier = tier_;
+            writes.resize(count);
+            for (size_t j = 0; j < count; ++j) {
+                size_t i = at(j);
+                if (!hits[i]) writes[j] = beginPromotion(keys[i]);
+            }
+        }
+        for (size_t j = 0; j < count; ++j) {
+            size_t i = at(j);
+            if (hits[i]) continue;
+            hits[i] = promoteFromTier(*tier, keys[i], values[i], writes[j]);
+            if (hits[i]) ++hitCount;
+        }
+        return hitCount;
+    }
+    // putMany 的实现：at(j) 给出第 j 个条目在调用者数组中的位置
+    template <typename At>
+    void putManyAt(const Key* keys, const Value* values, size_t count, At at){
+        if(capacity_ == 0) return;
+
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        reclaimExpired();
+        for (size_t j = 0; j < count; ++j) {
+            size_t i = at(j);
+            invalidateTier(keys[i]);
+            auto it = nodeMap_.find(keys[i]);
+            if(it != nodeMap_.end()){
+                updateExistingNode(it, values[i]);
+            } else {
+                addNewNode(keys[i], values[i]);
+            }
+        }
+    }
 
-    void moveToMostRecent(NodePtr node){
+    // 写入和删除时作废二级缓存中的旧值。新值之后可能不经过 offer 就离开内存（TTL 到期、变重被拒绝），
+    // 旧值留在二级缓存里，下一次未命中就会把它读回来。调用者持有锁
+    void invalidateTier(const Key& key){
+        if(tier_) tier_->erase(key);
+        recordWrite(key);
+    }
+
+    // 给正在取回这个 key 的读者记一次写入（put、replace、remove 都算），调用者持有锁
+    void recordWrite(const Key& key){
+        if(promotions_.empty()) return;
+        auto it = promotions_.find(key);
+        if(it != promotions_.end()) ++it->second.writes;
+    }
+
+    // 登记一次即将进行的二级缓存取回，返回此刻的写入计数。调用者持有锁
+    uint64_t beginPromotion(const Key& key){
+        Promotion& promotion = promotions_[key];
+        ++promotion.inFlight;
+        return promotion.writes;
+    }
+
+    // 取回结束，返回从 beginPromotion 起这个 key 有没有被写入过。调用者持有锁
+    bool endPromotion(const Key& key, uint64_t writes){
+        auto it = promotions_.find(key);
+        bool written = it->second.writes != writes;
+        if(--it->second.inFlight == 0) promotions_.erase(it);
+        return written;
+    }
+
+    // 从二级缓存取出 key 并放回内存，在不持锁时调用，之前已经 beginPromotion 登记过，writes 是它的返回值。
+    // 取回期间 key 被重新写入时以内存中的值为准；期间这个 key 被写入或 remove 过、又已经不在内存里时
+    // 只返回值、不放回内存：新值可能已经被淘汰进二级缓存，被删除的 key 也不该因为这次读取回到缓存里。
+    // 写别的 key 不影响这次取回
+    bool promoteFromTier(CacheTier<Key, Value>& tier, Key key, Value& value, uint64_t writes){
+        bool found = tier.take(key, value);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        bool written = endPromotion(key, writes);
+        if(!found) return false;
+        auto it = nodeMap_.find(key);
+        if(it != nodeMap_.end()){
+            moveToMostRecent(it->second);
+            value = it->second->getValue();
+            return true;
+        }
+        if(!written && capacity_ > 0){
+            addNewNode(std::move(key), value);
+        }
+        return true;
+    }
+
+    // 推进时间轮，批量回收到期的条目。没有带 TTL 的条目时不读时钟
+    size_t reclaimExpired(){
+        if(timingWheel_.empty()) return 0;
+        size_t reclaimed = 0;
+        timingWheel_.advance([this, &reclaimed](const Key& key, uint64_t deadline){
+            auto it = nodeMap_.find(key);
+            // 不是节点当前的那条记录：条目后来被删除、淘汰，或者改成了更早的到期时间
+            if(it == nodeMap_.end() || it->second->scheduledAt_ != deadline) return;
+            LruNodeType& node = *it->second;
+            node.scheduledAt_ = 0;
+            // 到期时间后来被推迟或取消：按现在的到期时间放回去
+            if(node.expireAt_ != deadline){
+                if(node.expireAt_ != 0) scheduleExpiry(node, node.expireAt_);
+                return;
+            }
+            notifier_.record(it->second->getKey(), it->second->getValue(), RemovalCause::Expired);
+            removeNode(it->second);
+            totalWeight_ -= it->second->weight_;
+            nodeMap_.erase(it);
+            stats_.recordExpiration();
+            ++reclaimed;
+        });
+        return reclaimed;
+    }
+
+
+    // 每个节点在时间轮里最多一条有效记录。已有一条不晚于 deadline 的记录时不再登记，
+    // 它触发时发现 expireAt_ 推后了再放回去；反复用 TTL 覆盖同一个 key 不会让时间轮越来越大
+    void scheduleExpiry(LruNodeType& node, uint64_t deadline){
+        if(node.scheduledAt_ != 0 && node.scheduledAt_ <= deadline) return;
+        node.scheduledAt_ = deadline;
+        timingWheel_.schedule(node.key_, deadline);
+    }
+
+    void moveToMostRecent(const NodePtr& node){
         removeNode(node);  // 从链表中移除当前节点(先找到对应node，删除)
         insertNode(node);  // 将节点插入到链表头部（再把这个node添加到尾部）
     }
@@ -179,7 +799,7 @@ private:
     // 删除节点时，必须同时更新 prev 和 next。
     // A->next_ 指向 C
     // C->prev_ 指向 A
-    void removeNode(NodePtr node) 
+    void removeNode(const NodePtr& node) 
     {
         node->prev_->next_ = node->next_; // 前节点的 next 指针指向当前节点的后节点
         node->next_->prev_ = node->prev_; // 后节点的 prev 指针指向当前节点的前节点
@@ -188,32 +808,64 @@ private:
 
     // 因为是双向链表，所以要操作两次
     // 从尾部插入节点（尾部是新节点）
-    void insertNode(NodePtr node){
+    void insertNode(const NodePtr& node){
         node->next_ = dummyTail_;
         node->prev_ = dummyTail_->prev_;
         dummyTail_->prev_->next_ = node;
         dummyTail_->prev_ = node;
     }
 
-    // 淘汰使用最少的node（头部是最少用的）
-    void evictLeastRecent() 
+    // 淘汰最久未使用的节点，直到再放入 incoming 的权重也不超过容量
+    void evictUntilFits(size_t incoming)
+    {
+        while(totalWeight_ + incoming > capacity_ && dummyHead_->next_ != dummyTail_){
+            evictLeastRecent();
+        }
+    }
+
+    // 淘汰使用最少的node（头部是最少用的）；它恰好是 keep 时淘汰下一个
+    void evictLeastRecent(const LruNodeType* keep = nullptr) 
     {
         NodePtr leastRecent = dummyHead_->next_; // 最久未访问的数据是链表尾部的节点
+        if(leastRecent.get() == keep) leastRecent = leastRecent->next_;
         removeNode(leastRecent);                 // 从链表中移除
+        totalWeight_ -= leastRecent->weight_;
+        notifier_.record(leastRecent->getKey(), leastRecent->getValue(), RemovalCause::Evicted);
+        // 有二级缓存时交给它；带 TTL 的条目不下沉
+        if(tier_ && leastRecent->expireAt_ == 0){
+            tier_->offer(leastRecent->getKey(), std::move(leastRecent->value_));
+        }
         nodeMap_.erase(leastRecent->getKey());   // 从哈希表中删除
+        stats_.recordEviction();
     }
 
 private:
-    int capacity_;  
+    size_t capacity_;     // 总权重上限；没有 weigher 时就是条目个数
+    size_t totalWeight_;  // 当前所有条目的权重之和
+    Weigher<Key, Value> weigher_;
     std::mutex  mutex_;
     // NodePtr = std::shared_ptr<LruNodeType>
     NodePtr dummyHead_;
     NodePtr dummyTail_;
     NodeMap nodeMap_; 
+    std::vector<const NodePtr*> batchNodes_; // getMany 的查找结果，复用以避免每批分配
+    std::vector<size_t> batchHashes_; // getMany 预先算好的哈希值
+    CacheStats stats_;
+    TimingWheel<Key> timingWheel_; // 驱动 TTL 过期
+    std::shared_ptr<CacheTier<Key, Value>> tier_; // 二级缓存，可以为空
+    // 正在从二级缓存取回的 key：inFlight 是进行中的取回个数，writes 是取回期间对它的写入次数
+    struct Promotion {
+        size_t inFlight = 0;
+        uint64_t writes = 0;
+    };
+    std::unordered_map<Key, Promotion> promotions_;
+    RemovalNotifier<Key, Value> notifier_; // 删除通知：锁内记录，锁外投递
 };
 
 
 
 
+} // inline namespace KAMACACHE_STATS_ABI
+
 } // namespace KamaCache
 
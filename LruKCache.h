@@ -1,73 +1,498 @@
 #pragma once
 
-#include <cstring>
-#include <list>
+/*
+LruKCache：LRU-K 缓存。
+一个 key 被访问满 k 次之后才进入主缓存，只被访问过一两次的数据（比如一次性扫描）不会冲掉热点数据。
+
+历史记录和主缓存共用一张哈希表、一把锁：
+- 每个 key 只有一个 LruNode，节点的 accessCount_ 就是历史访问次数；
+- 历史节点挂在 historyList_ 上，常驻节点挂在 residentList_ 上；
+- 访问次数达到 k 时，节点直接从 historyList_ 摘下挂到 residentList_，不重新分配、不重新哈希。
+
+put 时值会先暂存在历史节点里，所以第 k 次访问可以是 get：此时直接晋升并返回暂存的值。
+只被 get 过、从没 put 过的 key 在历史记录里没有值，达到 k 次也不会晋升。
+
+传入 weigher 时，主缓存按权重之和限制容量。历史记录仍按 key 的个数限制，另外暂存的值也按权重计入
+一个同样大小（maxWeight）的历史预算：超出预算时挤掉最旧的历史节点，比整个预算还重的值不暂存，只记访问次数。
+这样暂存值占用的内存不会超过 maxWeight，整个缓存的数据最多是 2 × maxWeight。
+*/
+
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 
 #include "KICachePolicy.h"
 #include "LruCache.h"
+#include "Snapshot.h"
 
 namespace KamaCache{
+inline namespace KAMACACHE_STATS_ABI {
 
-// LRU优化：Lru-k版本, 通过继承的方式进行再优化
 template<typename Key, typename Value>
-class LruKCache : public LruCache<Key, Value> {
+class LruKCache : public KICachePolicy<Key, Value> {
 
 public:
-    // 构造函数
-    LruKCache(int capacity, int historyCapacity, int k) 
-        : LruCache<Key, Value>(capacity),
-        // 初始化 historyList_: historyList_ 是一个指向 LruCache<Key, size_t> 的智能指针。
-          historyList_(std::make_shared<LruCache<Key, size_t>>(historyCapacity)), // 初始化历史访问记录
-          k_(k) 
+    using NodePtr = std::shared_ptr<LruNode<Key, Value>>;
+
+    struct Entry {
+        NodePtr node;
+        bool resident;  // true：在主缓存中；false：只在历史记录中
+        bool hasValue;  // 历史节点是否暂存了 put 进来的值
+        size_t weight;  // 常驻时计入主缓存的权重；在历史记录中时是暂存值计入历史预算的权重
+    };
+
+    // capacity 为主缓存容量，historyCapacity 为历史记录容量，k 为进入主缓存所需的访问次数
+    LruKCache(int capacity, int historyCapacity, int k)
+        : capacity_(capacity > 0 ? capacity : 0),
+          historyCapacity_(historyCapacity > 0 ? historyCapacity : 0),
+          residentWeight_(0),
+          historyWeight_(0),
+          k_(k > 0 ? static_cast<size_t>(k) : 1)
     {}
 
+    // 主缓存按权重限制容量：maxWeight 是常驻数据权重之和的上限
+    LruKCache(size_t maxWeight, int historyCapacity, int k, Weigher<Key, Value> weigher)
+        : capacity_(maxWeight),
+          historyCapacity_(historyCapacity > 0 ? historyCapacity : 0),
+          residentWeight_(0),
+          historyWeight_(0),
+          k_(k > 0 ? static_cast<size_t>(k) : 1),
+          weigher_(std::move(weigher))
+    {}
+
+    ~LruKCache() override = default;
+
     // 获取数据 (支持返回布尔值和传出参数)
-    bool get(Key key, Value& value) {
-        int historyCount = historyList_->get(key);
-        historyList_->put(key, ++historyCount);
+    bool get(const Key& key, Value& value) override {
+        return visit<Key>(key, [&value](const Value& v) { value = v; });
+    }
 
-        // 调用基类的 get 函数
-        return LruCache<Key, Value>::get(key, value);
+    // 异构查找：例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
+        return visit(key, [&value](const Value& v) { value = v; });
     }
 
-    // 从缓存中获取指定键 key 对应的值，并更新访问记录。
-    Value get(Key key) {
-        // 获取历史访问次数
-        // historyList_ 是一个指向 LruCache<Key, size_t> 的智能指针。
-        // 所以这个智能指针可以直接访问LruCache对象的函数 get
-        int historyCount = historyList_->get(key);
-        std::cout << "Key " << key << " history access count: " << historyCount << "\n";
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
 
-        // 更新历史访问记录的访问次数
-        historyList_->put(key, ++historyCount);
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
 
-        // 尝试从主缓存中获取数据: 因为get是主缓存的函数
-        return LruCache<Key, Value>::get(key);
+    // 零拷贝读取：常驻命中，或这次访问使历史节点晋升时，在持锁状态下把值交给 visitor
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        // notify 先于锁构造、后于锁析构：这次访问引起的淘汰在解锁之后才通知
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = findKey(nodeMap_, key);
+        if (it == nodeMap_.end()) {
+            // 第一次访问：只记录历史，没有值可返回
+            addHistoryNode(Key(key), Value(), false);
+            stats_.recordMiss();
+            return false;
+        }
+
+        const NodePtr& node = accessNode(it->second);
+        if (!it->second.resident) {
+            stats_.recordMiss();
+            return false;
+        }
+        visitor(node->getValue());
+        stats_.recordHit();
+        return true;
     }
 
+    // 读穿式的一次访问（demand fill）：命中时通过 value 返回缓存的值；未命中时把传入的 value 暂存进历史记录。
+    // 和 get 未命中后紧接着 put 不同，整个过程只算一次访问
+    bool getOrPut(const Key& key, Value& value) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) {
+            addHistoryNode(key, value, true);
+            stats_.recordMiss();
+            return false;
+        }
+
+        Entry& entry = it->second;
+        if (entry.resident) {
+            accessNode(entry);
+            value = entry.node->getValue();
+            stats_.recordHit();
+            return true;
+        }
+        // 这次访问可能使它晋升，但值来自调用者，仍然算未命中
+        stashValue(entry, value);
+        accessNode(entry);
+        stats_.recordMiss();
+        return false;
+    }
 
     // 插入数据
-    void put(Key key, Value value) {
-        // 首先更新历史访问记录中的访问次数
-        int historyCount = historyList_->get(key);
-        historyList_->put(key, ++historyCount);
+    void put(Key key, Value value) override {
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        putInternal(std::move(key), std::move(value));
+    }
 
-        // 如果历史访问次数达到阈值 k，则将数据加入主缓存
-        if (historyCount >= k_) {
-            // 从历史访问记录中移除该键
-            historyList_->remove(key);
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        put(std::move(key), Value(std::forward<Args>(args)...));
+    }
 
-            // 将数据存入主缓存
-            LruCache<Key, Value>::put(key, value);
+    // 批量获取：整批只加一次锁，历史记录和主缓存在同一次查找里处理
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* hits) override {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        size_t hitCount = 0;
+        for (size_t i = 0; i < count; ++i) {
+            auto it = nodeMap_.find(keys[i]);
+            if (it == nodeMap_.end()) {
+                addHistoryNode(keys[i], Value(), false);
+                hits[i] = false;
+                continue;
+            }
+            const NodePtr& node = accessNode(it->second);
+            hits[i] = it->second.resident;
+            if (hits[i]) {
+                values[i] = node->getValue();
+                ++hitCount;
+            }
         }
+        stats_.recordHit(hitCount);
+        stats_.recordMiss(count - hitCount);
+        return hitCount;
+    }
+
+    // 批量插入：整批只加一次锁，每个 key 仍然走 k 次准入
+    void putMany(const Key* keys, const Value* values, size_t count) override {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        for (size_t i = 0; i < count; ++i) {
+            putInternal(keys[i], values[i]);
+        }
+    }
+
+    // 同时从主缓存和历史记录中删除
+    void remove(const Key& key) {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) return;
+        if (it->second.resident) {
+            notifier_.record(it->second.node->getKey(), it->second.node->getValue(), RemovalCause::Explicit);
+            stats_.recordRemoval();
+            residentWeight_ -= it->second.weight;
+        } else {
+            historyWeight_ -= it->second.weight;
+        }
+        listOf(it->second).remove(it->second.node);
+        nodeMap_.erase(it);
+    }
+
+    // 快照：先写历史记录，再写主缓存，各自从最久未使用到最近使用；每条记录带上访问次数。
+    // 历史节点只有暂存了值时才写值。写出期间持有锁
+    bool saveSnapshot(const std::string& path) {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        SnapshotWriter out(path, SnapshotPolicy::LruK);
+        historyList_.forEach([&](const LruNode<Key, Value>& node) {
+            writeRecord(out, node, false, nodeMap_.find(node.getKey())->second.hasValue);
+        });
+        residentList_.forEach([&](const LruNode<Key, Value>& node) {
+            writeRecord(out, node, true, true);
+        });
+        return out.finish();
+    }
+
+    // 用快照替换当前内容：整个加载过程只加一次锁，节点直接挂回原来的链表，访问次数保持不变。
+    // 超出容量时两边都淘汰最久未使用的一端。文件损坏时已读出的条目保留，返回 false
+    bool loadSnapshot(const std::string& path) {
+        SnapshotReader in(path, SnapshotPolicy::LruK);
+        if (!in.ok()) return false;
+
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        residentList_.clear();
+        historyList_.clear();
+        nodeMap_.clear();
+        residentWeight_ = 0;
+        historyWeight_ = 0;
+        // 每条记录至少有访问次数和标志位，文件头里的条目数不可信
+        uint64_t count = in.boundedCount(sizeof(uint64_t) + sizeof(uint8_t));
+        nodeMap_.reserve(std::min<uint64_t>(count, historyCapacity_ + (weigher_ ? count : capacity_)));
+        for (uint64_t i = 0; i < in.count(); ++i) {
+            uint64_t accessCount;
+            uint8_t flags;
+            Key key;
+            Value value{};
+            if (!in.readPod(accessCount) || !in.readPod(flags) || !Serializer<Key>::read(in, key) ||
+                ((flags & kHasValue) && !Serializer<Value>::read(in, value))) {
+                return false;
+            }
+            if (nodeMap_.count(key)) continue; // 损坏的快照里重复的 key
+
+            Entry entry{std::make_shared<LruNode<Key, Value>>(key, std::move(value)),
+                        false, (flags & kHasValue) != 0, 0};
+            entry.node->setAccessCount(accessCount);
+            if (flags & kResident) {
+                if (capacity_ == 0 || !promote(entry)) continue;
+            } else {
+                if (historyCapacity_ == 0) continue;
+                if (entry.hasValue) {
+                    entry.weight = stashWeight(entry.node->getKey(), entry.node->getValue());
+                    if (entry.weight > capacity_) {
+                        entry.node->setValue(Value());
+                        entry.hasValue = false;
+                        entry.weight = 0;
+                    }
+                }
+                evictHistory(1, entry.weight);
+                historyWeight_ += entry.weight;
+                historyList_.pushBack(entry.node);
+            }
+            nodeMap_.emplace(std::move(key), std::move(entry));
+        }
+        return true;
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    // 只通知主缓存中的数据；历史记录里暂存的值从未对读者可见，被挤出时不通知
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+    // 主缓存中的数据个数
+    size_t size() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return residentList_.size();
+    }
+
+    // 主缓存中数据的权重之和；没有 weigher 时等于 size()
+    size_t totalWeight() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return residentWeight_;
+    }
+
+    // 历史记录中的 key 个数
+    size_t historySize() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return historyList_.size();
+    }
+
+    // 历史记录中暂存的值的权重之和；没有 weigher 时不计，总是 0
+    size_t historyWeight() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return historyWeight_;
+    }
+
+private:
+    // 快照记录的标志位
+    static constexpr uint8_t kResident = 1;
+    static constexpr uint8_t kHasValue = 2;
+
+    static void writeRecord(SnapshotWriter& out, const LruNode<Key, Value>& node, bool resident, bool hasValue) {
+        out.writePod<uint64_t>(node.getAccessCount());
+        out.writePod<uint8_t>((resident ? kResident : 0) | (hasValue ? kHasValue : 0));
+        Serializer<Key>::write(out, node.getKey());
+        if (hasValue) Serializer<Value>::write(out, node.getValue());
+        out.endRecord();
+    }
+
+    LruList<Key, Value>& listOf(const Entry& entry) {
+        return entry.resident ? residentList_ : historyList_;
+    }
+
+    void putInternal(Key key, Value value) {
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) {
+            addHistoryNode(std::move(key), std::move(value), true);
+            return;
+        }
+
+        Entry& entry = it->second;
+        if (!entry.resident) {
+            stashValue(entry, std::move(value));
+            accessNode(entry);
+            return;
+        }
+
+        // 常驻数据被覆盖：新值比整个主缓存还重时连同旧值一起删除
+        size_t weight = weigh(entry.node->getKey(), value);
+        if (weight > capacity_) {
+            notifier_.record(entry.node->getKey(), entry.node->getValue(), RemovalCause::Evicted);
+            residentList_.remove(entry.node);
+            residentWeight_ -= entry.weight;
+            nodeMap_.erase(it);
+            stats_.recordRejection();
+            return;
+        }
+        stats_.recordUpdate();
+        notifier_.record(entry.node->getKey(), entry.node->getValue(), RemovalCause::Replaced);
+        residentWeight_ = residentWeight_ - entry.weight + weight;
+        entry.weight = weight;
+        entry.node->setValue(std::move(value));
+        accessNode(entry);
+        // 变重之后可能超出容量；它在尾部、自己放得下，不会把自己淘汰
+        evictResident(0);
+    }
+
+    // 对已存在的 key 记一次访问：常驻节点移到最近访问位置；
+    // 历史节点累加访问次数，达到 k 且暂存了值时原地晋升到主缓存
+    const NodePtr& accessNode(Entry& entry) {
+        const NodePtr& node = entry.node;
+        if (entry.resident) {
+            residentList_.moveToBack(node);
+            return node;
+        }
+
+        node->increaseAccessCount();
+        historyList_.remove(node);
+        if (entry.hasValue && node->getAccessCount() >= k_) {
+            // 暂存的值离开历史记录：晋升后改按主缓存计重，晋升失败则被丢掉
+            historyWeight_ -= entry.weight;
+            entry.weight = 0;
+        }
+        if (node->getAccessCount() >= k_ && entry.hasValue && capacity_ > 0 && promote(entry)) {
+            return node;
+        }
+        if (entry.hasValue && node->getAccessCount() >= k_) {
+            // 晋升被拒绝：值太重，永远进不了主缓存，丢掉暂存的值只保留访问历史
+            node->setValue(Value());
+            entry.hasValue = false;
+        }
+        historyList_.pushBack(node);
+        return node;
+    }
+
+    // 新 key 先进入历史记录；k 为 1 时直接进入主缓存
+    void addHistoryNode(Key key, Value value, bool hasValue) {
+        if (k_ <= 1 && hasValue) {
+            if (capacity_ == 0) return;
+            Entry entry{std::make_shared<LruNode<Key, Value>>(key, std::move(value)), false, true, 0};
+            if (!promote(entry)) return;
+            nodeMap_.emplace(std::move(key), std::move(entry));
+            return;
+        }
+
+        if (historyCapacity_ == 0) return;
+        size_t weight = hasValue ? stashWeight(key, value) : 0;
+        if (weight > capacity_) {
+            // 比整个历史预算还重：只记访问次数
+            value = Value();
+            hasValue = false;
+            weight = 0;
+        }
+        evictHistory(1, weight);
+        historyWeight_ += weight;
+        NodePtr node = std::make_shared<LruNode<Key, Value>>(key, std::move(value));
+        historyList_.pushBack(node);
+        nodeMap_.emplace(std::move(key), Entry{std::move(node), false, hasValue, weight});
+    }
+
+    // 把 put 进来的值暂存到已有的历史节点，替换之前暂存的值；调用者随后对它 accessNode。
+    // 先把节点移到最近的一端，腾出预算时只会挤掉别的历史节点
+    void stashValue(Entry& entry, Value value) {
+        historyWeight_ -= entry.weight;
+        entry.weight = 0;
+        entry.hasValue = true;
+        if (entry.node->getAccessCount() + 1 >= k_) {
+            // 这次访问就会晋升（或因为太重被拒绝），值不在历史记录里停留，不占历史预算
+            entry.node->setValue(std::move(value));
+            return;
+        }
+        size_t weight = stashWeight(entry.node->getKey(), value);
+        if (weight > capacity_) {
+            entry.node->setValue(Value());
+            entry.hasValue = false;
+            return;
+        }
+        historyList_.moveToBack(entry.node);
+        evictHistory(0, weight);
+        historyWeight_ += weight;
+        entry.weight = weight;
+        entry.node->setValue(std::move(value));
+    }
+
+    // 淘汰最久未访问的历史节点，直到能再放下 slots 个节点、权重为 incoming 的暂存值。
+    // 调用者保证 incoming 不超过预算
+    void evictHistory(size_t slots, size_t incoming) {
+        while ((historyList_.size() + slots > historyCapacity_ || historyWeight_ + incoming > capacity_) &&
+               historyList_.size() > 0) {
+            NodePtr oldest = historyList_.popFront();
+            auto it = nodeMap_.find(oldest->getKey());
+            historyWeight_ -= it->second.weight;
+            nodeMap_.erase(it);
+        }
+    }
+
+    // 节点已经从 historyList_ 摘下（或是新节点），挂到主缓存尾部；主缓存放不下时淘汰最久未使用的节点。
+    // 权重超过主缓存总容量时拒绝晋升，返回 false。
+    // 统计中的插入指进入主缓存，只在历史记录里的 key 不算
+    bool promote(Entry& entry) {
+        size_t weight = weigh(entry.node->getKey(), entry.node->getValue());
+        if (weight > capacity_) {
+            stats_.recordRejection();
+            return false;
+        }
+        evictResident(weight);
+        stats_.recordInsert();
+        entry.resident = true;
+        entry.weight = weight;
+        residentWeight_ += weight;
+        residentList_.pushBack(entry.node);
+        return true;
+    }
+
+    // 淘汰主缓存中最久未使用的数据，直到能再放下 incoming 的权重
+    void evictResident(size_t incoming) {
+        while (residentWeight_ + incoming > capacity_ && residentList_.size() > 0) {
+            NodePtr victim = residentList_.popFront();
+            notifier_.record(victim->getKey(), victim->getValue(), RemovalCause::Evicted);
+            auto it = nodeMap_.find(victim->getKey());
+            residentWeight_ -= it->second.weight;
+            nodeMap_.erase(it);
+            stats_.recordEviction();
+        }
+    }
+
+    size_t weigh(const Key& key, const Value& value) const {
+        return weigher_ ? weigher_(key, value) : 1;
+    }
+
+    // 暂存值计入历史预算的权重；没有 weigher 时历史记录只按个数限制，不计重
+    size_t stashWeight(const Key& key, const Value& value) const {
+        return weigher_ ? weigher_(key, value) : 0;
     }
 
 private:
-    int k_;  // 定义一个k，只有数据的访问次数超过k才会被存入缓存区
-    std::shared_ptr<LruCache<Key, size_t>> historyList_; // 历史访问记录(value为访问次数)
+    size_t capacity_;        // 主缓存容量（权重之和的上限）
+    size_t historyCapacity_; // 历史记录容量
+    size_t residentWeight_;  // 主缓存中数据的权重之和
+    size_t historyWeight_;   // 历史记录中暂存的值的权重之和，不超过 capacity_
+    size_t k_;               // 访问次数达到 k 才会被存入主缓存
+    Weigher<Key, Value> weigher_;
+    std::mutex mutex_;
+    LruList<Key, Value> residentList_;
+    LruList<Key, Value> historyList_;
+    std::unordered_map<Key, Entry, KeyHash<Key>, KeyEqual> nodeMap_;
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_; // 删除通知：锁内记录，锁外投递
 };
 
+} // inline namespace KAMACACHE_STATS_ABI
+
 } // namespace KamaCache
@@ -0,0 +1,112 @@
+#pragma once
+
+/*
+MpmcRing：有界的多生产者、多消费者无锁环形队列（Dmitry Vyukov 的 bounded MPMC queue）。
+
+每个槽位带一个序号 sequence：
+- 槽位可写时 sequence == 写位置，写完后置为 写位置 + 1；
+- 槽位可读时 sequence == 读位置 + 1，读完后置为 读位置 + 容量，供下一圈写入。
+生产者和消费者各自用 CAS 抢占写位置/读位置，抢到之后独占这个槽位，不需要锁。
+队列满时 tryPush 返回 false，空时 tryPop 返回 false，都不阻塞。
+
+T 应该是平凡可拷贝的小类型（指针、整数），元素按值拷贝进出队列。
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace KamaCache
+{
+
+template <typename T>
+class MpmcRing
+{
+public:
+    // 容量向上取整为 2 的幂，至少为 2
+    explicit MpmcRing(size_t capacity)
+    : capacity_(roundUp(capacity)), mask_(capacity_ - 1), cells_(new Cell[capacity_])
+    {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    bool tryPush(const T& value) {
+        size_t pos = writePos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                // 槽位空闲：抢占写位置
+                if (writePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                // 这个槽位上一圈的元素还没被读走：队列满
+                return false;
+            } else {
+                // 被其他生产者抢先了，重新读取写位置
+                pos = writePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t pos = readPos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (readPos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                // 槽位还没写入：队列空
+                return false;
+            } else {
+                pos = readPos_.load(std::memory_order_relaxed);
+            }
+        }
+        value = cell->value;
+        cell->sequence.store(pos + capacity_, std::memory_order_release);
+        return true;
+    }
+
+    // 近似的元素个数：并发读写时只是一个瞬时估计
+    size_t size() const {
+        size_t write = writePos_.load(std::memory_order_relaxed);
+        size_t read = readPos_.load(std::memory_order_relaxed);
+        return write > read ? write - read : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUp(size_t capacity) {
+        size_t result = 2;
+        while (result < capacity) result *= 2;
+        return result;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    // 读写位置放在不同的缓存行，生产者和消费者互不干扰
+    alignas(64) std::atomic<size_t> writePos_{0};
+    alignas(64) std::atomic<size_t> readPos_{0};
+};
+
+} // namespace KamaCache
@@ -0,0 +1,424 @@
+#pragma once
+
+/*
+PolicyCache：在编译期组合的缓存。淘汰策略、锁策略、哈希函数、分配器和统计钩子都是模板参数，
+没有虚函数，get/put 可以完全内联到调用处。
+
+    PolicyCache<Key, Value, Eviction, Lock, Hash, Alloc, Stats>
+
+- Eviction（淘汰策略）：LruEviction、ClockEviction。
+  策略提供节点要继承的 Hook（链表指针等元数据）和管理这些节点顺序的 Queue：
+  onInsert / onAccess / onErase / victim；
+- Lock（锁策略）：NoLock（单线程，完全没有锁）、MutexLock、SharedMutexLock（淘汰策略允许时 get 只拿读锁）、
+  StripedLock<N, Inner>（按哈希分成 N 个分片，每片独立的锁、索引和淘汰队列）；
+- Hash：索引 FlatHashMap 使用的哈希函数；
+- Alloc：节点的分配器（内部 rebind 到节点类型）。缓存满了以后，被淘汰的节点原地复用给新条目，稳态下没有分配；
+- Stats：统计钩子，默认是 CacheStats（受 KAMACACHE_ENABLE_STATS 控制），NoStats 在任何情况下都不计数。
+
+例如单线程嵌入式场景的 PolicyCache<uint64_t, Item, LruEviction, NoLock, KeyHash<uint64_t>, std::allocator<Item>, NoStats>
+编译后没有锁也没有虚函数表。需要通过 KICachePolicy 接口使用时，用 PolicyCacheAdapter 包一层。
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+#include "CacheStats.h"
+#include "FlatHashMap.h"
+#include "KICachePolicy.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+// ---------------- 淘汰策略 ----------------
+
+// LRU：双向循环链表，头部是最久未使用的节点，命中时移到尾部
+struct LruEviction {
+    // 命中要移动节点，读路径也必须独占
+    static constexpr bool kSharedAccess = false;
+
+    struct Hook {
+        Hook* prev_ = nullptr;
+        Hook* next_ = nullptr;
+    };
+
+    class Queue
+    {
+    public:
+        Queue() { head_.prev_ = head_.next_ = &head_; }
+        Queue(const Queue&) = delete;
+        Queue& operator=(const Queue&) = delete;
+
+        void onInsert(Hook* hook) { linkBack(hook); }
+
+        void onAccess(Hook* hook) {
+            unlink(hook);
+            linkBack(hook);
+        }
+
+        void onErase(Hook* hook) { unlink(hook); }
+
+        // 最久未使用的节点，队列为空时返回 nullptr
+        Hook* victim() { return head_.next_ == &head_ ? nullptr : head_.next_; }
+
+    private:
+        void linkBack(Hook* hook) {
+            hook->prev_ = head_.prev_;
+            hook->next_ = &head_;
+            head_.prev_->next_ = hook;
+            head_.prev_ = hook;
+        }
+
+        static void unlink(Hook* hook) {
+            hook->prev_->next_ = hook->next_;
+            hook->next_->prev_ = hook->prev_;
+        }
+
+        Hook head_; // 哨兵
+    };
+};
+
+// CLOCK：环形链表加一个指针 hand_，命中只置访问位，不移动节点。
+// 淘汰时从 hand_ 开始，访问位为 1 的清零跳过，第一个为 0 的就是淘汰对象
+struct ClockEviction {
+    // 命中只写一个原子的访问位，可以和其他读者同时进行
+    static constexpr bool kSharedAccess = true;
+
+    struct Hook {
+        Hook* prev_ = nullptr;
+        Hook* next_ = nullptr;
+        std::atomic<bool> referenced_{false};
+    };
+
+    class Queue
+    {
+    public:
+        Queue() : hand_(nullptr) {}
+        Queue(const Queue&) = delete;
+        Queue& operator=(const Queue&) = delete;
+
+        // 新节点插在 hand_ 之前，一圈之中最后被检查
+        void onInsert(Hook* hook) {
+            hook->referenced_.store(false, std::memory_order_relaxed);
+            if (!hand_) {
+                hook->prev_ = hook->next_ = hook;
+                hand_ = hook;
+                return;
+            }
+            hook->prev_ = hand_->prev_;
+            hook->next_ = hand_;
+            hand_->prev_->next_ = hook;
+            hand_->prev_ = hook;
+        }
+
+        void onAccess(Hook* hook) {
+            if (!hook->referenced_.load(std::memory_order_relaxed)) {
+                hook->referenced_.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        void onErase(Hook* hook) {
+            if (hook == hand_) hand_ = hook->next_ == hook ? nullptr : hook->next_;
+            hook->prev_->next_ = hook->next_;
+            hook->next_->prev_ = hook->prev_;
+        }
+
+        Hook* victim() {
+            if (!hand_) return nullptr;
+            while (hand_->referenced_.load(std::memory_order_relaxed)) {
+                hand_->referenced_.store(false, std::memory_order_relaxed);
+                hand_ = hand_->next_;
+            }
+            return hand_;
+        }
+
+    private:
+        Hook* hand_;
+    };
+};
+
+// ---------------- 锁策略 ----------------
+
+// 单线程使用：lock/unlock 都是空函数，编译后不留下任何指令
+struct NoLock {
+    static constexpr size_t kStripes = 1;
+    static constexpr bool kSharedReads = false;
+
+    struct Mutex {
+        void lock() {}
+        void unlock() {}
+        void lock_shared() {}
+        void unlock_shared() {}
+    };
+};
+
+struct MutexLock {
+    static constexpr size_t kStripes = 1;
+    static constexpr bool kSharedReads = false;
+    using Mutex = std::mutex;
+};
+
+// 淘汰策略的 kSharedAccess 为 true 时，get 只拿读锁
+struct SharedMutexLock {
+    static constexpr size_t kStripes = 1;
+    static constexpr bool kSharedReads = true;
+    using Mutex = std::shared_mutex;
+};
+
+// 按 key 的哈希分成 Stripes 个分片，每片使用 Inner 的锁，分片之间完全独立（包括淘汰顺序）
+template <size_t Stripes, typename Inner = MutexLock>
+struct StripedLock {
+    static_assert(Stripes > 0, "StripedLock needs at least one stripe");
+    static constexpr size_t kStripes = Stripes;
+    static constexpr bool kSharedReads = Inner::kSharedReads;
+    using Mutex = typename Inner::Mutex;
+};
+
+// ---------------- 统计钩子 ----------------
+
+// 不计数的统计钩子：所有函数都是空的，snapshot 返回全零
+struct NoStats {
+    void recordHit(uint64_t = 1) {}
+    void recordMiss(uint64_t = 1) {}
+    void recordInsert() {}
+    void recordUpdate() {}
+    void recordEviction() {}
+    void recordRemoval() {}
+    CacheStatsSnapshot snapshot() const { return CacheStatsSnapshot(); }
+};
+
+// ---------------- 缓存 ----------------
+
+template <typename Key,
+          typename Value,
+          typename Eviction = LruEviction,
+          typename Lock = MutexLock,
+          typename Hash = KeyHash<Key>,
+          typename Alloc = std::allocator<Value>,
+          typename Stats = CacheStats>
+class PolicyCache
+{
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+
+    // capacity 均分到各个分片，向上取整为分片数的倍数
+    explicit PolicyCache(size_t capacity, const Alloc& alloc = Alloc())
+    : alloc_(alloc), capacity_((capacity + kStripes - 1) / kStripes * kStripes)
+    {
+        for (size_t i = 0; i < kStripes; ++i) shards_[i].capacity_ = capacity_ / kStripes;
+    }
+
+    ~PolicyCache() {
+        for (Shard& shard : shards_) {
+            for (auto it = shard.nodeMap_.begin(); it != shard.nodeMap_.end(); ++it) {
+                freeNode(it->second);
+            }
+        }
+    }
+
+    PolicyCache(const PolicyCache&) = delete;
+    PolicyCache& operator=(const PolicyCache&) = delete;
+
+    void put(Key key, Value value) {
+        Shard& shard = shardFor(key);
+        NotifyScope<Key, Value> notify(notifier_);
+        std::lock_guard<Mutex> lock(shard.mutex_);
+        auto it = shard.nodeMap_.find(key);
+        if (it != shard.nodeMap_.end()) {
+            Node* node = it->second;
+            notifier_.record(node->key_, node->value_, RemovalCause::Replaced);
+            node->value_ = std::move(value);
+            shard.queue_.onAccess(node);
+            stats_.recordUpdate();
+            return;
+        }
+        if (shard.capacity_ == 0) return;
+
+        Node* node;
+        if (shard.nodeMap_.size() >= shard.capacity_) {
+            // 满了：淘汰一个节点，并把它的内存直接用于新条目
+            Node* victim = static_cast<Node*>(shard.queue_.victim());
+            shard.queue_.onErase(victim);
+            notifier_.record(victim->key_, victim->value_, RemovalCause::Evicted);
+            shard.nodeMap_.erase(victim->key_);
+            NodeTraits::destroy(nodeAlloc_, victim);
+            node = victim;
+            stats_.recordEviction();
+        } else {
+            node = NodeTraits::allocate(nodeAlloc_, 1);
+        }
+        try {
+            NodeTraits::construct(nodeAlloc_, node, key, std::move(value));
+        } catch (...) {
+            NodeTraits::deallocate(nodeAlloc_, node, 1);
+            throw;
+        }
+        shard.queue_.onInsert(node);
+        shard.nodeMap_.emplace(std::move(key), node);
+        stats_.recordInsert();
+    }
+
+    bool get(const Key& key, Value& value) {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 命中时在锁内把值交给 visitor
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        Shard& shard = shardFor(key);
+        if constexpr (Lock::kSharedReads && Eviction::kSharedAccess) {
+            std::shared_lock<Mutex> lock(shard.mutex_);
+            return visitLocked(shard, key, visitor);
+        } else {
+            std::lock_guard<Mutex> lock(shard.mutex_);
+            return visitLocked(shard, key, visitor);
+        }
+    }
+
+    void remove(const Key& key) {
+        Shard& shard = shardFor(key);
+        NotifyScope<Key, Value> notify(notifier_);
+        std::lock_guard<Mutex> lock(shard.mutex_);
+        auto it = shard.nodeMap_.find(key);
+        if (it == shard.nodeMap_.end()) return;
+        Node* node = it->second;
+        notifier_.record(node->key_, node->value_, RemovalCause::Explicit);
+        shard.nodeMap_.erase(it);
+        shard.queue_.onErase(node);
+        freeNode(node);
+        stats_.recordRemoval();
+    }
+
+    // 条目个数：逐个分片加锁统计
+    size_t size() {
+        size_t total = 0;
+        for (Shard& shard : shards_) {
+            std::lock_guard<Mutex> lock(shard.mutex_);
+            total += shard.nodeMap_.size();
+        }
+        return total;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    CacheStatsSnapshot stats() const {
+        return stats_.snapshot();
+    }
+
+    // 运行时设置的删除监听器。没有设置时，淘汰、覆盖和删除路径上只多检查一个标志位，get 路径不受影响
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+private:
+    static constexpr size_t kStripes = Lock::kStripes;
+    using Mutex = typename Lock::Mutex;
+
+    struct Node : Eviction::Hook {
+        Key key_;
+        Value value_;
+
+        Node(Key key, Value value) : key_(std::move(key)), value_(std::move(value)) {}
+    };
+
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+    struct Shard {
+        Mutex mutex_;
+        FlatHashMap<Key, Node*, Hash, KeyEqual> nodeMap_;
+        typename Eviction::Queue queue_;
+        size_t capacity_ = 0;
+    };
+
+    template <typename K>
+    Shard& shardFor(const K& key) {
+        if constexpr (kStripes == 1) {
+            (void)key;
+            return shards_[0];
+        } else {
+            uint64_t hash = mixHash(static_cast<uint64_t>(Hash{}(key)));
+            return shards_[(hash >> 32) % kStripes];
+        }
+    }
+
+    template <typename K, typename Visitor>
+    bool visitLocked(Shard& shard, const K& key, Visitor& visitor) {
+        auto it = findKey(shard.nodeMap_, key);
+        if (it == shard.nodeMap_.end()) {
+            stats_.recordMiss();
+            return false;
+        }
+        Node* node = it->second;
+        shard.queue_.onAccess(node);
+        visitor(static_cast<const Value&>(node->value_));
+        stats_.recordHit();
+        return true;
+    }
+
+    void freeNode(Node* node) {
+        NodeTraits::destroy(nodeAlloc_, node);
+        NodeTraits::deallocate(nodeAlloc_, node, 1);
+    }
+
+private:
+    Alloc alloc_;
+    NodeAlloc nodeAlloc_{alloc_};
+    size_t capacity_;
+    Shard shards_[kStripes];
+    Stats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+// 类型擦除的适配器：把 PolicyCache 包装成 KICachePolicy，供需要运行时多态的代码使用。
+// 只有经过这一层的调用才有虚函数开销
+template <typename Cache>
+class PolicyCacheAdapter final
+    : public KICachePolicy<typename Cache::key_type, typename Cache::mapped_type>
+{
+public:
+    using Key = typename Cache::key_type;
+    using Value = typename Cache::mapped_type;
+
+    template <typename... Args>
+    explicit PolicyCacheAdapter(Args&&... args) : cache_(std::forward<Args>(args)...) {}
+
+    void put(Key key, Value value) override { cache_.put(std::move(key), std::move(value)); }
+    bool get(const Key& key, Value& value) override { return cache_.get(key, value); }
+    Value get(const Key& key) override { return cache_.get(key); }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return cache_.visit(key, visitor);
+    }
+
+    CacheStatsSnapshot stats() const override { return cache_.stats(); }
+
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        cache_.setRemovalListener(std::move(listener), delivery);
+    }
+
+    // 直接访问内部的缓存，绕过虚函数
+    Cache& cache() { return cache_; }
+
+private:
+    Cache cache_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
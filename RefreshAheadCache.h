@@ -0,0 +1,244 @@
+#pragma once
+
+/*
+RefreshAheadCache：提前刷新（refresh-ahead）的缓存。
+
+每个条目记录自己被加载的时间。读者命中一个已经超过 refreshAfter 的条目时，照常拿到旧值，
+同时把这个 key 交给后台的小线程池重新加载；加载完成后新值通过底层缓存的 replaceIf 一次性替换旧值。
+热点数据因此在变旧之前就被换新，后端延迟不会出现在读路径上。
+
+- 刷新队列有上限：队列满时直接放弃这次刷新（之后的访问会再次尝试），刷新风暴不会无限堆积；
+- 同一个 key 同时最多只有一个刷新任务；
+- loader 抛异常时保留旧值；
+- 每次写入给条目一个新的版本号，安排刷新时记下它；刷新结果只在版本号没变时写入。
+  刷新期间 key 被删除、淘汰或被 put 写入了新值，刷新结果直接丢弃，不会覆盖更新的值。
+
+底层缓存由模板参数 Cache 指定（默认 LruCache，也可以是 LfuCache），它保存 (值, 加载时间)，淘汰策略不变。
+Cache 需要提供 replaceIf：只替换已存在、并且满足条件的条目，不算一次访问，后台刷新不会改变淘汰顺序和命中统计。
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "KICachePolicy.h"
+#include "LruCache.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+template <typename Key, typename Value, template <typename, typename> class Cache = LruCache>
+class RefreshAheadCache : public KICachePolicy<Key, Value>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Loader = std::function<Value(const Key&)>;
+
+    // 底层缓存中的条目：值、它被加载（写入）的时间和写入的版本号
+    struct Entry {
+        Value value;
+        Clock::time_point loadedAt;
+        uint64_t version;
+    };
+
+    // capacity 传给底层缓存；refreshAfter 是条目被加载多久之后，下一次访问触发后台刷新；
+    // workerNum 是刷新线程数，queueCapacity 是等待刷新的 key 的上限
+    RefreshAheadCache(int capacity, Loader loader, std::chrono::milliseconds refreshAfter,
+                      size_t workerNum = 2, size_t queueCapacity = 1024)
+    : cache_(capacity),
+      loader_(std::move(loader)),
+      refreshAfter_(refreshAfter),
+      queueCapacity_(queueCapacity > 0 ? queueCapacity : 1),
+      stop_(false),
+      versions_(0),
+      refreshes_(0),
+      dropped_(0),
+      failures_(0)
+    {
+        if (workerNum == 0) workerNum = 1;
+        for (size_t i = 0; i < workerNum; ++i) {
+            workers_.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    // 先停止线程池：正在执行的刷新完成后退出，队列中剩下的刷新被丢弃
+    ~RefreshAheadCache() override {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            stop_ = true;
+        }
+        queueCond_.notify_all();
+        for (auto& worker : workers_) worker.join();
+    }
+
+    RefreshAheadCache(const RefreshAheadCache&) = delete;
+    RefreshAheadCache& operator=(const RefreshAheadCache&) = delete;
+
+    void put(Key key, Value value) override {
+        cache_.put(std::move(key), Entry{std::move(value), Clock::now(), nextVersion()});
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return visit<Key>(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 命中时把当前值交给 visitor；条目超过 refreshAfter 时安排后台刷新，本次仍返回旧值
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        bool stale = false;
+        uint64_t version = 0;
+        bool hit = cache_.visit(key, [&](const Entry& entry) {
+            stale = Clock::now() - entry.loadedAt >= refreshAfter_;
+            version = entry.version;
+            visitor(entry.value);
+        });
+        if (stale) scheduleRefresh(Key(key), version);
+        return hit;
+    }
+
+    void remove(const Key& key) {
+        cache_.remove(key);
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return cache_.stats();
+    }
+
+    // 底层缓存在 Caller 模式下把 (值, 加载时间) 的通知交给这里，去掉加载时间后再按 delivery 投递。
+    // 后台刷新写入新值时，旧值以 Replaced 通知
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        bool enabled = static_cast<bool>(listener);
+        notifier_.setListener(std::move(listener), delivery);
+        if (!enabled) {
+            cache_.setRemovalListener(nullptr);
+            return;
+        }
+        cache_.setRemovalListener([this](std::vector<RemovalNotification<Key, Entry>>& entries) {
+            std::vector<RemovalNotification<Key, Value>> batch;
+            batch.reserve(entries.size());
+            for (auto& entry : entries) {
+                batch.push_back({std::move(entry.key), std::move(entry.value.value), entry.cause});
+            }
+            notifier_.deliver(batch);
+        });
+    }
+
+    // 已完成的后台刷新次数
+    uint64_t refreshes() const { return refreshes_.load(std::memory_order_relaxed); }
+    // 因为队列已满被放弃的刷新次数
+    uint64_t droppedRefreshes() const { return dropped_.load(std::memory_order_relaxed); }
+    // loader 抛出异常的刷新次数
+    uint64_t failedRefreshes() const { return failures_.load(std::memory_order_relaxed); }
+
+    // 正在排队或执行的刷新个数
+    size_t pendingRefreshes() {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        return pending_.size();
+    }
+
+private:
+    uint64_t nextVersion() {
+        return versions_.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // 入队：已经在刷新的 key 不重复入队；队列满时放弃，不阻塞读者。
+    // version 是读者看到的条目版本，刷新结果只替换这个版本
+    void scheduleRefresh(Key key, uint64_t version) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            if (stop_ || pending_.count(key)) return;
+            if (queue_.size() >= queueCapacity_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            pending_.insert(key);
+            queue_.push_back({std::move(key), version});
+        }
+        queueCond_.notify_one();
+    }
+
+    void workerLoop() {
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex_);
+                queueCond_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+                if (stop_) return;
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            refresh(task.key, task.version);
+
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            pending_.erase(task.key);
+        }
+    }
+
+    // loader 在任何锁之外执行
+    void refresh(const Key& key, uint64_t version) {
+        Value value;
+        try {
+            value = loader_(key);
+        } catch (...) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // 比较后替换：刷新期间 key 被删除、淘汰或写入了新值（版本号变了），都不写入
+        Entry entry{std::move(value), Clock::now(), nextVersion()};
+        if (cache_.replaceIf(key, std::move(entry),
+                             [version](const Entry& current) { return current.version == version; })) {
+            refreshes_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    // 等待刷新的 key 和安排刷新时它的版本
+    struct Task {
+        Key key;
+        uint64_t version;
+    };
+
+    RemovalNotifier<Key, Value> notifier_; // 声明在 cache_ 之前：cache_ 析构时的最后一批通知还要经过它
+    Cache<Key, Entry> cache_;
+    Loader loader_;
+    std::chrono::milliseconds refreshAfter_;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueCond_;
+    std::deque<Task> queue_;          // 等待刷新的 key
+    std::unordered_set<Key> pending_; // 排队中或正在刷新的 key
+    size_t queueCapacity_;
+    bool stop_;
+    std::vector<std::thread> workers_;
+    std::atomic<uint64_t> versions_;   // 写入版本号，每次 put 和刷新各取一个
+
+    std::atomic<uint64_t> refreshes_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> failures_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
@@ -0,0 +1,181 @@
+#pragma once
+
+/*
+RemovalListener：条目离开缓存时的通知（淘汰、过期、被新值覆盖、被 remove 删除）。
+
+通知不在缓存的临界区里投递：
+- 删除发生时，缓存在锁内调用 RemovalNotifier::record，只把 (key, 旧值, 原因) 追加到待通知列表；
+- 公共操作释放锁之后调用 flush，把这段时间积累的通知整批交给监听器。
+  ListenerDelivery::Caller 时在触发删除的线程中同步调用监听器；
+  ListenerDelivery::Background 时交给专门的通知线程，调用者不等待监听器。
+所以监听器再慢也不会延长缓存的持锁时间，监听器里也可以再访问同一个缓存。
+
+Caller 模式下，不同线程触发的批次可能同时投递，监听器需要自己保证线程安全；
+Background 模式下所有批次由同一个线程按顺序投递。监听器不能抛出异常。
+没有设置监听器时，record 和 flush 都只检查一个标志位。
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace KamaCache
+{
+
+enum class RemovalCause : uint8_t {
+    Evicted,  // 因容量被淘汰（包括新值超过总容量、写入被拒绝时删掉的旧值）
+    Expired,  // TTL 到期被回收
+    Replaced, // 被同一个 key 的新值覆盖
+    Explicit, // 被 remove 删除
+};
+
+template <typename Key, typename Value>
+struct RemovalNotification {
+    Key key;
+    Value value;
+    RemovalCause cause;
+};
+
+// 监听器一次收到一批通知，可以把其中的 key/value 移走
+template <typename Key, typename Value>
+using RemovalListener = std::function<void(std::vector<RemovalNotification<Key, Value>>& batch)>;
+
+enum class ListenerDelivery {
+    Caller,     // 释放缓存锁之后，在触发删除的线程中调用
+    Background, // 在专门的通知线程中调用
+};
+
+template <typename Key, typename Value>
+class RemovalNotifier
+{
+public:
+    using Notification = RemovalNotification<Key, Value>;
+    using Batch = std::vector<Notification>;
+    using Listener = RemovalListener<Key, Value>;
+
+    RemovalNotifier() : enabled_(false), background_(false), stop_(false) {}
+
+    // 析构前投递完所有积累的通知
+    ~RemovalNotifier() {
+        flush();
+        stopWorker();
+    }
+
+    RemovalNotifier(const RemovalNotifier&) = delete;
+    RemovalNotifier& operator=(const RemovalNotifier&) = delete;
+
+    // 设置（或用空的 listener 取消）监听器。替换之前积累的通知先交给旧的监听器
+    void setListener(Listener listener, ListenerDelivery delivery = ListenerDelivery::Caller) {
+        flush();
+        stopWorker();
+        std::lock_guard<std::mutex> lock(mutex_);
+        listener_ = listener ? std::make_shared<const Listener>(std::move(listener)) : nullptr;
+        background_ = listener_ && delivery == ListenerDelivery::Background;
+        enabled_.store(listener_ != nullptr, std::memory_order_release);
+        if (background_) {
+            stop_ = false;
+            worker_ = std::thread([this]() { run(); });
+        }
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // 在缓存锁内调用：只追加到待通知列表
+    void record(const Key& key, const Value& value, RemovalCause cause) {
+        if (!enabled()) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(Notification{key, value, cause});
+    }
+
+    // 在缓存锁外调用：把积累的通知整批投递
+    void flush() {
+        if (!enabled()) return;
+        Batch batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty()) return;
+            batch.swap(pending_);
+        }
+        deliver(batch);
+    }
+
+    // 直接投递一批外部收集的通知（组合其他缓存的包装类用它转发）
+    void deliver(Batch& batch) {
+        if (batch.empty()) return;
+        std::shared_ptr<const Listener> listener;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!listener_) return;
+            if (background_) {
+                queue_.push_back(std::move(batch));
+                wakeup_.notify_one();
+                return;
+            }
+            listener = listener_;
+        }
+        (*listener)(batch);
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wakeup_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return; // 已停止，剩下的批次都投递完了
+            Batch batch = std::move(queue_.front());
+            queue_.pop_front();
+            std::shared_ptr<const Listener> listener = listener_;
+            lock.unlock();
+            (*listener)(batch);
+            lock.lock();
+        }
+    }
+
+    // 停止通知线程；队列中剩下的批次在线程退出前投递完
+    void stopWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!worker_.joinable()) return;
+            stop_ = true;
+        }
+        wakeup_.notify_one();
+        worker_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        background_ = false;
+    }
+
+private:
+    std::atomic<bool> enabled_;
+    std::mutex mutex_;
+    std::shared_ptr<const Listener> listener_;
+    Batch pending_;
+    bool background_;
+    bool stop_;
+    std::deque<Batch> queue_;
+    std::condition_variable wakeup_;
+    std::thread worker_;
+};
+
+// 放在缓存锁的 guard 之前声明：析构顺序保证先解锁，再投递这次操作积累的通知
+template <typename Key, typename Value>
+class NotifyScope
+{
+public:
+    explicit NotifyScope(RemovalNotifier<Key, Value>& notifier) : notifier_(notifier) {}
+    ~NotifyScope() { notifier_.flush(); }
+
+    NotifyScope(const NotifyScope&) = delete;
+    NotifyScope& operator=(const NotifyScope&) = delete;
+
+private:
+    RemovalNotifier<Key, Value>& notifier_;
+};
+
+} // namespace KamaCache
@@ -0,0 +1,322 @@
+#pragma once
+
+/*
+S3FifoCache：S3-FIFO 淘汰策略（Small / Main / Ghost 三个 FIFO 队列）。
+
+- 新 key 先进入小队列 small（约占容量的 10%），大部分只访问一次的 key 在这里就被淘汰；
+- 从 small 淘汰时，期间被访问过的条目晋升到主队列 main，没被访问过的只把 key 的哈希记入 ghost；
+- 再次写入时如果哈希还在 ghost 中，说明它刚被淘汰不久又回来了，直接进入 main；
+- 从 main 淘汰时，访问计数大于 0 的条目计数减一后重新放回 main 的队尾（类似 CLOCK），为 0 的才被淘汰。
+
+命中只把条目的访问计数（最大为 3）加一，不移动任何链表节点。三个队列都是无锁环形队列（MpmcRing），
+淘汰时不需要全局锁，多个写者可以同时出队、入队。
+
+索引和 BufferedLruCache 一样按哈希分段，每段一个 shared_mutex：get 只拿段的读锁，
+put 和淘汰只在修改索引时短暂拿一个段的写锁。
+
+内存安全：条目由队列“拥有”，只有把它出队的线程可以释放它，而且释放前要先在段写锁下把它从索引中删掉，
+读者只在段读锁内访问条目，所以不会访问到已释放的条目。
+remove 只从索引中删除，条目在下一次出队时才释放，在此之前仍然占用一个位置。
+
+ghost 只记录哈希值：一个 FIFO 队列加一张按哈希直接寻址的表，哈希冲突时旧记录被覆盖，是近似的。
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "KICachePolicy.h"
+#include "MpmcRing.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+template <typename Key, typename Value>
+class S3FifoCache : public KICachePolicy<Key, Value>
+{
+private:
+    struct Entry {
+        Key key_;
+        Value value_;              // 只在持有段写锁时修改
+        uint64_t hash_;
+        std::atomic<uint8_t> freq_{0}; // 访问计数，命中时不加锁地加一
+
+        Entry(Key key, Value value, uint64_t hash)
+        : key_(std::move(key)), value_(std::move(value)), hash_(hash) {}
+    };
+
+    struct Segment {
+        std::shared_mutex mutex_;
+        FlatHashMap<Key, Entry*, KeyHash<Key>, KeyEqual> nodeMap_;
+    };
+
+    static constexpr uint8_t kMaxFreq = 3;
+
+public:
+    // segmentNum 会向上取整为 2 的幂；small 队列占容量的 smallRatio
+    S3FifoCache(int capacity, int segmentNum = 16, double smallRatio = 0.1)
+    : capacity_(capacity > 0 ? static_cast<size_t>(capacity) : 0),
+      smallTarget_(std::max<size_t>(1, static_cast<size_t>(capacity_ * smallRatio))),
+      mainTarget_(capacity_ > smallTarget_ ? capacity_ - smallTarget_ : 1),
+      // 队列留出余量：并发写入时条目数可能短暂超过容量
+      small_(capacity_ * 2 + 64),
+      main_(capacity_ * 2 + 64),
+      ghost_(mainTarget_ + 1),
+      resident_(0),
+      size_(0)
+    {
+        size_t n = 1;
+        while (n < static_cast<size_t>(segmentNum > 0 ? segmentNum : 1)) n <<= 1;
+        segmentMask_ = n - 1;
+        segments_.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            segments_.emplace_back(std::make_unique<Segment>());
+        }
+
+        size_t slots = 2;
+        while (slots < mainTarget_ * 2) slots <<= 1;
+        ghostMask_ = slots - 1;
+        ghostSlots_.reset(new std::atomic<uint64_t>[slots]);
+        for (size_t i = 0; i < slots; ++i) ghostSlots_[i].store(0, std::memory_order_relaxed);
+    }
+
+    // 所有条目都在 small 或 main 队列里
+    ~S3FifoCache() override {
+        Entry* entry;
+        while (small_.tryPop(entry)) delete entry;
+        while (main_.tryPop(entry)) delete entry;
+    }
+
+    S3FifoCache(const S3FifoCache&) = delete;
+    S3FifoCache& operator=(const S3FifoCache&) = delete;
+
+    void put(Key key, Value value) override {
+        if (capacity_ == 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        uint64_t hash = hashOf(key);
+        Segment& segment = segmentFor(hash);
+        Entry* entry;
+        {
+            std::unique_lock<std::shared_mutex> segmentLock(segment.mutex_);
+            auto it = segment.nodeMap_.find(key);
+            if (it != segment.nodeMap_.end()) {
+                notifier_.record(it->second->key_, it->second->value_, RemovalCause::Replaced);
+                it->second->value_ = std::move(value);
+                touch(it->second);
+                stats_.recordUpdate();
+                return;
+            }
+            entry = new Entry(key, std::move(value), hash);
+            segment.nodeMap_.emplace(std::move(key), entry);
+        }
+        stats_.recordInsert();
+        size_.fetch_add(1, std::memory_order_relaxed);
+
+        // 出了段锁再入队：此时条目还不在任何队列中，不会被别人出队释放
+        bool toMain = ghostTake(hash);
+        push(toMain ? main_ : small_, entry);
+        if (resident_.fetch_add(1, std::memory_order_relaxed) + 1 > capacity_) {
+            while (resident_.load(std::memory_order_relaxed) > capacity_ && evictOne()) {}
+        }
+    }
+
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        put(std::move(key), Value(std::forward<Args>(args)...));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 读路径：只拿段读锁，命中时访问计数加一，不移动任何节点。
+    // visitor 在段读锁内被调用
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        Segment& segment = segmentFor(hashOf(key));
+        std::shared_lock<std::shared_mutex> segmentLock(segment.mutex_);
+        auto it = findKey(segment.nodeMap_, key);
+        if (it == segment.nodeMap_.end()) {
+            stats_.recordMiss();
+            return false;
+        }
+        touch(it->second);
+        visitor(static_cast<const Value&>(it->second->value_));
+        stats_.recordHit();
+        return true;
+    }
+
+    // 只从索引中删除；条目在之后出队时释放
+    void remove(const Key& key) {
+        NotifyScope<Key, Value> notify(notifier_);
+        Segment& segment = segmentFor(hashOf(key));
+        std::unique_lock<std::shared_mutex> segmentLock(segment.mutex_);
+        auto it = segment.nodeMap_.find(key);
+        if (it == segment.nodeMap_.end()) return;
+        notifier_.record(it->second->key_, it->second->value_, RemovalCause::Explicit);
+        segment.nodeMap_.erase(it);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        stats_.recordRemoval();
+    }
+
+    // 当前有效条目数（并发写入时是瞬时估计）
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    // 淘汰发生在出队的线程里，通知在这次 put 返回前投递
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+private:
+    template <typename K>
+    static uint64_t hashOf(const K& key) {
+        return mixHash(static_cast<uint64_t>(KeyHash<Key>{}(key)));
+    }
+
+    Segment& segmentFor(uint64_t hash) {
+        return *segments_[(hash >> 32) & segmentMask_];
+    }
+
+    // 访问计数加一，封顶 kMaxFreq。并发命中时偶尔少加一次，不影响正确性
+    static void touch(Entry* entry) {
+        uint8_t freq = entry->freq_.load(std::memory_order_relaxed);
+        if (freq < kMaxFreq) entry->freq_.store(freq + 1, std::memory_order_relaxed);
+    }
+
+    // 队列留有余量，正常情况下不会满；万一满了先淘汰再重试
+    void push(MpmcRing<Entry*>& queue, Entry* entry) {
+        while (!queue.tryPush(entry)) {
+            if (!evictOne()) std::this_thread::yield();
+        }
+    }
+
+    // 条目还在索引中时把它删掉并返回 true；已经被 remove 删掉（或者 key 已对应新条目）时返回 false
+    bool unlink(Entry* entry) {
+        Segment& segment = segmentFor(entry->hash_);
+        std::unique_lock<std::shared_mutex> segmentLock(segment.mutex_);
+        auto it = segment.nodeMap_.find(entry->key_);
+        if (it == segment.nodeMap_.end() || it->second != entry) return false;
+        segment.nodeMap_.erase(it);
+        return true;
+    }
+
+    // 出队直到释放一个条目（有效条目被淘汰，或者回收一个已删除的条目）。两个队列都空时返回 false
+    bool evictOne() {
+        for (;;) {
+            Entry* entry = nullptr;
+            bool fromSmall = small_.size() > smallTarget_ || main_.size() == 0;
+            if (fromSmall) {
+                if (!small_.tryPop(entry)) {
+                    fromSmall = false;
+                    if (!main_.tryPop(entry)) return false;
+                }
+            } else if (!main_.tryPop(entry)) {
+                fromSmall = true;
+                if (!small_.tryPop(entry)) return false;
+            }
+
+            uint8_t freq = entry->freq_.load(std::memory_order_relaxed);
+            if (fromSmall && freq > 0) {
+                // 在 small 期间被再次访问过：晋升到 main
+                push(main_, entry);
+                continue;
+            }
+            if (!fromSmall && freq > 0) {
+                // main 中访问过的条目再给一次机会
+                entry->freq_.store(freq - 1, std::memory_order_relaxed);
+                push(main_, entry);
+                continue;
+            }
+
+            if (unlink(entry)) {
+                if (fromSmall) ghostInsert(entry->hash_);
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                stats_.recordEviction();
+                // 已经不在索引中，别的线程再也拿不到它，不需要段锁
+                notifier_.record(entry->key_, entry->value_, RemovalCause::Evicted);
+            }
+            resident_.fetch_sub(1, std::memory_order_relaxed);
+            delete entry;
+            return true;
+        }
+    }
+
+    // ghost 中的记录：哈希值的最低位置 1，0 表示空
+    static uint64_t ghostTag(uint64_t hash) { return hash | 1; }
+
+    std::atomic<uint64_t>& ghostSlot(uint64_t hash) {
+        return ghostSlots_[(hash >> 7) & ghostMask_];
+    }
+
+    void ghostInsert(uint64_t hash) {
+        uint64_t tag = ghostTag(hash);
+        uint64_t old;
+        // ghost 只保留最近 mainTarget_ 个被淘汰的哈希
+        while (ghost_.size() >= mainTarget_ || !ghost_.tryPush(tag)) {
+            // 队头被另一个线程占住但还没发布时让出 CPU，和 push 的退避方式一致
+            if (!ghost_.tryPop(old)) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint64_t expected = old;
+            ghostSlot(old).compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+        }
+        ghostSlot(hash).store(tag, std::memory_order_relaxed);
+    }
+
+    // 哈希在 ghost 中时消费这条记录并返回 true
+    bool ghostTake(uint64_t hash) {
+        uint64_t expected = ghostTag(hash);
+        return ghostSlot(hash).compare_exchange_strong(expected, 0, std::memory_order_relaxed);
+    }
+
+private:
+    size_t capacity_;
+    size_t smallTarget_;
+    size_t mainTarget_;
+    size_t segmentMask_;
+    std::vector<std::unique_ptr<Segment>> segments_;
+
+    MpmcRing<Entry*> small_;
+    MpmcRing<Entry*> main_;
+    MpmcRing<uint64_t> ghost_;
+    std::unique_ptr<std::atomic<uint64_t>[]> ghostSlots_;
+    size_t ghostMask_;
+
+    std::atomic<size_t> resident_; // 队列中的条目数，包括已 remove 但还没出队的
+    std::atomic<size_t> size_;     // 索引中的有效条目数
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
@@ -0,0 +1,360 @@
+#pragma once
+
+/*
+SetAssocCache：组相联（set-associative）缓存，用于键和值都是小的平凡可拷贝类型（如 64 位 ID -> POD）的场景。
+
+- 所有条目放在一块连续的数组里，分成若干个组（set），每组固定 Ways 路（8 或 16）；
+  key 的哈希值决定它所在的组，只能放在这一组的某一路里，没有哈希表节点，也没有链表节点；
+- 每组开头是 Ways 个 1 字节的标签：0 表示空，否则是 0x80 | 哈希值的 7 位指纹。
+  查找时用 SIMD 一次比较整组的标签，只有指纹相同的路才比较 key，一次 get/put 通常只访问组头和一个槽位；
+- 组内用 CLOCK 替换：命中时置访问位，组满时从指针处开始找第一个访问位为 0 的路淘汰，
+  经过的路清掉访问位（给一次“第二次机会”）。新写入的条目访问位为 0；
+- 每组有自己的自旋锁，不同组上的操作完全并行。
+
+和 LruCache 的区别：淘汰只在组内进行，是近似的 LRU；实际容量是 capacity 向上取整到 Ways 的倍数；
+不支持 TTL、权重和快照。CompactLruCache<Key, Value> 在编译期按类型在两者之间选择。
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "KICachePolicy.h"
+#include "LruCache.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+// 每个组一个字节的自旋锁：临界区只有几十条指令，比 std::mutex 小得多也快得多。
+// 提供 lock/try_lock/unlock，可以直接用于 TimedLockGuard
+class SpinLock
+{
+public:
+    void lock() {
+        for (int spins = 0; !try_lock(); ++spins) {
+            // 先忙等一小会儿，持锁线程被调度走时让出 CPU
+            if (spins < 64) {
+                cpuRelax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool try_lock() {
+        return !locked_.load(std::memory_order_relaxed) &&
+               !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() { locked_.store(false, std::memory_order_release); }
+
+private:
+    static void cpuRelax() {
+#if defined(__SSE2__)
+        _mm_pause();
+#endif
+    }
+
+    std::atomic<bool> locked_{false};
+};
+
+template <typename Key, typename Value, size_t Ways = 16>
+class SetAssocCache : public KICachePolicy<Key, Value>
+{
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "SetAssocCache needs trivially copyable Key and Value");
+    static_assert(Ways == 8 || Ways == 16, "SetAssocCache supports 8 or 16 ways");
+
+public:
+    // capacity 向上取整到 Ways 的倍数
+    SetAssocCache(int capacity)
+    : setNum_(capacity > 0 ? (static_cast<size_t>(capacity) + Ways - 1) / Ways : 0),
+      sets_(new Set[setNum_])
+    {}
+
+    ~SetAssocCache() override = default;
+
+    void put(Key key, Value value) override {
+        if (setNum_ == 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        uint64_t hash = hashOf(key);
+        Set& set = setOf(hash);
+        TimedLockGuard<SpinLock> lock(set.lock, stats_);
+        putInternal(set, tagOf(hash), key, value);
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return visit<Key>(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 命中时在组锁内把值交给 visitor
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        if (setNum_ == 0) {
+            stats_.recordMiss();
+            return false;
+        }
+
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        uint64_t hash = hashOf(key);
+        Set& set = setOf(hash);
+        TimedLockGuard<SpinLock> lock(set.lock, stats_);
+        int way = findWay(set, tagOf(hash), key);
+        if (way < 0) {
+            stats_.recordMiss();
+            return false;
+        }
+        touch(set, way);
+        visitor(set.slots[way].value);
+        stats_.recordHit();
+        return true;
+    }
+
+    // 批量获取：先算出所有 key 所在的组并预取组头，再逐个查找
+    size_t getMany(const Key* keys, size_t count, Value* values, bool* hits) override {
+        if (setNum_ == 0) {
+            for (size_t i = 0; i < count; ++i) hits[i] = false;
+            stats_.recordMiss(count);
+            return 0;
+        }
+        size_t hitCount = 0;
+        forEachBatch(keys, count, [&](size_t i, Set& set, uint8_t tag) {
+            TimedLockGuard<SpinLock> lock(set.lock, stats_);
+            int way = findWay(set, tag, keys[i]);
+            hits[i] = way >= 0;
+            if (!hits[i]) return;
+            touch(set, way);
+            values[i] = set.slots[way].value;
+            ++hitCount;
+        });
+        stats_.recordHit(hitCount);
+        stats_.recordMiss(count - hitCount);
+        return hitCount;
+    }
+
+    // 批量插入：同样先预取所有组头
+    void putMany(const Key* keys, const Value* values, size_t count) override {
+        if (setNum_ == 0) return;
+        NotifyScope<Key, Value> notify(notifier_);
+        forEachBatch(keys, count, [&](size_t i, Set& set, uint8_t tag) {
+            TimedLockGuard<SpinLock> lock(set.lock, stats_);
+            putInternal(set, tag, keys[i], values[i]);
+        });
+    }
+
+    void remove(const Key& key) {
+        if (setNum_ == 0) return;
+
+        NotifyScope<Key, Value> notify(notifier_);
+        uint64_t hash = hashOf(key);
+        Set& set = setOf(hash);
+        TimedLockGuard<SpinLock> lock(set.lock, stats_);
+        int way = findWay(set, tagOf(hash), key);
+        if (way < 0) return;
+        notifier_.record(set.slots[way].key, set.slots[way].value, RemovalCause::Explicit);
+        set.tags[way] = kEmpty;
+        set.referenced &= static_cast<uint16_t>(~(1u << way));
+        stats_.recordRemoval();
+    }
+
+    // 实际容量：组数 * 路数
+    size_t capacity() const { return setNum_ * Ways; }
+
+    // 当前条目数：逐组加锁统计，不给读写路径增加计数的开销。
+    // 各组不是同时统计的，并发写入时结果只是一个近似值
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < setNum_; ++i) {
+            Set& set = sets_[i];
+            std::lock_guard<SpinLock> lock(set.lock);
+            for (size_t way = 0; way < Ways; ++way) {
+                total += set.tags[way] != kEmpty;
+            }
+        }
+        return total;
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+private:
+    static constexpr uint8_t kEmpty = 0;
+    static constexpr size_t kBatch = 16;
+
+    struct Slot {
+        Key key;
+        Value value;
+    };
+
+    // 标签放在组的开头，和锁、CLOCK 状态在同一个缓存行里
+    struct alignas(16) Set {
+        uint8_t tags[Ways] = {};   // 0 为空，否则为 0x80 | 7 位指纹
+        SpinLock lock;
+        uint8_t hand = 0;          // CLOCK 指针
+        uint16_t referenced = 0;   // CLOCK 访问位，每路一位
+        Slot slots[Ways];
+    };
+
+    static uint64_t hashOf(const Key& key) {
+        return mixHash(static_cast<uint64_t>(KeyHash<Key>{}(key)));
+    }
+
+    // 低 7 位做指纹，高位选组，两者互不相关
+    static uint8_t tagOf(uint64_t hash) {
+        return static_cast<uint8_t>(0x80 | (hash & 0x7F));
+    }
+
+    Set& setOf(uint64_t hash) const {
+#if defined(__SIZEOF_INT128__)
+        // 乘法取高位代替取模，组数不必是 2 的幂
+        size_t index = static_cast<size_t>((static_cast<unsigned __int128>(hash) * setNum_) >> 64);
+#else
+        size_t index = static_cast<size_t>(hash % setNum_);
+#endif
+        return sets_[index];
+    }
+
+    // 标签等于 tag 的路的位图
+    static uint32_t matchTags(const Set& set, uint8_t tag) {
+#if defined(__SSE2__)
+        __m128i needle = _mm_set1_epi8(static_cast<char>(tag));
+        if constexpr (Ways == 16) {
+            __m128i tags = _mm_load_si128(reinterpret_cast<const __m128i*>(set.tags));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(tags, needle)));
+        } else {
+            __m128i tags = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(set.tags));
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(tags, needle))) & 0xFF;
+        }
+#else
+        uint32_t mask = 0;
+        for (size_t way = 0; way < Ways; ++way) {
+            if (set.tags[way] == tag) mask |= uint32_t(1) << way;
+        }
+        return mask;
+#endif
+    }
+
+    static int findWay(const Set& set, uint8_t tag, const Key& key) {
+        for (uint32_t mask = matchTags(set, tag); mask != 0; mask &= mask - 1) {
+            int way = static_cast<int>(lowestBit(mask));
+            if (KeyEqual{}(set.slots[way].key, key)) return way;
+        }
+        return -1;
+    }
+
+    // 已经置位时不再写，避免热点读反复弄脏缓存行
+    static void touch(Set& set, int way) {
+        uint16_t bit = static_cast<uint16_t>(1u << way);
+        if (!(set.referenced & bit)) set.referenced |= bit;
+    }
+
+    // CLOCK：从指针开始，访问位为 1 的清零跳过，第一个为 0 的就是淘汰对象。最多转两圈
+    static int clockVictim(Set& set) {
+        for (;;) {
+            int way = set.hand;
+            set.hand = static_cast<uint8_t>((way + 1) % Ways);
+            uint16_t bit = static_cast<uint16_t>(1u << way);
+            if (!(set.referenced & bit)) return way;
+            set.referenced &= static_cast<uint16_t>(~bit);
+        }
+    }
+
+    // 调用者持有组锁
+    void putInternal(Set& set, uint8_t tag, const Key& key, const Value& value) {
+        int way = findWay(set, tag, key);
+        if (way >= 0) {
+            notifier_.record(key, set.slots[way].value, RemovalCause::Replaced);
+            set.slots[way].value = value;
+            touch(set, way);
+            stats_.recordUpdate();
+            return;
+        }
+
+        uint32_t empty = matchTags(set, kEmpty);
+        if (empty != 0) {
+            way = static_cast<int>(lowestBit(empty));
+        } else {
+            way = clockVictim(set);
+            stats_.recordEviction();
+            notifier_.record(set.slots[way].key, set.slots[way].value, RemovalCause::Evicted);
+        }
+        set.tags[way] = tag;
+        set.slots[way].key = key;
+        set.slots[way].value = value;
+        set.referenced &= static_cast<uint16_t>(~(1u << way));
+        stats_.recordInsert();
+    }
+
+    // 每 kBatch 个 key 一段：先算哈希、预取组头，再依次调用 fn(i, set, tag)。调用者保证 setNum_ > 0
+    template <typename Fn>
+    void forEachBatch(const Key* keys, size_t count, Fn&& fn) {
+        Set* sets[kBatch];
+        uint8_t tags[kBatch];
+        for (size_t begin = 0; begin < count; begin += kBatch) {
+            size_t end = begin + kBatch < count ? begin + kBatch : count;
+            for (size_t i = begin; i < end; ++i) {
+                uint64_t hash = hashOf(keys[i]);
+                sets[i - begin] = &setOf(hash);
+                tags[i - begin] = tagOf(hash);
+                prefetch(sets[i - begin]);
+            }
+            for (size_t i = begin; i < end; ++i) {
+                fn(i, *sets[i - begin], tags[i - begin]);
+            }
+        }
+    }
+
+private:
+    size_t setNum_;
+    std::unique_ptr<Set[]> sets_;
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+// 键和值都是不超过 16 字节的平凡可拷贝类型时，使用组相联缓存
+template <typename Key, typename Value>
+struct IsCompactCacheable
+    : std::integral_constant<bool,
+                             std::is_trivially_copyable<Key>::value &&
+                             std::is_trivially_copyable<Value>::value &&
+                             std::is_default_constructible<Key>::value &&
+                             std::is_default_constructible<Value>::value &&
+                             sizeof(Key) <= 16 && sizeof(Value) <= 16> {};
+
+// 编译期选择：小的平凡可拷贝类型用 SetAssocCache，其他类型用 LruCache。两者构造函数都是 (int capacity)
+template <typename Key, typename Value>
+using CompactLruCache = std::conditional_t<IsCompactCacheable<Key, Value>::value,
+                                           SetAssocCache<Key, Value>,
+                                           LruCache<Key, Value>>;
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
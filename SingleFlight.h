@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+SingleFlight：合并同一个 key 上并发的加载请求。
+
+同一时刻对同一个 key 只有一个调用者（leader）真正执行加载函数，其他调用者拿到同一个
+shared_future 等待结果。等待发生在 SingleFlight 自己的锁之外，也不持有任何缓存的锁。
+加载函数抛出的异常会原样交给这一轮的所有等待者；加载结束后记录被删除，下一次调用重新加载。
+
+getOrLoad 用调用者持有的 SingleFlight 给任意缓存加上读穿：缓存接口本身不保存加载状态，
+只有需要合并加载的调用者才付出一个 SingleFlight 的开销。
+*/
+
+#include <exception>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace KamaCache
+{
+
+template <typename Key, typename Value>
+class SingleFlight
+{
+public:
+    using KeyType = Key;
+
+    // 执行 fn（同一个 key 同时只执行一次）并返回它的结果；fn 抛出的异常会传给所有等待者
+    template <typename Fn>
+    Value run(const Key& key, Fn&& fn) {
+        std::promise<Value> promise;
+        std::shared_future<Value> future;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = calls_.find(key);
+            if (it != calls_.end()) {
+                future = it->second;
+            } else {
+                future = promise.get_future().share();
+                calls_.emplace(key, future);
+                leader = true;
+            }
+        }
+
+        // 已经有人在加载：不持任何锁，等它的结果
+        if (!leader) return future.get();
+
+        try {
+            promise.set_value(fn());
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+        // 结果已经交给等待者，之后来的调用者重新走一遍（通常会在缓存里命中）
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            calls_.erase(key);
+        }
+        return future.get();
+    }
+
+    // 正在加载的 key 个数
+    size_t inFlight() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls_.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<Key, std::shared_future<Value>> calls_;
+};
+
+// 读穿（read-through）：命中直接返回；未命中时调用 loader(key) 加载并写入 cache。
+// 经过同一个 flight 的并发未命中只有一个调用者执行 loader，其他调用者等待它的结果，
+// 不会一起打到后端存储。loader 在缓存的锁之外执行；它抛出的异常会传给这一轮
+// 所有等待的调用者，结果不写入缓存，下一次调用重新加载。
+// Cache 只需要提供 get(key, value) 和 put(key, value)，例如任意 KICachePolicy
+template <typename Cache, typename Key, typename Value, typename Loader>
+Value getOrLoad(Cache& cache, SingleFlight<Key, Value>& flight,
+                const typename SingleFlight<Key, Value>::KeyType& key, Loader&& loader) {
+    Value value;
+    if (cache.get(key, value)) return value;
+    return flight.run(key, [&]() {
+        // 成为 leader 之前，上一轮加载可能刚刚写入缓存，再查一次
+        Value loaded;
+        if (cache.get(key, loaded)) return loaded;
+        loaded = loader(key);
+        cache.put(key, loaded);
+        return loaded;
+    });
+}
+
+} // namespace KamaCache
@@ -0,0 +1,242 @@
+#pragma once
+
+/*
+SlabLruCache：LruCache 的另一种存储方式。
+所有节点预先分配在一块连续的数组（slab）里，大小等于 capacity_，
+链表的 prev_/next_ 用 32 位下标代替 shared_ptr，空闲节点串成一个空闲链表（free list）。
+这样稳态下的 put/get 不再有堆分配和原子引用计数，链表遍历也更加缓存友好。
+
+下标 capacity_ 处是哨兵节点，组成一个循环双向链表：
+哨兵的 next_ 指向最久未使用的节点，哨兵的 prev_ 指向最近访问的节点，
+和 LruCache 中 dummyHead_/dummyTail_ 的语义一致。
+*/
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "KICachePolicy.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+// slab 中的节点：链表指针是数组下标
+template <typename Key, typename Value>
+struct SlabLruNode {
+    Key key_;
+    Value value_;
+    uint32_t prev_;
+    uint32_t next_;
+};
+
+template <typename Key, typename Value>
+class SlabLruCache : public KICachePolicy<Key, Value>
+{
+public:
+    using NodeType = SlabLruNode<Key, Value>;
+    using Index = uint32_t;
+    // 哈希表只保存节点下标
+    using NodeMap = std::unordered_map<Key, Index, KeyHash<Key>, KeyEqual>;
+
+    static constexpr Index kNull = std::numeric_limits<Index>::max();
+
+    SlabLruCache(int capacity) : capacity_(capacity > 0 ? capacity : 0) {
+        if (static_cast<uint64_t>(capacity_) >= kNull) {
+            throw std::invalid_argument("SlabLruCache capacity exceeds 32-bit index range.");
+        }
+        initializeSlab();
+    }
+
+    ~SlabLruCache() override = default;
+
+    void put(Key key, Value value) override {
+        if (capacity_ <= 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it != nodeMap_.end()) {
+            stats_.recordUpdate();
+            notifier_.record(key, nodes_[it->second].value_, RemovalCause::Replaced);
+            nodes_[it->second].value_ = std::move(value);
+            moveToMostRecent(it->second);
+            return;
+        }
+
+        addNewNode(std::move(key), std::move(value));
+    }
+
+    // 原地构造 value：槽位是预分配的，这里直接用参数构造的新值替换
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        put(std::move(key), Value(std::forward<Args>(args)...));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return get<Key>(key, value);
+    }
+
+    // 异构查找：例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = findKey(nodeMap_, key);
+        if (it != nodeMap_.end()) {
+            moveToMostRecent(it->second);
+            value = nodes_[it->second].value_;
+            stats_.recordHit();
+            return true;
+        }
+        stats_.recordMiss();
+        return false;
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    // 零拷贝读取：命中时在持锁状态下把值的 const 引用交给 visitor
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = findKey(nodeMap_, key);
+        if (it == nodeMap_.end()) {
+            stats_.recordMiss();
+            return false;
+        }
+        moveToMostRecent(it->second);
+        visitor(nodes_[it->second].value_);
+        stats_.recordHit();
+        return true;
+    }
+
+    void remove(const Key& key) {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it != nodeMap_.end()) {
+            Index index = it->second;
+            notifier_.record(nodes_[index].key_, nodes_[index].value_, RemovalCause::Explicit);
+            removeNode(index);
+            releaseNode(index);
+            nodeMap_.erase(it);
+            stats_.recordRemoval();
+        }
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+    size_t size() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return nodeMap_.size();
+    }
+
+private:
+    void initializeSlab() {
+        // 多出的一个节点作为哨兵
+        nodes_.resize(static_cast<size_t>(capacity_) + 1);
+        sentinel_ = static_cast<Index>(capacity_);
+        nodes_[sentinel_].prev_ = sentinel_;
+        nodes_[sentinel_].next_ = sentinel_;
+
+        // 所有节点串成空闲链表
+        freeHead_ = kNull;
+        for (Index i = static_cast<Index>(capacity_); i-- > 0;) {
+            nodes_[i].next_ = freeHead_;
+            nodes_[i].prev_ = kNull;
+            freeHead_ = i;
+        }
+
+        // 预留桶，避免运行中 rehash
+        nodeMap_.reserve(static_cast<size_t>(capacity_));
+    }
+
+    void addNewNode(Key key, Value value) {
+        stats_.recordInsert();
+        if (freeHead_ == kNull) {
+            stats_.recordEviction();
+            // 缓存已满：直接复用最久未使用节点的 slab 槽位和哈希表节点，不产生新的分配
+            Index victim = nodes_[sentinel_].next_;
+            notifier_.record(nodes_[victim].key_, nodes_[victim].value_, RemovalCause::Evicted);
+            removeNode(victim);
+            auto handle = nodeMap_.extract(nodes_[victim].key_);
+            handle.key() = std::move(key);
+            nodes_[victim].key_ = handle.key();
+            nodes_[victim].value_ = std::move(value);
+            insertNode(victim);
+            handle.mapped() = victim;
+            nodeMap_.insert(std::move(handle));
+            return;
+        }
+
+        Index index = freeHead_;
+        freeHead_ = nodes_[index].next_;
+        nodes_[index].key_ = key;
+        nodes_[index].value_ = std::move(value);
+        insertNode(index);
+        nodeMap_.emplace(std::move(key), index);
+    }
+
+    // 把节点放回空闲链表
+    void releaseNode(Index index) {
+        nodes_[index].value_ = Value();
+        nodes_[index].prev_ = kNull;
+        nodes_[index].next_ = freeHead_;
+        freeHead_ = index;
+    }
+
+    void moveToMostRecent(Index index) {
+        removeNode(index);
+        insertNode(index);
+    }
+
+    void removeNode(Index index) {
+        NodeType& node = nodes_[index];
+        nodes_[node.prev_].next_ = node.next_;
+        nodes_[node.next_].prev_ = node.prev_;
+    }
+
+    // 插入到哨兵之前（最近访问的位置）
+    void insertNode(Index index) {
+        NodeType& node = nodes_[index];
+        node.next_ = sentinel_;
+        node.prev_ = nodes_[sentinel_].prev_;
+        nodes_[node.prev_].next_ = index;
+        nodes_[sentinel_].prev_ = index;
+    }
+
+private:
+    int capacity_;
+    std::mutex mutex_;
+    std::vector<NodeType> nodes_; // 预分配的节点数组
+    Index sentinel_;
+    Index freeHead_;              // 空闲链表头
+    NodeMap nodeMap_;
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
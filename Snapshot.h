@@ -0,0 +1,293 @@
+#pragma once
+
+/*
+Snapshot：缓存内容的快照文件，用于重启后预热（warm restart）。
+
+文件格式（本机字节序，只在同一种机器之间使用）：
+    头部：magic[8] | policy(u32) | reserved(u32) | count(u64)
+    之后是 count 条记录，每条记录的布局由各缓存自己决定（元数据 + key + value）。
+
+写入：SnapshotWriter 先写到 path.tmp，用大块缓冲顺序写出，finish() 补上条目数后 rename 到 path，
+      写到一半失败不会留下半个快照。
+读取：SnapshotReader 用 mmap 映射整个文件，按顺序解析，不做逐条的系统调用。
+
+key/value 的编码由 Serializer<T> 决定：平凡可拷贝（trivially copyable）的类型直接按字节拷贝，
+std::string 写长度加内容；其他类型需要特化 KamaCache::Serializer<T>，提供
+    static void write(SnapshotWriter& out, const T& value);
+    static bool read(SnapshotReader& in, T& value);
+内置的 Serializer 对输出/输入流是模板：同样的编码也可以写进内存中的 ByteWriter、从 ByteReader 读出
+（FileTier 用它们编码落盘的记录）。自定义类型要写入 FileTier，把 write/read 也写成流类型的模板即可。
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KamaCache
+{
+
+// 快照所属的缓存类型，加载时校验，防止把 LFU 的快照读进 LRU
+enum class SnapshotPolicy : uint32_t { Lru = 1, Lfu = 2, LruK = 3 };
+
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(const std::string& path, SnapshotPolicy policy)
+    : path_(path), tmpPath_(path + ".tmp"), count_(0), ok_(true)
+    {
+        file_ = std::fopen(tmpPath_.c_str(), "wb");
+        ok_ = file_ != nullptr;
+        buffer_.reserve(kBufferSize);
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(header.magic));
+        header.policy = static_cast<uint32_t>(policy);
+        writeBytes(&header, sizeof(header));
+    }
+
+    ~SnapshotWriter() {
+        if (file_) {
+            std::fclose(file_);
+            std::remove(tmpPath_.c_str());
+        }
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    void writeBytes(const void* data, size_t size) {
+        if (!ok_) return;
+        const char* bytes = static_cast<const char*>(data);
+        if (buffer_.size() + size > kBufferSize) flush();
+        if (size > kBufferSize) {
+            ok_ = std::fwrite(bytes, 1, size, file_) == size;
+            return;
+        }
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void writePod(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "writePod needs a trivially copyable type");
+        writeBytes(&value, sizeof(T));
+    }
+
+    // 每写完一条记录调用一次
+    void endRecord() { ++count_; }
+
+    // 补上条目数并替换旧快照，返回是否成功
+    bool finish() {
+        if (!file_) return false;
+        flush();
+        if (ok_) ok_ = std::fseek(file_, offsetof(Header, count), SEEK_SET) == 0;
+        if (ok_) ok_ = std::fwrite(&count_, sizeof(count_), 1, file_) == 1;
+        if (ok_) ok_ = std::fflush(file_) == 0;
+        ok_ = std::fclose(file_) == 0 && ok_;
+        file_ = nullptr;
+        if (ok_) ok_ = std::rename(tmpPath_.c_str(), path_.c_str()) == 0;
+        if (!ok_) std::remove(tmpPath_.c_str());
+        return ok_;
+    }
+
+private:
+    friend class SnapshotReader;
+
+    static constexpr size_t kBufferSize = 1 << 20;
+    static constexpr char kMagic[8] = {'K', 'C', 'S', 'N', 'A', 'P', '\0', '\1'};
+
+    struct Header {
+        char magic[8];
+        uint32_t policy;
+        uint32_t reserved;
+        uint64_t count;
+    };
+
+    void flush() {
+        if (ok_ && !buffer_.empty()) {
+            ok_ = std::fwrite(buffer_.data(), 1, buffer_.size(), file_) == buffer_.size();
+        }
+        buffer_.clear();
+    }
+
+private:
+    std::string path_;
+    std::string tmpPath_;
+    std::FILE* file_;
+    std::vector<char> buffer_;
+    uint64_t count_;
+    bool ok_;
+};
+
+class SnapshotReader
+{
+public:
+    // 映射文件并校验头部；失败时 ok() 为 false
+    SnapshotReader(const std::string& path, SnapshotPolicy policy)
+    : data_(nullptr), size_(0), pos_(0), count_(0), ok_(false)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(Header))) {
+            size_ = static_cast<size_t>(st.st_size);
+            void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const char*>(addr);
+                ::madvise(addr, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd); // 映射建立之后可以关闭文件描述符
+
+        SnapshotWriter::Header header;
+        if (!data_ || !readBytes(&header, sizeof(header))) return;
+        ok_ = std::memcmp(header.magic, SnapshotWriter::kMagic, sizeof(header.magic)) == 0 &&
+              header.policy == static_cast<uint32_t>(policy);
+        count_ = header.count;
+    }
+
+    ~SnapshotReader() {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool ok() const { return ok_; }
+    uint64_t count() const { return count_; }
+
+    // 剩下的数据最多还能放下几条记录（每条至少 minRecordBytes 字节），不超过 count()。
+    // count 来自文件头，损坏或被截断的快照里可能大得离谱，按它预分配之前先用这个上限截一下
+    uint64_t boundedCount(size_t minRecordBytes) const {
+        return std::min<uint64_t>(count_, (size_ - pos_) / std::max<size_t>(minRecordBytes, 1));
+    }
+
+    bool readBytes(void* out, size_t size) {
+        if (size > size_ - pos_) {
+            ok_ = false;
+            return false;
+        }
+        std::memcpy(out, data_ + pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+    // 直接返回映射内存中的 size 个字节，不拷贝；越界时返回 nullptr
+    const char* readView(size_t size) {
+        if (size > size_ - pos_) {
+            ok_ = false;
+            return nullptr;
+        }
+        const char* view = data_ + pos_;
+        pos_ += size;
+        return view;
+    }
+
+    template <typename T>
+    bool readPod(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "readPod needs a trivially copyable type");
+        return readBytes(&value, sizeof(T));
+    }
+
+private:
+    using Header = SnapshotWriter::Header;
+
+    const char* data_;
+    size_t size_;
+    size_t pos_;
+    uint64_t count_;
+    bool ok_;
+};
+
+// 追加写入内存缓冲区的输出流，接口和 SnapshotWriter 相同
+class ByteWriter
+{
+public:
+    explicit ByteWriter(std::vector<char>& buffer) : buffer_(buffer) {}
+
+    void writeBytes(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void writePod(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "writePod needs a trivially copyable type");
+        writeBytes(&value, sizeof(T));
+    }
+
+private:
+    std::vector<char>& buffer_;
+};
+
+// 从一段内存中顺序读取的输入流，接口和 SnapshotReader 相同，越界时返回 false
+class ByteReader
+{
+public:
+    ByteReader(const char* data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+    bool readBytes(void* out, size_t size) {
+        if (size > size_ - pos_) return false;
+        std::memcpy(out, data_ + pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+    const char* readView(size_t size) {
+        if (size > size_ - pos_) return nullptr;
+        const char* view = data_ + pos_;
+        pos_ += size;
+        return view;
+    }
+
+    template <typename T>
+    bool readPod(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "readPod needs a trivially copyable type");
+        return readBytes(&value, sizeof(T));
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+// key/value 的编码：默认只支持平凡可拷贝的类型，其他类型需要特化
+template <typename T, typename Enable = void>
+struct Serializer;
+
+template <typename T>
+struct Serializer<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    template <typename Out>
+    static void write(Out& out, const T& value) { out.writePod(value); }
+    template <typename In>
+    static bool read(In& in, T& value) { return in.readPod(value); }
+};
+
+template <>
+struct Serializer<std::string> {
+    template <typename Out>
+    static void write(Out& out, const std::string& value) {
+        out.template writePod<uint64_t>(value.size());
+        out.writeBytes(value.data(), value.size());
+    }
+    template <typename In>
+    static bool read(In& in, std::string& value) {
+        uint64_t size;
+        if (!in.readPod(size)) return false;
+        const char* bytes = in.readView(size);
+        if (!bytes) return false;
+        value.assign(bytes, size);
+        return true;
+    }
+};
+
+} // namespace KamaCache
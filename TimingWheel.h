@@ -0,0 +1,208 @@
+#pragma once
+
+/*
+TimingWheel：分层时间轮，用来驱动缓存条目的 TTL 过期。
+
+时间被切成固定长度的 tick（默认 1 毫秒）。共 kLevels 层，每层 kSlots 个槽：
+第 0 层的一个槽是 1 个 tick，第 1 层的一个槽是 kSlots 个 tick，依此类推。
+到期时间离现在越远，放在越高的层；时间推进到高层某个槽的起点时，
+把这个槽里的条目重新分配（cascade）到低层，最终在第 0 层对应的槽里到期。
+schedule 是 O(1)，advance 对每个条目摊还 O(kLevels)，不需要扫描缓存的哈希表。
+每层用一个 64 位的占用位图记录哪些槽非空，advance 直接跳到下一个非空的第 0 层槽或下一次非空槽的 cascade，
+中间的空 tick 不逐个走：长时间空闲之后的第一次推进也只做 O(kLevels) 次跳跃，而不是按 tick 数计。
+
+时间轮只保存 (key, 到期 tick)，不持有缓存节点。缓存条目被删除或淘汰时不用通知时间轮：
+到期时缓存用到期 tick 和节点当前那条记录的 tick 比较，不一致就说明是过时的记录，直接忽略。
+缓存给每个节点最多登记一条有效记录：到期时间推后时不重新登记，而是在旧记录触发时再放回去，
+所以反复用 TTL 覆盖同一个 key，时间轮里的记录数也不会超过条目数。
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "KICachePolicy.h"
+
+namespace KamaCache
+{
+
+template <typename Key>
+class TimingWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimingWheel(std::chrono::nanoseconds tick = std::chrono::milliseconds(1))
+    : tick_(tick.count() > 0 ? tick : std::chrono::nanoseconds(1)),
+      start_(Clock::now()),
+      currentTick_(0),
+      count_(0),
+      occupied_{}
+    {}
+
+    // 还有多少条记录（包括过时的）没有到期
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    // 当前时刻对应的 tick
+    uint64_t now() const {
+        return static_cast<uint64_t>((Clock::now() - start_) / tick_);
+    }
+
+    // 从现在起经过 ttl 之后的到期 tick，向上取整，至少比当前 tick 晚 1
+    uint64_t deadlineAfter(std::chrono::nanoseconds ttl) const {
+        uint64_t ticks = ttl.count() <= 0 ? 1 : static_cast<uint64_t>((ttl + tick_ - std::chrono::nanoseconds(1)) / tick_);
+        return std::max(now(), currentTick_) + std::max<uint64_t>(ticks, 1);
+    }
+
+    // 到期 tick 离现在还有多久，已经到期时返回 0
+    std::chrono::nanoseconds remaining(uint64_t deadline) const {
+        uint64_t current = std::max(now(), currentTick_);
+        return deadline > current ? tick_ * static_cast<int64_t>(deadline - current) : std::chrono::nanoseconds(0);
+    }
+
+    // 登记一个到期时间
+    void schedule(const Key& key, uint64_t deadline) {
+        // 槽位在第一次登记时才分配，从不使用 TTL 的缓存没有额外内存
+        if (slots_.empty()) slots_.resize(kLevels * kSlots);
+        // 已经处理过当前 tick 的槽，最早只能在下一个 tick 到期
+        place(Entry{key, deadline}, currentTick_ + 1);
+        ++count_;
+    }
+
+    // 删除所有记录，不回调（缓存被整体清空时用）。只清理非空的槽，槽位的内存保留；tick 不回退
+    void clear() {
+        for (size_t level = 0; level < kLevels; ++level) {
+            for (uint64_t bits = occupied_[level]; bits != 0; bits &= bits - 1) {
+                slot(level, lowestBit(bits)).clear();
+            }
+            occupied_[level] = 0;
+        }
+        count_ = 0;
+    }
+
+    // 把时间轮推进到 nowTick，每个到期的记录调用一次 onExpire(key, deadline)。
+    // 同一个槽的记录一起交出，调用者可以在一次加锁内批量回收；onExpire 里可以再调用 schedule 把记录放回去。
+    // 返回到期的记录数
+    template <typename OnExpire>
+    size_t advance(uint64_t nowTick, OnExpire&& onExpire) {
+        size_t expired = 0;
+        while (currentTick_ < nowTick) {
+            // 跳过中间什么都不发生的 tick；没有任何记录时直接跳到当前时间
+            uint64_t next = count_ == 0 ? nowTick + 1 : nextEventTick();
+            if (next > nowTick) {
+                currentTick_ = nowTick;
+                break;
+            }
+            currentTick_ = next;
+
+            // 从高层往低层 cascade，高层移下来的记录如果落进本 tick 要 cascade 的低层槽，也能被处理
+            for (size_t level = kLevels - 1; level > 0; --level) {
+                if ((currentTick_ & ((uint64_t(1) << (kSlotBits * level)) - 1)) == 0) {
+                    cascade(level, slotIndex(currentTick_, level));
+                }
+            }
+
+            size_t index = slotIndex(currentTick_, 0);
+            std::vector<Entry>& due = slot(0, index);
+            if (due.empty()) continue;
+            fired_.swap(due);
+            occupied_[0] &= ~(uint64_t(1) << index);
+            count_ -= fired_.size();
+            for (Entry& entry : fired_) {
+                onExpire(entry.key, entry.deadline);
+            }
+            expired += fired_.size();
+            fired_.clear();
+        }
+        return expired;
+    }
+
+    // 推进到当前时刻
+    template <typename OnExpire>
+    size_t advance(OnExpire&& onExpire) {
+        return advance(now(), std::forward<OnExpire>(onExpire));
+    }
+
+private:
+    static constexpr size_t kSlotBits = 6;
+    static constexpr size_t kSlots = size_t(1) << kSlotBits; // 每层 64 个槽
+    static constexpr size_t kLevels = 4;                     // 覆盖 2^24 个 tick，1ms 的 tick 约 4.6 小时
+
+    struct Entry {
+        Key key;
+        uint64_t deadline;
+    };
+
+    static size_t slotIndex(uint64_t tick, size_t level) {
+        return static_cast<size_t>((tick >> (kSlotBits * level)) & (kSlots - 1));
+    }
+
+    std::vector<Entry>& slot(size_t level, size_t index) {
+        return slots_[level * kSlots + index];
+    }
+
+    // 位图中从 index 开始（含）往后第一个非空槽相差几格，绕回开头；全空时返回 kSlots
+    static uint64_t nextOccupied(uint64_t bits, size_t index) {
+        if (bits == 0) return kSlots;
+        uint64_t rotated = index == 0 ? bits : (bits >> index) | (bits << (kSlots - index));
+        return lowestBit(rotated);
+    }
+
+    // currentTick_ 之后第一个需要处理的 tick：第 0 层的非空槽到期，或者某层的非空槽被 cascade。
+    // 第 0 层的记录都在 (currentTick_, currentTick_ + kSlots) 之内，槽号和 tick 一一对应；
+    // 第 level 层的槽只在 kSlots^level 的整数倍处 cascade
+    uint64_t nextEventTick() const {
+        uint64_t next = UINT64_MAX;
+        uint64_t offset = nextOccupied(occupied_[0], slotIndex(currentTick_ + 1, 0));
+        if (offset < kSlots) next = currentTick_ + 1 + offset;
+        for (size_t level = 1; level < kLevels; ++level) {
+            uint64_t width = uint64_t(1) << (kSlotBits * level);
+            uint64_t boundary = (currentTick_ / width + 1) * width;
+            offset = nextOccupied(occupied_[level], slotIndex(boundary, level));
+            if (offset < kSlots) next = std::min(next, boundary + offset * width);
+        }
+        return next;
+    }
+
+    // 根据离现在的距离选层；超出最高层范围的记录先放在最高层最远的位置，cascade 时再重新计算
+    void place(Entry entry, uint64_t earliest) {
+        uint64_t deadline = std::max(entry.deadline, earliest);
+        uint64_t delta = deadline - currentTick_;
+        size_t level = 0;
+        while (level + 1 < kLevels && delta >= (uint64_t(1) << (kSlotBits * (level + 1)))) {
+            ++level;
+        }
+        uint64_t span = uint64_t(1) << (kSlotBits * kLevels);
+        if (delta >= span) {
+            deadline = currentTick_ + span - 1;
+        }
+        size_t index = slotIndex(deadline, level);
+        slot(level, index).push_back(std::move(entry));
+        occupied_[level] |= uint64_t(1) << index;
+    }
+
+    void cascade(size_t level, size_t index) {
+        std::vector<Entry> entries;
+        entries.swap(slot(level, index));
+        occupied_[level] &= ~(uint64_t(1) << index);
+        // cascade 发生在处理第 0 层当前槽之前，到期时间正好是当前 tick 的记录还能赶上
+        for (Entry& entry : entries) {
+            place(std::move(entry), currentTick_);
+        }
+    }
+
+private:
+    std::chrono::nanoseconds tick_;
+    Clock::time_point start_;
+    uint64_t currentTick_;             // 时间轮已经推进到的 tick
+    size_t count_;
+    std::vector<std::vector<Entry>> slots_;
+    std::vector<Entry> fired_;         // 复用的到期批次，避免每个 tick 分配
+    uint64_t occupied_[kLevels];       // 每层一个位图：第 i 位表示第 i 个槽非空
+};
+
+} // namespace KamaCache
@@ -0,0 +1,318 @@
+#pragma once
+
+/*
+WTinyLfuCache：W-TinyLFU 缓存（Einziger, Friedman & Manes）。
+
+- 窗口（window）：容量约 1% 的小 LRU，新数据先进入这里，照顾突发的最近访问；
+- 主缓存：分段 LRU（SLRU），分为试用段（probation，约 20%）和保护段（protected，约 80%）。
+  试用段中的数据再次被访问后升入保护段，保护段满时把最久未使用的数据降回试用段；
+- 准入过滤：从窗口淘汰出来的候选者要和试用段最久未使用的受害者比较访问频率，
+  频率更高才能进入主缓存，否则直接丢弃。一次性扫描的数据频率低，进不了主缓存。
+
+访问频率由 CountMinSketch 估计：每个计数器只有 4 位，每个 key 只占几个计数器，
+不需要为历史 key 保存节点。累计记录次数达到采样上限时所有计数器减半，让旧的热度逐渐衰减。
+
+节点和链表复用 LruCache 中的 LruNode 和 LruList：链表头部是最久未使用的节点，尾部是最近访问的节点。
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "KICachePolicy.h"
+#include "LruCache.h"
+
+namespace KamaCache
+{
+inline namespace KAMACACHE_STATS_ABI {
+
+// 4 位计数器的 count-min sketch：每个 64 位字存 16 个计数器，每个 key 在 4 行里各占一个计数器
+class CountMinSketch
+{
+public:
+    explicit CountMinSketch(size_t capacity)
+    : size_(0)
+    {
+        size_t width = 1;
+        while (width < std::max<size_t>(capacity, 16)) width <<= 1;
+        table_.assign(width, 0);
+        tableMask_ = width - 1;
+        sampleSize_ = std::max<size_t>(capacity, 1) * 10;
+    }
+
+    // 估计的访问频率，取 4 个计数器中的最小值
+    uint32_t frequency(uint64_t hash) const {
+        uint32_t freq = 15;
+        for (int i = 0; i < kDepth; ++i) {
+            uint64_t h = rehash(hash, i);
+            uint64_t word = table_[h & tableMask_];
+            freq = std::min<uint32_t>(freq, static_cast<uint32_t>((word >> counterShift(h)) & 0xF));
+        }
+        return freq;
+    }
+
+    // 记录一次访问：计数器饱和在 15；累计次数达到采样上限时整体减半
+    void increment(uint64_t hash) {
+        bool added = false;
+        for (int i = 0; i < kDepth; ++i) {
+            uint64_t h = rehash(hash, i);
+            uint64_t& word = table_[h & tableMask_];
+            unsigned shift = counterShift(h);
+            if (((word >> shift) & 0xF) != 0xF) {
+                word += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+        if (added && ++size_ >= sampleSize_) {
+            reset();
+        }
+    }
+
+    // 所有计数器减半（老化）
+    void reset() {
+        for (auto& word : table_) {
+            word = (word >> 1) & 0x7777777777777777ULL;
+        }
+        size_ /= 2;
+    }
+
+    size_t memoryBytes() const { return table_.size() * sizeof(uint64_t); }
+
+private:
+    static constexpr int kDepth = 4;
+
+    static uint64_t rehash(uint64_t hash, int i) {
+        static constexpr uint64_t kSeeds[kDepth] = {
+            0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+            0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+        uint64_t h = (hash + kSeeds[i]) * kSeeds[i];
+        return h ^ (h >> 32);
+    }
+
+    // 高位选出字内 16 个计数器中的一个
+    static unsigned counterShift(uint64_t h) {
+        return static_cast<unsigned>((h >> 60) & 0xF) << 2;
+    }
+
+private:
+    std::vector<uint64_t> table_;
+    size_t tableMask_;
+    size_t sampleSize_;  // 累计记录次数达到这个值时老化
+    size_t size_;
+};
+
+
+template <typename Key, typename Value>
+class WTinyLfuCache : public KICachePolicy<Key, Value>
+{
+public:
+    using NodePtr = std::shared_ptr<LruNode<Key, Value>>;
+
+    // 节点当前所在的链表
+    enum class Where { Window, Probation, Protected };
+
+    struct Entry {
+        NodePtr node;
+        Where where;
+    };
+
+    WTinyLfuCache(int capacity)
+    : capacity_(capacity > 0 ? capacity : 0),
+      sketch_(capacity_)
+    {
+        windowCapacity_ = capacity_ > 0 ? std::max<size_t>(capacity_ / 100, 1) : 0;
+        mainCapacity_ = capacity_ - windowCapacity_;
+        protectedCapacity_ = mainCapacity_ * 8 / 10;
+    }
+
+    ~WTinyLfuCache() override = default;
+
+    void put(Key key, Value value) override {
+        if (capacity_ == 0) return;
+
+        ScopedLatency timer(stats_, CacheStats::PutLatency);
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        sketch_.increment(KeyHash<Key>{}(key));
+        auto it = nodeMap_.find(key);
+        if (it != nodeMap_.end()) {
+            stats_.recordUpdate();
+            notifier_.record(it->second.node->getKey(), it->second.node->getValue(), RemovalCause::Replaced);
+            it->second.node->setValue(std::move(value));
+            onHit(it->second);
+            return;
+        }
+
+        stats_.recordInsert();
+        NodePtr node = std::make_shared<LruNode<Key, Value>>(key, std::move(value));
+        window_.pushBack(node);
+        nodeMap_.emplace(std::move(key), Entry{std::move(node), Where::Window});
+        evictFromWindow();
+    }
+
+    template <typename... Args>
+    void emplace(Key key, Args&&... args) {
+        put(std::move(key), Value(std::forward<Args>(args)...));
+    }
+
+    bool get(const Key& key, Value& value) override {
+        return visit<Key>(key, [&value](const Value& v) { value = v; });
+    }
+
+    // 异构查找：例如 Key 为 std::string 时传 std::string_view
+    template <typename K>
+    bool get(const K& key, Value& value) {
+        return visit(key, [&value](const Value& v) { value = v; });
+    }
+
+    Value get(const Key& key) override {
+        Value value{};
+        get(key, value);
+        return value;
+    }
+
+    bool visit(const Key& key, const std::function<void(const Value&)>& visitor) override {
+        return visit<Key>(key, visitor);
+    }
+
+    // 零拷贝读取：未命中也要记入 sketch，这样之后 put 进来的数据才有频率可比
+    template <typename K, typename Visitor>
+    bool visit(const K& key, Visitor&& visitor) {
+        ScopedLatency timer(stats_, CacheStats::GetLatency);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        sketch_.increment(KeyHash<Key>{}(key));
+        auto it = findKey(nodeMap_, key);
+        if (it == nodeMap_.end()) {
+            stats_.recordMiss();
+            return false;
+        }
+        onHit(it->second);
+        visitor(it->second.node->getValue());
+        stats_.recordHit();
+        return true;
+    }
+
+    void remove(const Key& key) {
+        NotifyScope<Key, Value> notify(notifier_);
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        auto it = nodeMap_.find(key);
+        if (it == nodeMap_.end()) return;
+        notifier_.record(it->second.node->getKey(), it->second.node->getValue(), RemovalCause::Explicit);
+        listOf(it->second.where).remove(it->second.node);
+        nodeMap_.erase(it);
+        stats_.recordRemoval();
+    }
+
+    size_t size() {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return nodeMap_.size();
+    }
+
+    CacheStatsSnapshot stats() const override {
+        return stats_.snapshot();
+    }
+
+    // 准入失败被丢弃的候选者也算作淘汰
+    void setRemovalListener(RemovalListener<Key, Value> listener,
+                            ListenerDelivery delivery = ListenerDelivery::Caller) override {
+        notifier_.setListener(std::move(listener), delivery);
+    }
+
+    // 估计的访问频率，主要用于观察准入过程
+    uint32_t frequency(const Key& key) {
+        TimedLockGuard<std::mutex> lock(mutex_, stats_);
+        return sketch_.frequency(KeyHash<Key>{}(key));
+    }
+
+private:
+    LruList<Key, Value>& listOf(Where where) {
+        switch (where) {
+        case Where::Window:    return window_;
+        case Where::Probation: return probation_;
+        default:               return protected_;
+        }
+    }
+
+    // 命中：窗口和保护段内移到尾部；试用段的数据升入保护段
+    void onHit(Entry& entry) {
+        switch (entry.where) {
+        case Where::Window:
+            window_.moveToBack(entry.node);
+            break;
+        case Where::Protected:
+            protected_.moveToBack(entry.node);
+            break;
+        case Where::Probation:
+            probation_.remove(entry.node);
+            entry.where = Where::Protected;
+            protected_.pushBack(entry.node);
+            // 保护段超出容量，把最久未使用的降回试用段
+            if (protected_.size() > protectedCapacity_) {
+                NodePtr demoted = protected_.popFront();
+                probation_.pushBack(demoted);
+                nodeMap_.find(demoted->getKey())->second.where = Where::Probation;
+            }
+            break;
+        }
+    }
+
+    // 窗口超出容量：候选者进入主缓存；主缓存已满时和受害者比较频率，输的一方被淘汰
+    void evictFromWindow() {
+        if (window_.size() <= windowCapacity_) return;
+
+        NodePtr candidate = window_.popFront();
+        if (probation_.size() + protected_.size() < mainCapacity_) {
+            admit(candidate);
+            return;
+        }
+
+        // 受害者优先取试用段，试用段为空时取保护段
+        LruList<Key, Value>& victims = probation_.size() > 0 ? probation_ : protected_;
+        NodePtr victim = victims.front();
+        stats_.recordEviction(); // 候选者和受害者总有一个被淘汰
+        if (!victim) {
+            notifier_.record(candidate->getKey(), candidate->getValue(), RemovalCause::Evicted);
+            nodeMap_.erase(candidate->getKey());
+            return;
+        }
+
+        uint32_t candidateFreq = sketch_.frequency(KeyHash<Key>{}(candidate->getKey()));
+        uint32_t victimFreq = sketch_.frequency(KeyHash<Key>{}(victim->getKey()));
+        if (candidateFreq > victimFreq) {
+            victims.remove(victim);
+            notifier_.record(victim->getKey(), victim->getValue(), RemovalCause::Evicted);
+            nodeMap_.erase(victim->getKey());
+            admit(candidate);
+        } else {
+            notifier_.record(candidate->getKey(), candidate->getValue(), RemovalCause::Evicted);
+            nodeMap_.erase(candidate->getKey());
+        }
+    }
+
+    void admit(const NodePtr& node) {
+        probation_.pushBack(node);
+        nodeMap_.find(node->getKey())->second.where = Where::Probation;
+    }
+
+private:
+    size_t capacity_;
+    size_t windowCapacity_;    // 窗口容量，约为总容量的 1%
+    size_t mainCapacity_;      // 主缓存（试用段 + 保护段）容量
+    size_t protectedCapacity_; // 保护段容量，约为主缓存的 80%
+    std::mutex mutex_;
+    CountMinSketch sketch_;
+    LruList<Key, Value> window_;
+    LruList<Key, Value> probation_;
+    LruList<Key, Value> protected_;
+    std::unordered_map<Key, Entry, KeyHash<Key>, KeyEqual> nodeMap_;
+    CacheStats stats_;
+    RemovalNotifier<Key, Value> notifier_;
+};
+
+} // inline namespace KAMACACHE_STATS_ABI
+
+} // namespace KamaCache
@@ -0,0 +1,159 @@
+/*
+adaptive_bench：AdaptiveCache 的命中率和采样开销。
+
+三种负载（get 未命中则 put，单线程）：
+- freq：0.8 * capacity 个长期热点和一次性扫描的 key 交替出现（频率主导，LRU 吃亏）；
+- recency：0.8 * capacity 个热点，每 5 * capacity 次访问整体换一批（最近性主导，LFU 吃亏）；
+- mixed：前两种负载每 phase 次访问交替一次。
+每种负载依次运行：sampleRate = 0 的 AdaptiveCache 分别固定为 LRU / LRU-2 / LFU，以及不同采样率的自适应版本。
+
+输出每次操作的纳秒数、命中率、最终策略和切换次数。shadow% 是影子缓存耗时占总运行时间的比例，即采样开销，
+目标是低于 5%。
+
+用法：adaptive_bench [操作数] [容量] [phase]，默认 4000000 50000 1000000
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "AdaptiveCache.h"
+
+namespace
+{
+
+using Key = uint64_t;
+using Value = uint64_t;
+using Clock = std::chrono::steady_clock;
+using KamaCache::AdaptiveCache;
+using KamaCache::AdaptiveOptions;
+using KamaCache::AdaptivePolicy;
+
+// 打散 key，避免相邻的 key 在哈希上也相邻
+Key scramble(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+void appendFrequency(std::vector<Key>& keys, size_t ops, size_t capacity, std::mt19937_64& rng, uint64_t& scan) {
+    std::uniform_int_distribution<uint64_t> hot(0, capacity * 8 / 10 - 1);
+    for (size_t i = 0; i < ops; ++i) {
+        keys.push_back(scramble(i % 2 == 0 ? hot(rng) : scan++));
+    }
+}
+
+void appendRecency(std::vector<Key>& keys, size_t ops, size_t capacity, std::mt19937_64& rng, uint64_t& base) {
+    size_t hotNum = capacity * 8 / 10;
+    std::uniform_int_distribution<uint64_t> hot(0, hotNum - 1);
+    for (size_t i = 0; i < ops; ++i) {
+        if (i % (capacity * 5) == 0) base += hotNum;
+        keys.push_back(scramble(base + hot(rng)));
+    }
+}
+
+std::vector<Key> makeKeys(const std::string& workload, size_t ops, size_t capacity, size_t phase) {
+    std::mt19937_64 rng(12345);
+    uint64_t scan = uint64_t(1) << 40;   // 扫描 key 和热点 key 不重叠
+    uint64_t base = 0;
+    std::vector<Key> keys;
+    keys.reserve(ops);
+    if (workload == "freq") {
+        appendFrequency(keys, ops, capacity, rng, scan);
+    } else if (workload == "recency") {
+        appendRecency(keys, ops, capacity, rng, base);
+    } else {
+        for (size_t done = 0; done < ops; done += phase) {
+            size_t n = std::min(phase, ops - done);
+            if ((done / phase) % 2 == 0) {
+                appendFrequency(keys, n, capacity, rng, scan);
+            } else {
+                appendRecency(keys, n, capacity, rng, base);
+            }
+        }
+    }
+    return keys;
+}
+
+struct Result {
+    double nsPerOp;
+    double hitRate;
+    KamaCache::AdaptiveStats stats;
+    double totalNs;
+};
+
+Result run(const std::vector<Key>& keys, size_t capacity, const AdaptiveOptions& options) {
+    AdaptiveCache<Key, Value> cache(static_cast<int>(capacity), options);
+    size_t hits = 0;
+    auto start = Clock::now();
+    for (Key key : keys) {
+        Value value;
+        if (cache.get(key, value)) {
+            ++hits;
+        } else {
+            cache.put(key, key);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return {ns / static_cast<double>(keys.size()), static_cast<double>(hits) / static_cast<double>(keys.size()),
+            cache.adaptiveStats(), ns};
+}
+
+// 3 遍取最快的一遍
+Result best(const std::vector<Key>& keys, size_t capacity, const AdaptiveOptions& options) {
+    Result result = run(keys, capacity, options);
+    for (int round = 1; round < 3; ++round) {
+        Result next = run(keys, capacity, options);
+        if (next.nsPerOp < result.nsPerOp) result = next;
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    size_t capacity = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 50000;
+    size_t phase = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1000000;
+    if (capacity < 10 || phase == 0) {
+        std::fprintf(stderr, "capacity must be >= 10 and phase > 0\n");
+        return 1;
+    }
+    std::printf("ops=%zu capacity=%zu phase=%zu\n", ops, capacity, phase);
+
+    for (const char* workload : {"freq", "recency", "mixed"}) {
+        std::vector<Key> keys = makeKeys(workload, ops, capacity, phase);
+        std::printf("\n[%s]\n%-18s %8s %8s %8s %8s %9s\n", workload,
+                    "cache", "ns/op", "hit", "policy", "switches", "shadow%");
+
+        for (AdaptivePolicy policy : {AdaptivePolicy::Lru, AdaptivePolicy::LruK, AdaptivePolicy::Lfu}) {
+            AdaptiveOptions options;
+            options.sampleRate = 0;
+            options.initial = policy;
+            Result r = best(keys, capacity, options);
+            std::string name = std::string("fixed ") + KamaCache::adaptivePolicyName(policy);
+            std::printf("%-18s %8.1f %7.2f%% %8s %8s %9s\n", name.c_str(), r.nsPerOp, r.hitRate * 100,
+                        KamaCache::adaptivePolicyName(policy), "-", "-");
+        }
+
+        for (double rate : {0.005, 0.01}) {
+            AdaptiveOptions options;
+            options.sampleRate = rate;
+            Result r = best(keys, capacity, options);
+            char name[32];
+            std::snprintf(name, sizeof(name), "adaptive %.1f%%", rate * 100);
+            std::printf("%-18s %8.1f %7.2f%% %8s %8llu %8.2f%%\n", name, r.nsPerOp, r.hitRate * 100,
+                        KamaCache::adaptivePolicyName(r.stats.active),
+                        static_cast<unsigned long long>(r.stats.switches),
+                        100.0 * static_cast<double>(r.stats.shadowNanos) / r.totalNs);
+        }
+    }
+    return 0;
+}
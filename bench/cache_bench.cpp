@@ -0,0 +1,410 @@
+/*
+cache_bench：缓存策略对比基准测试。
+
+所有策略都通过 KICachePolicy 接口跑同一套负载（get 未命中则 put），
+对每个 (策略, 容量, 线程数, 批大小) 组合输出：吞吐量 ops/sec、p50/p99 延迟、命中率和缓存占用的 RSS。
+每个组合在 fork 出的子进程中运行，互不影响。RSS 是运行结束时相对于基线的增量：基线在访问序列、
+延迟采样缓冲区都准备好之后、创建缓存之前取，测试框架自己的内存不计入。
+
+用法示例：
+  ./cache_bench --policies=lru,lruk,lfu --workload=zipf --skew=0.99 \
+                --keys=1000000 --ops=2000000 --capacities=10000,100000 --threads=1,4
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "ArcCache.h"
+#include "BufferedLruCache.h"
+#include "HashLruCache.h"
+#include "KICachePolicy.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+#include "LruKCache.h"
+#include "S3FifoCache.h"
+#include "SetAssocCache.h"
+#include "SlabLruCache.h"
+#include "WTinyLfuCache.h"
+
+using namespace KamaCache;
+
+using Key = uint64_t;
+using Value = uint64_t;
+using Cache = KICachePolicy<Key, Value>;
+
+namespace {
+
+struct Options {
+    std::vector<std::string> policies{"lru", "lruk", "lfu"};
+    std::string workload = "zipf";   // zipf | uniform | scan | polluted | shifting
+    double skew = 0.99;               // zipf 的偏斜参数
+    uint64_t keys = 1000000;          // key 空间大小
+    uint64_t ops = 2000000;           // 每个组合的总操作数（所有线程合计）
+    std::vector<size_t> capacities{10000, 100000};
+    std::vector<int> threads{1, 2, 4};
+    int k = 2;                        // LRU-K 的 k
+    double historyRatio = 2.0;        // LRU-K 历史容量 = 容量 * historyRatio
+    double scanRatio = 0.3;           // polluted 负载中顺序扫描访问所占的比例
+    uint64_t hotSetSize = 10000;      // shifting 负载的热点集合大小
+    uint64_t shiftEvery = 200000;     // shifting 负载每隔多少次访问平移热点
+    int sampleEvery = 8;              // 每隔多少次操作（或批次）记录一次延迟
+    std::vector<size_t> batches{1};   // 批大小；大于 1 时使用 getMany/putMany
+    uint64_t seed = 42;
+};
+
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+        if (end > start) out.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+void usage(const char* prog) {
+    std::printf(
+        "usage: %s [options]\n"
+        "  --policies=lru,lruk,lfu     also: hash,slab,buffered,arc,tinylfu,setassoc,s3fifo\n"
+        "  --workload=zipf             zipf | uniform | scan | polluted | shifting\n"
+        "  --skew=0.99                 zipf skew\n"
+        "  --keys=N                    key space size\n"
+        "  --ops=N                     operations per run (all threads)\n"
+        "  --capacities=A,B,...        cache capacities to sweep\n"
+        "  --threads=A,B,...           thread counts to sweep\n"
+        "  --k=N --history-ratio=X     LRU-K parameters\n"
+        "  --scan-ratio=X              fraction of scan accesses in polluted\n"
+        "  --hot-set=N --shift-every=N shifting hot set parameters\n"
+        "  --sample-every=N            latency sampling interval\n"
+        "  --batch=A,B,...             batch sizes; >1 uses getMany/putMany\n"
+        "  --seed=N\n", prog);
+}
+
+bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string val = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (name == "--help" || name == "-h") { usage(argv[0]); std::exit(0); }
+        else if (name == "--policies") opt.policies = splitList(val);
+        else if (name == "--workload") opt.workload = val;
+        else if (name == "--skew") opt.skew = std::stod(val);
+        else if (name == "--keys") opt.keys = std::stoull(val);
+        else if (name == "--ops") opt.ops = std::stoull(val);
+        else if (name == "--capacities") {
+            opt.capacities.clear();
+            for (auto& s : splitList(val)) opt.capacities.push_back(std::stoull(s));
+        }
+        else if (name == "--threads") {
+            opt.threads.clear();
+            for (auto& s : splitList(val)) opt.threads.push_back(std::stoi(s));
+        }
+        else if (name == "--k") opt.k = std::stoi(val);
+        else if (name == "--history-ratio") opt.historyRatio = std::stod(val);
+        else if (name == "--scan-ratio") opt.scanRatio = std::stod(val);
+        else if (name == "--hot-set") opt.hotSetSize = std::stoull(val);
+        else if (name == "--shift-every") opt.shiftEvery = std::stoull(val);
+        else if (name == "--sample-every") opt.sampleEvery = std::max(1, std::stoi(val));
+        else if (name == "--seed") opt.seed = std::stoull(val);
+        else if (name == "--batch") {
+            opt.batches.clear();
+            for (auto& s : splitList(val)) opt.batches.push_back(std::max<size_t>(1, std::stoull(s)));
+        }
+        else {
+            std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------- 负载生成 ----------------
+
+// Zipf 分布：预先计算累积分布，采样时二分查找
+class ZipfGenerator {
+public:
+    ZipfGenerator(uint64_t n, double skew) : cdf_(n) {
+        double sum = 0;
+        for (uint64_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), skew);
+            cdf_[i] = sum;
+        }
+        for (auto& c : cdf_) c /= sum;
+    }
+
+    template <typename Rng>
+    uint64_t operator()(Rng& rng) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+// 打散 key，避免 rank 相邻的热点 key 在哈希上也相邻
+inline Key scramble(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// 为每个线程生成一段访问序列，计时前生成，不计入测量
+std::vector<std::vector<Key>> makeTraces(const Options& opt, int threads) {
+    std::vector<std::vector<Key>> traces(threads);
+    uint64_t perThread = opt.ops / threads;
+    std::unique_ptr<ZipfGenerator> zipf;
+    if (opt.workload == "zipf" || opt.workload == "polluted") zipf = std::make_unique<ZipfGenerator>(opt.keys, opt.skew);
+
+    for (int t = 0; t < threads; ++t) {
+        std::mt19937_64 rng(opt.seed + t);
+        std::uniform_int_distribution<uint64_t> uniform(0, opt.keys - 1);
+        auto& trace = traces[t];
+        trace.reserve(perThread);
+        for (uint64_t i = 0; i < perThread; ++i) {
+            // 全局序号，多线程时各线程在时间上交错推进
+            uint64_t global = i * threads + t;
+            uint64_t rank;
+            if (opt.workload == "zipf") {
+                rank = (*zipf)(rng);
+            } else if (opt.workload == "uniform") {
+                rank = uniform(rng);
+            } else if (opt.workload == "scan") {
+                rank = global % opt.keys;
+            } else if (opt.workload == "polluted") {
+                // zipf 热点访问中混入顺序扫描，扫描的 key 在 zipf 的 key 空间之外，只会被访问一次
+                if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < opt.scanRatio) {
+                    rank = opt.keys + global;
+                } else {
+                    rank = (*zipf)(rng);
+                }
+            } else if (opt.workload == "shifting") {
+                // 热点集合每 shiftEvery 次访问平移半个集合大小
+                uint64_t base = (global / opt.shiftEvery) * (opt.hotSetSize / 2);
+                uint64_t offset = std::uniform_int_distribution<uint64_t>(0, opt.hotSetSize - 1)(rng);
+                rank = (base + offset) % opt.keys;
+            } else {
+                std::fprintf(stderr, "unknown workload: %s\n", opt.workload.c_str());
+                std::exit(1);
+            }
+            trace.push_back(scramble(rank));
+        }
+    }
+    return traces;
+}
+
+// ---------------- 策略工厂 ----------------
+
+std::unique_ptr<Cache> makeCache(const std::string& policy, size_t capacity, const Options& opt) {
+    int cap = static_cast<int>(capacity);
+    if (policy == "lru") return std::make_unique<LruCache<Key, Value>>(cap);
+    if (policy == "lruk") {
+        int history = static_cast<int>(capacity * opt.historyRatio);
+        return std::make_unique<LruKCache<Key, Value>>(cap, history, opt.k);
+    }
+    if (policy == "lfu") return std::make_unique<LfuCache<Key, Value>>(cap);
+    if (policy == "hash") return std::make_unique<HashLruCache<Key, Value>>(capacity);
+    if (policy == "slab") return std::make_unique<SlabLruCache<Key, Value>>(cap);
+    if (policy == "buffered") return std::make_unique<BufferedLruCache<Key, Value>>(cap);
+    if (policy == "arc") return std::make_unique<ArcCache<Key, Value>>(cap);
+    if (policy == "tinylfu") return std::make_unique<WTinyLfuCache<Key, Value>>(cap);
+    if (policy == "s3fifo") return std::make_unique<S3FifoCache<Key, Value>>(cap);
+    if (policy == "setassoc") return std::make_unique<SetAssocCache<Key, Value>>(cap);
+    return nullptr;
+}
+
+// ---------------- 运行与统计 ----------------
+
+struct ThreadResult {
+    uint64_t hits = 0;
+    uint64_t ops = 0;
+    std::vector<uint32_t> latencies; // 采样的单次操作延迟（ns），批量模式下为批内平均到每个 key 的延迟
+};
+
+uint32_t percentile(std::vector<uint32_t>& samples, double p) {
+    if (samples.empty()) return 0;
+    size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+// 当前常驻内存（KB）。不用 ru_maxrss：它是历史峰值，生成访问序列时的临时内存（Zipf 累积分布）会一直留在里面
+long currentRssKb() {
+    long pages = 0;
+    long resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    std::fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 单个 key 的 get，未命中则 put
+void runSingle(Cache& cache, const std::vector<Key>& trace, int sampleEvery, ThreadResult& r) {
+    Value value;
+    for (size_t i = 0; i < trace.size(); ++i) {
+        Key key = trace[i];
+        bool sample = (i % sampleEvery) == 0;
+        auto t0 = sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        if (cache.get(key, value)) {
+            ++r.hits;
+        } else {
+            cache.put(key, key);
+        }
+        if (sample) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+            r.latencies.push_back(static_cast<uint32_t>(std::min<int64_t>(ns, UINT32_MAX)));
+        }
+    }
+}
+
+// 按批 getMany，未命中的 key 再一次 putMany
+void runBatched(Cache& cache, const std::vector<Key>& trace, size_t batch, int sampleEvery, ThreadResult& r) {
+    std::vector<Value> values(batch);
+    std::unique_ptr<bool[]> hits(new bool[batch]);
+    std::vector<Key> missKeys;
+    missKeys.reserve(batch);
+
+    size_t batchIndex = 0;
+    for (size_t begin = 0; begin < trace.size(); begin += batch, ++batchIndex) {
+        size_t n = std::min(batch, trace.size() - begin);
+        const Key* keys = trace.data() + begin;
+        bool sample = (batchIndex % sampleEvery) == 0;
+        auto t0 = sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+        r.hits += cache.getMany(keys, n, values.data(), hits.get());
+        missKeys.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (!hits[i]) missKeys.push_back(keys[i]);
+        }
+        if (!missKeys.empty()) {
+            // value 与 key 相同
+            cache.putMany(missKeys.data(), missKeys.data(), missKeys.size());
+        }
+
+        if (sample) {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count() / static_cast<int64_t>(n);
+            r.latencies.push_back(static_cast<uint32_t>(std::min<int64_t>(ns, UINT32_MAX)));
+        }
+    }
+}
+
+void runOne(const Options& opt, const std::string& policy, size_t capacity, int threads, size_t batch) {
+    auto traces = makeTraces(opt, threads);
+
+    // 延迟采样缓冲区先写一遍，让它的页在取基线之前就常驻
+    std::vector<ThreadResult> results(threads);
+    for (int t = 0; t < threads; ++t) {
+        results[t].latencies.resize(traces[t].size() / opt.sampleEvery + 1);
+        results[t].latencies.clear();
+    }
+    long baselineKb = currentRssKb();
+
+    auto cache = makeCache(policy, capacity, opt);
+    if (!cache) {
+        std::fprintf(stderr, "unknown policy: %s\n", policy.c_str());
+        return;
+    }
+
+    // 预热：单线程用第一段访问序列的前一半填充缓存
+    {
+        Value value;
+        const auto& warm = traces[0];
+        for (size_t i = 0; i < warm.size() / 2; ++i) {
+            if (!cache->get(warm[i], value)) cache->put(warm[i], warm[i]);
+        }
+    }
+
+    std::atomic<bool> start{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            ThreadResult& r = results[t];
+            const auto& trace = traces[t];
+            while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            if (batch > 1) {
+                runBatched(*cache, trace, batch, opt.sampleEvery, r);
+            } else {
+                runSingle(*cache, trace, opt.sampleEvery, r);
+            }
+            r.ops = trace.size();
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    long cacheKb = currentRssKb() - baselineKb;
+
+    uint64_t hits = 0, ops = 0;
+    std::vector<uint32_t> latencies;
+    for (auto& r : results) {
+        hits += r.hits;
+        ops += r.ops;
+        latencies.insert(latencies.end(), r.latencies.begin(), r.latencies.end());
+    }
+
+    std::printf("%-9s %-9s %10zu %7d %6zu %14.0f %9u %9u %9.4f %12ld\n",
+                policy.c_str(), opt.workload.c_str(), capacity, threads, batch,
+                ops / seconds, percentile(latencies, 0.50), percentile(latencies, 0.99),
+                ops ? static_cast<double>(hits) / ops : 0.0, cacheKb);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) return 1;
+
+    std::printf("%-9s %-9s %10s %7s %6s %14s %9s %9s %9s %12s\n",
+                "policy", "workload", "capacity", "threads", "batch", "ops/sec",
+                "p50(ns)", "p99(ns)", "hit_ratio", "cache_rss_kb");
+    std::fflush(stdout);
+
+    for (const auto& policy : opt.policies) {
+        for (size_t capacity : opt.capacities) {
+            for (int threads : opt.threads) {
+                for (size_t batch : opt.batches) {
+                    // 每个组合在独立的子进程中运行，上一个组合释放的内存不会影响这次的 RSS
+                    pid_t pid = fork();
+                    if (pid == 0) {
+                        runOne(opt, policy, capacity, threads, batch);
+                        std::fflush(stdout);
+                        std::_Exit(0);
+                    }
+                    if (pid < 0) {
+                        std::perror("fork");
+                        return 1;
+                    }
+                    int status = 0;
+                    waitpid(pid, &status, 0);
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+// 缓存索引的基准测试：FlatHashMap 与 std::unordered_map 对比
+// 测量每个条目的内存、命中/未命中查找耗时、淘汰式的删除+插入耗时，以及扩容时单次插入的最长停顿。
+// 值类型和缓存中一样是 std::shared_ptr 节点句柄。
+// 每组测量在单独 fork 出的子进程中进行，前一组留下的堆状态不影响后一组的扩容停顿。
+//
+// 用法：index_bench [条目数 ...]，默认 1000 10000 100000 1000000 4000000
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "FlatHashMap.h"
+
+// 统计当前已分配的字节数，用来计算每个条目的内存
+static std::atomic<size_t> gAllocated{0};
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size + 16);
+    if (!p) throw std::bad_alloc();
+    *static_cast<size_t*>(p) = size;
+    gAllocated.fetch_add(size, std::memory_order_relaxed);
+    return static_cast<char*>(p) + 16;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    char* base = static_cast<char*>(p) - 16;
+    gAllocated.fetch_sub(*reinterpret_cast<size_t*>(base), std::memory_order_relaxed);
+    std::free(base);
+}
+
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+// FlatHashMap 的槽位数组按对齐方式分配
+void* operator new(size_t size, std::align_val_t) { return operator new(size); }
+void operator delete(void* p, std::align_val_t) noexcept { operator delete(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { operator delete(p); }
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using Handle = std::shared_ptr<int>;
+using StdMap = std::unordered_map<uint64_t, Handle, KamaCache::KeyHash<uint64_t>, KamaCache::KeyEqual>;
+using FlatMap = KamaCache::FlatHashMap<uint64_t, Handle, KamaCache::KeyHash<uint64_t>, KamaCache::KeyEqual>;
+
+struct Result {
+    double bytesPerEntry;
+    double hitNs;
+    double missNs;
+    double churnNs;
+    double maxInsertUs;
+};
+
+double nsPerOp(Clock::time_point start, size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(ops);
+}
+
+template <typename Map>
+Result run(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& misses, const Handle& handle) {
+    Result result{};
+    size_t n = keys.size();
+    // 查找次数至少 400 万次，小表的数据才稳定
+    size_t rounds = std::max<size_t>(1, 4000000 / n);
+
+    size_t before = gAllocated.load();
+    Map map;
+    // 逐个插入，记录最慢的一次（通常是触发扩容的那一次）
+    double maxInsert = 0;
+    for (uint64_t key : keys) {
+        auto start = Clock::now();
+        map.emplace(key, handle);
+        maxInsert = std::max(maxInsert, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    result.maxInsertUs = maxInsert;
+    result.bytesPerEntry = static_cast<double>(gAllocated.load() - before) / static_cast<double>(n);
+
+    // 按插入之外的另一个随机顺序查找
+    std::vector<uint64_t> order(keys);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+
+    size_t found = 0;
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (uint64_t key : order) found += map.find(key) != map.end();
+    }
+    result.hitNs = nsPerOp(start, rounds * n);
+
+    start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (uint64_t key : misses) found += map.find(key) != map.end();
+    }
+    result.missNs = nsPerOp(start, rounds * n);
+
+    // 缓存满了以后的稳态：每次写入淘汰一个旧 key，再插入一个新 key
+    size_t churn = std::max<size_t>(n, 2000000);
+    start = Clock::now();
+    for (size_t i = 0; i < churn; ++i) {
+        map.erase(order[i % n]);
+        uint64_t fresh = misses[i % n] + (i / n + 1) * 0x9E3779B97F4A7C15ULL;
+        map.emplace(fresh, handle);
+        map.erase(fresh);
+        map.emplace(order[i % n], handle);
+    }
+    result.churnNs = nsPerOp(start, churn * 2);
+
+    if (found != rounds * n) std::printf("unexpected lookup result\n");
+    return result;
+}
+
+// 在子进程中执行 run，通过管道取回结果
+template <typename Map>
+Result measure(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& misses, const Handle& handle) {
+    Result result{};
+    int fds[2];
+    if (::pipe(fds) != 0) return run<Map>(keys, misses, handle);
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        result = run<Map>(keys, misses, handle);
+        ssize_t written = ::write(fds[1], &result, sizeof(result));
+        ::_exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+    }
+    ::close(fds[1]);
+    if (pid < 0 || ::read(fds[0], &result, sizeof(result)) != static_cast<ssize_t>(sizeof(result))) {
+        std::printf("measurement failed\n");
+    }
+    ::close(fds[0]);
+    if (pid > 0) ::waitpid(pid, nullptr, 0);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    if (sizes.empty()) sizes = {1000, 10000, 100000, 1000000, 4000000};
+
+    Handle handle = std::make_shared<int>(0);
+    std::printf("%-9s %-14s %10s %10s %10s %12s %14s\n",
+                "entries", "index", "bytes/ent", "hit ns", "miss ns", "churn ns", "max insert us");
+    for (size_t n : sizes) {
+        std::mt19937_64 rng(n);
+        std::vector<uint64_t> keys(n);
+        std::vector<uint64_t> misses(n);
+        for (auto& key : keys) key = rng() | 1;  // 命中的 key 都是奇数
+        for (auto& key : misses) key = rng() & ~uint64_t(1);
+
+        Result stdResult = measure<StdMap>(keys, misses, handle);
+        Result flatResult = measure<FlatMap>(keys, misses, handle);
+        const Result* results[] = {&stdResult, &flatResult};
+        const char* names[] = {"unordered_map", "FlatHashMap"};
+        for (int i = 0; i < 2; ++i) {
+            std::printf("%-9zu %-14s %10.1f %10.1f %10.1f %12.1f %14.1f\n", n, names[i],
+                        results[i]->bytesPerEntry, results[i]->hitNs, results[i]->missNs,
+                        results[i]->churnNs, results[i]->maxInsertUs);
+        }
+    }
+    return 0;
+}
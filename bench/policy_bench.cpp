@@ -0,0 +1,128 @@
+/*
+policy_bench：虚函数调用与编译期组合（PolicyCache）的单线程开销对比。
+
+同一条 zipf 访问序列（get 未命中则 put），依次用以下方式执行：
+- LruCache 通过 KICachePolicy 接口调用（现有的实现：虚函数 + 互斥锁 + shared_ptr 节点）；
+- PolicyCache 通过 PolicyCacheAdapter 以 KICachePolicy 接口调用（虚函数，不能内联）；
+- PolicyCache 直接调用（get/put 内联到循环里），分别组合 MutexLock 和 NoLock、LRU 和 CLOCK。
+每种方式跑 3 遍取最快的一遍，输出每次操作的纳秒数和命中率。
+
+用法：policy_bench [key 数] [操作数] [容量]，默认 100000 5000000 10000
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "LruCache.h"
+#include "PolicyCache.h"
+
+namespace
+{
+
+using Key = uint64_t;
+using Value = uint64_t;
+using Clock = std::chrono::steady_clock;
+
+using Interface = KamaCache::KICachePolicy<Key, Value>;
+using MutexLru = KamaCache::PolicyCache<Key, Value, KamaCache::LruEviction, KamaCache::MutexLock>;
+using LocalLru = KamaCache::PolicyCache<Key, Value, KamaCache::LruEviction, KamaCache::NoLock,
+                                        KamaCache::KeyHash<Key>, std::allocator<Value>, KamaCache::NoStats>;
+using LocalClock = KamaCache::PolicyCache<Key, Value, KamaCache::ClockEviction, KamaCache::NoLock,
+                                          KamaCache::KeyHash<Key>, std::allocator<Value>, KamaCache::NoStats>;
+
+// Zipf 分布（skew 0.99）：预先计算累积分布，采样时二分查找
+std::vector<Key> makeKeys(uint64_t keyNum, size_t ops) {
+    std::vector<double> cdf(keyNum);
+    double sum = 0;
+    for (uint64_t i = 0; i < keyNum; ++i) {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), 0.99);
+        cdf[i] = sum;
+    }
+    std::mt19937_64 rng(12345);
+    std::uniform_real_distribution<double> dist(0.0, sum);
+    std::vector<Key> keys(ops);
+    for (auto& key : keys) {
+        uint64_t x = std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+        // 打散 key，避免 rank 相邻的热点 key 在哈希上也相邻
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        key = x;
+    }
+    return keys;
+}
+
+struct Result {
+    double nsPerOp;
+    double hitRate;
+};
+
+template <typename Cache>
+Result replay(Cache& cache, const std::vector<Key>& keys) {
+    size_t hits = 0;
+    auto start = Clock::now();
+    for (Key key : keys) {
+        Value value;
+        if (cache.get(key, value)) {
+            ++hits;
+        } else {
+            cache.put(key, key);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return {ns / static_cast<double>(keys.size()), static_cast<double>(hits) / static_cast<double>(keys.size())};
+}
+
+// 只看到接口类型，编译器无法去虚化
+__attribute__((noinline)) Result replayVirtual(Interface& cache, const std::vector<Key>& keys) {
+    return replay(cache, keys);
+}
+
+// 每遍都新建缓存，3 遍取最快
+template <typename Make, typename Run>
+void measure(const char* name, Make make, Run run) {
+    Result best{1e18, 0};
+    for (int round = 0; round < 3; ++round) {
+        auto cache = make();
+        Result result = run(*cache);
+        if (result.nsPerOp < best.nsPerOp) best = result;
+    }
+    std::printf("%-36s %10.1f %9.2f%%\n", name, best.nsPerOp, best.hitRate * 100);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t keyNum = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5000000;
+    size_t capacity = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10000;
+    std::vector<Key> keys = makeKeys(keyNum, ops);
+
+    std::printf("keys=%llu ops=%zu capacity=%zu\n", static_cast<unsigned long long>(keyNum), ops, capacity);
+    std::printf("%-36s %10s %10s\n", "cache", "ns/op", "hit");
+
+    auto virtualRun = [&keys](Interface& cache) { return replayVirtual(cache, keys); };
+    auto directRun = [&keys](auto& cache) { return replay(cache, keys); };
+    int cap = static_cast<int>(capacity);
+
+    measure("LruCache (virtual)",
+            [cap]() { return std::make_unique<KamaCache::LruCache<Key, Value>>(cap); }, virtualRun);
+    measure("PolicyCache<Lru,Mutex> (adapter)",
+            [capacity]() { return std::make_unique<KamaCache::PolicyCacheAdapter<MutexLru>>(capacity); }, virtualRun);
+    measure("PolicyCache<Lru,NoLock> (adapter)",
+            [capacity]() { return std::make_unique<KamaCache::PolicyCacheAdapter<LocalLru>>(capacity); }, virtualRun);
+    measure("PolicyCache<Lru,Mutex> (direct)",
+            [capacity]() { return std::make_unique<MutexLru>(capacity); }, directRun);
+    measure("PolicyCache<Lru,NoLock> (direct)",
+            [capacity]() { return std::make_unique<LocalLru>(capacity); }, directRun);
+    measure("PolicyCache<Clock,NoLock> (direct)",
+            [capacity]() { return std::make_unique<LocalClock>(capacity); }, directRun);
+    return 0;
+}
@@ -0,0 +1,445 @@
+/*
+trace_sim：离线回放访问轨迹（trace），为每个策略画出命中率随容量变化的曲线（miss ratio curve）。
+
+轨迹格式：
+  文本：每行 "key [op] [size]"。key 是整数，不是整数时按字符串哈希；
+        op 为 get/r（默认）、put/w、del/d；size 缺省为 1。以 # 开头的行被忽略。
+  二进制（--format=binary，或文件名以 .bin 结尾）：连续的 16 字节记录
+        { uint64 key; uint32 size; uint8 op; uint8 pad[3]; }，op 为 0=get 1=put 2=del，本机字节序。
+
+回放规则和 cache_bench 一致：get 未命中时把这个 key 放进缓存（demand fill）；put 直接写入；del 删除。
+命中率只统计 get。--by-size 时容量按 size 之和计算（字节），否则按条目个数。
+
+空间采样（SHARDS）：--sample-rate=R < 1 时只保留哈希值落在前 R 比例内的 key，
+每个 key 要么全部保留要么全部丢弃，缓存容量同样乘以 R。缩小后的模拟的命中率近似于完整模拟，
+内存和时间都按 R 缩小，10 亿次访问的轨迹用 R=0.001 只需回放约一百万次。
+采样到的请求数和期望值的偏差用 SHARDS_adj 修正（见 adjustedRatio）。
+
+每个 (策略, k, 容量) 组合是一个独立的任务，由 --jobs 个线程并行执行。
+
+用法示例：
+  ./trace_sim --trace=requests.bin --policies=lru,lruk,lfu --k=1,2,3 \
+              --capacities=1000,10000,100000 --sample-rate=0.01 --jobs=8
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ArcCache.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+#include "LruKCache.h"
+#include "S3FifoCache.h"
+#include "WTinyLfuCache.h"
+
+using namespace KamaCache;
+
+using Key = uint64_t;
+using Value = uint32_t; // 值就是条目的大小，weigher 直接返回它
+
+namespace {
+
+enum Op : uint8_t { Get = 0, Put = 1, Del = 2 };
+
+// 二进制轨迹的记录格式，也是内存中采样后轨迹的格式
+struct Request {
+    uint64_t key;
+    uint32_t size;
+    uint8_t op;
+    uint8_t pad[3];
+};
+static_assert(sizeof(Request) == 16, "binary trace records are 16 bytes");
+
+struct Options {
+    std::string trace;
+    std::string format;               // text | binary，为空时按扩展名判断
+    std::vector<std::string> policies{"lru", "lruk", "lfu"};
+    std::vector<int> ks{2};           // LRU-K 的 k，可以一次扫多个
+    double historyRatio = 2.0;        // LRU-K 历史容量 = 容量 * historyRatio
+    std::vector<uint64_t> capacities; // 为空时按轨迹中不同 key 的个数自动生成
+    int points = 12;                  // 自动生成容量时的点数
+    double sampleRate = 1.0;          // SHARDS 采样率
+    bool bySize = false;              // 容量按 size 之和计算
+    int jobs = 0;                     // 并行线程数，0 表示硬件线程数
+};
+
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+        if (end > start) out.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+void usage(const char* prog) {
+    std::printf(
+        "usage: %s --trace=FILE [options]\n"
+        "  --format=text|binary        default: binary if FILE ends in .bin\n"
+        "  --policies=lru,lruk,lfu     also: arc,tinylfu,s3fifo (count-based only)\n"
+        "  --k=A,B,...                 LRU-K k values to sweep\n"
+        "  --history-ratio=X           LRU-K history capacity = capacity * X\n"
+        "  --capacities=A,B,...        capacities (entries, or bytes with --by-size)\n"
+        "  --points=N                  auto capacities: N log-spaced points up to the working set\n"
+        "  --sample-rate=R             SHARDS spatial sampling rate in (0, 1]\n"
+        "  --by-size                   capacity counts request sizes instead of entries\n"
+        "  --jobs=N                    parallel simulations (default: hardware threads)\n", prog);
+}
+
+bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string val = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (name == "--help" || name == "-h") { usage(argv[0]); std::exit(0); }
+        else if (name == "--trace") opt.trace = val;
+        else if (name == "--format") opt.format = val;
+        else if (name == "--policies") opt.policies = splitList(val);
+        else if (name == "--k") {
+            opt.ks.clear();
+            for (auto& s : splitList(val)) opt.ks.push_back(std::max(1, std::stoi(s)));
+        }
+        else if (name == "--history-ratio") opt.historyRatio = std::stod(val);
+        else if (name == "--capacities") {
+            opt.capacities.clear();
+            for (auto& s : splitList(val)) opt.capacities.push_back(std::stoull(s));
+        }
+        else if (name == "--points") opt.points = std::max(1, std::stoi(val));
+        else if (name == "--sample-rate") opt.sampleRate = std::stod(val);
+        else if (name == "--by-size") opt.bySize = true;
+        else if (name == "--jobs") opt.jobs = std::stoi(val);
+        else {
+            std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.trace.empty()) {
+        usage(argv[0]);
+        return false;
+    }
+    if (!(opt.sampleRate > 0 && opt.sampleRate <= 1)) {
+        std::fprintf(stderr, "--sample-rate must be in (0, 1]\n");
+        return false;
+    }
+    return true;
+}
+
+// ---------------- 读取与采样 ----------------
+
+// SHARDS：按 key 的哈希采样，同一个 key 的所有访问要么全部保留，要么全部丢弃。
+// 用 sampledHash 只看哈希的高位，被采样的 key 在缓存索引里仍然均匀分布
+class Sampler {
+public:
+    explicit Sampler(double rate)
+    : threshold_(rate >= 1.0 ? kSampleModulus : static_cast<uint64_t>(rate * kSampleModulus)) {}
+
+    bool keep(uint64_t key) const {
+        return threshold_ == kSampleModulus || sampledHash(mixHash(key), threshold_);
+    }
+
+private:
+    uint64_t threshold_;
+};
+
+bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = std::strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// 整个轨迹（采样前）的规模，用于修正采样误差
+struct TraceTotals {
+    uint64_t requests = 0;
+    uint64_t gets = 0;
+    uint64_t getBytes = 0;
+
+    void add(const Request& req) {
+        ++requests;
+        if (req.op == Get) {
+            ++gets;
+            getBytes += req.size;
+        }
+    }
+};
+
+// 二进制轨迹：mmap 整个文件顺序扫描
+bool loadBinary(const std::string& path, const Sampler& sampler, std::vector<Request>& out, TraceTotals& totals) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    uint64_t total = size / sizeof(Request);
+    if (total == 0) {
+        ::close(fd);
+        return true;
+    }
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    const Request* records = static_cast<const Request*>(addr);
+    for (uint64_t i = 0; i < total; ++i) {
+        totals.add(records[i]);
+        if (sampler.keep(records[i].key)) out.push_back(records[i]);
+    }
+    ::munmap(addr, size);
+    return true;
+}
+
+bool parseOp(const std::string& s, uint8_t& op) {
+    if (s.empty() || s == "get" || s == "r" || s == "read" || s == "g") op = Get;
+    else if (s == "put" || s == "w" || s == "write" || s == "set" || s == "p") op = Put;
+    else if (s == "del" || s == "d" || s == "delete") op = Del;
+    else return false;
+    return true;
+}
+
+bool loadText(const std::string& path, const Sampler& sampler, std::vector<Request>& out, TraceTotals& totals) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    char keyBuf[256], opBuf[16];
+    uint64_t lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#') continue;
+        opBuf[0] = '\0';
+        unsigned long long size = 1;
+        int fields = std::sscanf(line.c_str(), "%255s %15s %llu", keyBuf, opBuf, &size);
+        if (fields < 1) continue;
+
+        Request request{};
+        if (!parseOp(fields >= 2 ? opBuf : "", request.op)) {
+            std::fprintf(stderr, "%s:%llu: unknown op '%s'\n", path.c_str(),
+                         static_cast<unsigned long long>(lineNo), opBuf);
+            return false;
+        }
+        char* end;
+        request.key = std::strtoull(keyBuf, &end, 10);
+        if (*end != '\0') request.key = std::hash<std::string>{}(keyBuf);
+        request.size = static_cast<uint32_t>(std::max<unsigned long long>(size, 1));
+        totals.add(request);
+        if (sampler.keep(request.key)) out.push_back(request);
+    }
+    return true;
+}
+
+// ---------------- 回放 ----------------
+
+struct Config {
+    std::string policy;
+    int k;
+    uint64_t capacity;
+};
+
+struct Result {
+    uint64_t simCapacity = 0;
+    uint64_t gets = 0;
+    uint64_t hits = 0;
+    uint64_t getBytes = 0;
+    uint64_t hitBytes = 0;
+};
+
+// 一次 get 请求：未命中时把 key 放进缓存
+template <typename Cache>
+bool demandFill(Cache& cache, const Request& req) {
+    Value value;
+    if (cache.get(req.key, value)) return true;
+    cache.put(req.key, req.size);
+    return false;
+}
+
+// LRU-K 的 get 和 put 各算一次访问，k=2 时每次未命中都会直接晋升；用 getOrPut 只算一次
+bool demandFill(LruKCache<Key, Value>& cache, const Request& req) {
+    Value value = req.size;
+    return cache.getOrPut(req.key, value);
+}
+
+// 回放不经过虚函数，直接调用具体类型的 get/put/remove
+template <typename Cache>
+void replay(Cache& cache, const std::vector<Request>& requests, Result& r) {
+    for (const Request& req : requests) {
+        switch (req.op) {
+        case Get:
+            ++r.gets;
+            r.getBytes += req.size;
+            if (demandFill(cache, req)) {
+                ++r.hits;
+                r.hitBytes += req.size;
+            }
+            break;
+        case Put:
+            cache.put(req.key, req.size);
+            break;
+        default:
+            cache.remove(req.key);
+            break;
+        }
+    }
+}
+
+bool runConfig(const Config& c, const Options& opt, const std::vector<Request>& requests,
+               double avgSize, Result& r) {
+    // 采样后的模拟使用按采样率缩小的容量
+    r.simCapacity = std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(c.capacity * opt.sampleRate)));
+    int cap = static_cast<int>(std::min<uint64_t>(r.simCapacity, INT32_MAX));
+    Weigher<Key, Value> weigher = [](const Key&, const Value& size) { return static_cast<size_t>(size); };
+
+    if (c.policy == "lru") {
+        auto cache = opt.bySize ? std::make_unique<LruCache<Key, Value>>(r.simCapacity, weigher)
+                                : std::make_unique<LruCache<Key, Value>>(cap);
+        replay(*cache, requests, r);
+    } else if (c.policy == "lfu") {
+        auto cache = opt.bySize ? std::make_unique<LfuCache<Key, Value>>(r.simCapacity, weigher)
+                                : std::make_unique<LfuCache<Key, Value>>(cap);
+        replay(*cache, requests, r);
+    } else if (c.policy == "lruk") {
+        // 历史记录按条目个数限制（暂存的值另按 simCapacity 字节计重）；按字节模拟时用平均大小换算成条目个数
+        double entries = opt.bySize ? r.simCapacity / avgSize : cap;
+        int history = static_cast<int>(std::min<double>(std::max(entries * opt.historyRatio, 1.0), INT32_MAX));
+        auto cache = opt.bySize ? std::make_unique<LruKCache<Key, Value>>(r.simCapacity, history, c.k, weigher)
+                                : std::make_unique<LruKCache<Key, Value>>(cap, history, c.k);
+        replay(*cache, requests, r);
+    } else if (c.policy == "arc" && !opt.bySize) {
+        ArcCache<Key, Value> cache(cap);
+        replay(cache, requests, r);
+    } else if (c.policy == "tinylfu" && !opt.bySize) {
+        WTinyLfuCache<Key, Value> cache(cap);
+        replay(cache, requests, r);
+    } else if (c.policy == "s3fifo" && !opt.bySize) {
+        S3FifoCache<Key, Value> cache(cap);
+        replay(cache, requests, r);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// SHARDS_adj：采样到的请求数和期望值（总数 * 采样率）之差几乎都来自少数极热的 key，
+// 它们在任何容量下都会命中，所以把差值计入命中数，再除以期望值。没有采样时就是普通的命中率
+double adjustedRatio(uint64_t hits, uint64_t sampled, double expected) {
+    if (sampled == 0 || expected <= 0) return 0.0;
+    double adjusted = (static_cast<double>(hits) + (expected - sampled)) / expected;
+    return std::min(1.0, std::max(0.0, adjusted));
+}
+
+// 自动容量：从工作集的 1/2^(points-1) 到整个工作集，按对数均匀取点（已换算回采样前的规模）
+std::vector<uint64_t> autoCapacities(const Options& opt, const std::vector<Request>& requests) {
+    std::unordered_set<uint64_t> keys;
+    uint64_t bytes = 0;
+    for (const Request& req : requests) {
+        if (keys.insert(req.key).second) bytes += req.size;
+    }
+    double working = (opt.bySize ? bytes : keys.size()) / opt.sampleRate;
+    std::vector<uint64_t> capacities;
+    for (int i = opt.points - 1; i >= 0; --i) {
+        uint64_t c = static_cast<uint64_t>(working / std::pow(2.0, i));
+        if (c > 0 && (capacities.empty() || c != capacities.back())) capacities.push_back(c);
+    }
+    return capacities;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) return 1;
+
+    auto begin = std::chrono::steady_clock::now();
+    Sampler sampler(opt.sampleRate);
+    std::vector<Request> requests;
+    TraceTotals totals;
+    bool binary = opt.format.empty() ? endsWith(opt.trace, ".bin") : opt.format == "binary";
+    bool loaded = binary ? loadBinary(opt.trace, sampler, requests, totals)
+                         : loadText(opt.trace, sampler, requests, totals);
+    if (!loaded) {
+        std::fprintf(stderr, "cannot read trace: %s\n", opt.trace.c_str());
+        return 1;
+    }
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::fprintf(stderr, "loaded %llu requests, %zu sampled (rate %g) in %.2fs\n",
+                 static_cast<unsigned long long>(totals.requests), requests.size(), opt.sampleRate, loadSeconds);
+
+    if (opt.capacities.empty()) opt.capacities = autoCapacities(opt, requests);
+    double sizeSum = 0;
+    for (const Request& req : requests) sizeSum += req.size;
+    double avgSize = requests.empty() ? 1.0 : sizeSum / requests.size();
+
+    std::vector<Config> configs;
+    for (const auto& policy : opt.policies) {
+        const std::vector<int> noK{0};
+        for (int k : policy == "lruk" ? opt.ks : noK) {
+            for (uint64_t capacity : opt.capacities) {
+                configs.push_back(Config{policy, k, capacity});
+            }
+        }
+    }
+
+    // 每个组合独立回放同一份只读的采样轨迹，线程之间不共享缓存
+    std::vector<Result> results(configs.size());
+    std::vector<char> ok(configs.size(), 0);
+    std::atomic<size_t> next{0};
+    int jobs = opt.jobs > 0 ? opt.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<int>(std::min<size_t>(jobs, configs.size()));
+    begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < jobs; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next.fetch_add(1); i < configs.size(); i = next.fetch_add(1)) {
+                ok[i] = runConfig(configs[i], opt, requests, avgSize, results[i]);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::fprintf(stderr, "replayed %zu configurations on %d threads in %.2fs\n",
+                 configs.size(), jobs, replaySeconds);
+
+    std::printf("%-8s %3s %14s %14s %12s %10s %10s %14s\n",
+                "policy", "k", "capacity", "sim_capacity", "gets", "hit_ratio", "miss_ratio", "byte_hit_ratio");
+    for (size_t i = 0; i < configs.size(); ++i) {
+        const Config& c = configs[i];
+        if (!ok[i]) {
+            std::fprintf(stderr, "unsupported policy%s: %s\n", opt.bySize ? " with --by-size" : "", c.policy.c_str());
+            continue;
+        }
+        const Result& r = results[i];
+        double hitRatio = adjustedRatio(r.hits, r.gets, totals.gets * opt.sampleRate);
+        double byteHitRatio = adjustedRatio(r.hitBytes, r.getBytes, totals.getBytes * opt.sampleRate);
+        std::printf("%-8s %3d %14llu %14llu %12llu %10.4f %10.4f %14.4f\n",
+                    c.policy.c_str(), c.k, static_cast<unsigned long long>(c.capacity),
+                    static_cast<unsigned long long>(r.simCapacity), static_cast<unsigned long long>(r.gets),
+                    hitRatio, 1.0 - hitRatio, byteHitRatio);
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AdaptiveCache.h"
+
+using namespace KamaCache;
+
+// get 未命中时 put，返回命中次数
+template <typename Cache>
+size_t demandFill(Cache& cache, const std::vector<int>& keys) {
+    size_t hits = 0;
+    for (int key : keys) {
+        int value = 0;
+        if (cache.get(key, value)) {
+            EXPECT_EQ(value, key);
+            ++hits;
+        } else {
+            cache.put(key, key);
+        }
+    }
+    return hits;
+}
+
+// 频率主导：800 个长期热点和一次性扫描的 key 交替出现。
+// LRU 里热点两次访问之间会被约 1300 个不同的 key 冲掉；LFU 和 LRU-2 能留住热点
+std::vector<int> frequencyWorkload(size_t ops) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> hot(0, 799);
+    std::vector<int> keys;
+    int scan = 1000000;
+    for (size_t i = 0; i < ops; ++i) {
+        keys.push_back(i % 2 == 0 ? hot(rng) : scan++);
+    }
+    return keys;
+}
+
+// 最近性主导：800 个热点每 5000 次访问整体换一批。LFU 里旧热点的高频次会挡住新热点
+std::vector<int> recencyWorkload(size_t ops) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> hot(0, 799);
+    std::vector<int> keys;
+    for (size_t i = 0; i < ops; ++i) {
+        keys.push_back(static_cast<int>(i / 5000) * 1000 + hot(rng));
+    }
+    return keys;
+}
+
+static AdaptiveOptions testOptions(AdaptivePolicy initial) {
+    AdaptiveOptions options;
+    options.sampleRate = 0.25;
+    options.windowSamples = 500;
+    options.initial = initial;
+    return options;
+}
+
+TEST(AdaptiveCacheTest, BasicOperations) {
+    AdaptiveCache<int, std::string> cache(3);
+    cache.put(1, "one");
+    cache.put(2, "two");
+    cache.put(3, "three");
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "one");
+
+    cache.put(1, "uno");
+    EXPECT_EQ(cache.get(1), "uno");
+    cache.put(4, "four");
+    EXPECT_EQ(cache.size(), 3u);
+
+    cache.remove(1);
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_TRUE(cache.get(4, value));
+    EXPECT_EQ(value, "four");
+}
+
+TEST(AdaptiveCacheTest, HeterogeneousLookup) {
+    AdaptiveCache<std::string, int> cache(4, testOptions(AdaptivePolicy::Lru));
+    cache.put("alpha", 1);
+    int value = 0;
+    EXPECT_TRUE(cache.get(std::string_view("alpha"), value));
+    EXPECT_EQ(value, 1);
+    EXPECT_FALSE(cache.get(std::string_view("beta"), value));
+}
+
+TEST(AdaptiveCacheTest, ZeroCapacity) {
+    AdaptiveCache<int, int> cache(0);
+    cache.put(1, 1);
+    int value = 0;
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.adaptiveStats().sampledAccesses, 0u);
+}
+
+// 从 LRU 出发，在频率主导的负载上切换到能留住热点的策略，命中率明显高于固定的 LRU
+TEST(AdaptiveCacheTest, SwitchesAwayFromLruUnderScans) {
+    std::vector<int> keys = frequencyWorkload(200000);
+    AdaptiveCache<int, int> adaptive(1000, testOptions(AdaptivePolicy::Lru));
+    size_t adaptiveHits = demandFill(adaptive, keys);
+
+    AdaptiveOptions fixed = testOptions(AdaptivePolicy::Lru);
+    fixed.sampleRate = 0;
+    AdaptiveCache<int, int> lru(1000, fixed);
+    size_t lruHits = demandFill(lru, keys);
+
+    AdaptiveStats stats = adaptive.adaptiveStats();
+    EXPECT_NE(stats.active, AdaptivePolicy::Lru);
+    EXPECT_GE(stats.switches, 1u);
+    EXPECT_GT(adaptiveHits, lruHits * 3 / 2);
+}
+
+// 从 LFU 出发，在热点不断漂移的负载上切换走
+TEST(AdaptiveCacheTest, SwitchesAwayFromLfuWhenHotSetShifts) {
+    std::vector<int> keys = recencyWorkload(200000);
+    AdaptiveCache<int, int> adaptive(1000, testOptions(AdaptivePolicy::Lfu));
+    demandFill(adaptive, keys);
+
+    AdaptiveStats stats = adaptive.adaptiveStats();
+    EXPECT_NE(stats.active, AdaptivePolicy::Lfu);
+    EXPECT_GE(stats.switches, 1u);
+}
+
+// 各策略不相上下时（工作集小于容量）不切换
+TEST(AdaptiveCacheTest, HysteresisPreventsFlapping) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> dist(0, 499);
+    std::vector<int> keys;
+    for (int i = 0; i < 100000; ++i) keys.push_back(dist(rng));
+
+    AdaptiveCache<int, int> cache(1000, testOptions(AdaptivePolicy::LruK));
+    demandFill(cache, keys);
+    AdaptiveStats stats = cache.adaptiveStats();
+    EXPECT_GT(stats.windows, 10u);
+    EXPECT_EQ(stats.switches, 0u);
+    EXPECT_EQ(stats.active, AdaptivePolicy::LruK);
+}
+
+// 只有一个窗口领先不够：patience 个窗口连续领先才切换
+TEST(AdaptiveCacheTest, PatienceDelaysSwitch) {
+    std::vector<int> keys = frequencyWorkload(200000);
+    AdaptiveOptions options = testOptions(AdaptivePolicy::Lru);
+    options.patience = 1000000;
+    AdaptiveCache<int, int> cache(1000, options);
+    demandFill(cache, keys);
+    EXPECT_EQ(cache.adaptiveStats().switches, 0u);
+    EXPECT_EQ(cache.activePolicy(), AdaptivePolicy::Lru);
+}
+
+// 采样开销的统计：采样比例接近 sampleRate，不采样时影子缓存不存在
+TEST(AdaptiveCacheTest, ReportsSamplingOverhead) {
+    std::vector<int> keys = frequencyWorkload(100000);
+    AdaptiveOptions options;
+    options.sampleRate = 0.05;
+    AdaptiveCache<int, int> cache(2000, options);
+    demandFill(cache, keys);
+
+    AdaptiveStats stats = cache.adaptiveStats();
+    EXPECT_EQ(stats.accesses, keys.size());
+    EXPECT_EQ(stats.shadowCapacity, 100u);
+    EXPECT_GT(stats.sampledFraction(), 0.03);
+    EXPECT_LT(stats.sampledFraction(), 0.07);
+    EXPECT_GT(stats.shadowNanos, 0u);
+
+    options.sampleRate = 0;
+    AdaptiveCache<int, int> unsampled(2000, options);
+    demandFill(unsampled, keys);
+    stats = unsampled.adaptiveStats();
+    EXPECT_EQ(stats.sampledAccesses, 0u);
+    EXPECT_EQ(stats.shadowCapacity, 0u);
+    EXPECT_EQ(stats.shadowNanos, 0u);
+}
+
+TEST(AdaptiveCacheTest, RemovalListener) {
+    AdaptiveCache<int, int> cache(10);
+    size_t evicted = 0;
+    size_t removed = 0;
+    cache.setRemovalListener([&](std::vector<RemovalNotification<int, int>>& batch) {
+        for (auto& n : batch) {
+            EXPECT_EQ(n.value, n.key);
+            evicted += n.cause == RemovalCause::Evicted;
+            removed += n.cause == RemovalCause::Explicit;
+        }
+    });
+    for (int key = 0; key < 30; ++key) cache.put(key, key);
+    int survivor = -1;
+    for (int key = 0; key < 30 && survivor < 0; ++key) {
+        int value = 0;
+        if (cache.get(key, value)) survivor = key;
+    }
+    cache.remove(survivor);
+    EXPECT_EQ(evicted, 20u);
+    EXPECT_EQ(removed, 1u);
+}
+
+TEST(AdaptiveCacheTest, ConcurrentAccess) {
+    AdaptiveCache<int, int> cache(500, testOptions(AdaptivePolicy::Lru));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            std::mt19937 rng(t);
+            std::uniform_int_distribution<int> dist(0, 2000);
+            for (int i = 0; i < 20000; ++i) {
+                int key = dist(rng);
+                int value = 0;
+                if (cache.get(key, value)) {
+                    EXPECT_EQ(value, key);
+                } else {
+                    cache.put(key, key);
+                }
+                if (i % 100 == 0) cache.remove(key);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_LE(cache.size(), 500u);
+    EXPECT_EQ(cache.adaptiveStats().accesses, 80000u);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "ArcCache.h"
+#include "LruCache.h"
+
+using namespace KamaCache;
+
+// 测试 ArcCache 的基本插入和访问
+TEST(ArcCacheTest, BasicOperations) {
+    ArcCache<int, std::string> cache(2);
+
+    cache.put(1, "One");
+    cache.put(2, "Two");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value)); // key 1 进入 T2
+    EXPECT_EQ(value, "One");
+
+    // 缓存已满，淘汰 T1 中的 key 2（进入 B1）
+    cache.put(3, "Three");
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(cache.get(3), "Three");
+
+    cache.remove(1);
+    EXPECT_FALSE(cache.get(1, value));
+}
+
+// B1 幽灵命中会增大 T1 的目标大小
+TEST(ArcCacheTest, GhostHitAdaptsTarget) {
+    ArcCache<int, int> cache(2);
+    int value = 0;
+    cache.put(1, 1);
+    cache.put(2, 2);
+    EXPECT_TRUE(cache.get(1, value)); // key 1 进入 T2
+    cache.put(3, 3); // key 2 从 T1 淘汰到 B1
+    EXPECT_EQ(cache.target(), 0u);
+    EXPECT_FALSE(cache.get(2, value));
+
+    cache.put(2, 2); // B1 命中
+    EXPECT_GT(cache.target(), 0u);
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_EQ(value, 2);
+}
+
+// 热点数据 + 一次性扫描的混合负载：ARC 的命中率应明显高于 LRU
+TEST(ArcCacheTest, ResistsScans) {
+    const int capacity = 100;
+    ArcCache<int, int> arc(capacity);
+    LruCache<int, int> lru(capacity);
+
+    int arcHits = 0, lruHits = 0, total = 0;
+    int scanKey = 100000;
+    for (int round = 0; round < 50; ++round) {
+        // 热点集合：50 个 key，各访问两次
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int k = 0; k < 50; ++k) {
+                int value;
+                ++total;
+                if (arc.get(k, value)) ++arcHits; else arc.put(k, k);
+                if (lru.get(k, value)) ++lruHits; else lru.put(k, k);
+            }
+        }
+        // 扫描：200 个只出现一次的 key
+        for (int i = 0; i < 200; ++i, ++scanKey) {
+            int value;
+            ++total;
+            if (arc.get(scanKey, value)) ++arcHits; else arc.put(scanKey, scanKey);
+            if (lru.get(scanKey, value)) ++lruHits; else lru.put(scanKey, scanKey);
+        }
+    }
+
+    EXPECT_GT(arcHits, lruHits);
+    EXPECT_GT(static_cast<double>(arcHits) / total, 0.25);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "BufferedLruCache.h"
+
+using namespace KamaCache;
+
+// 测试 BufferedLruCache 的基本插入、访问和淘汰
+TEST(BufferedLruCacheTest, BasicOperations) {
+    BufferedLruCache<int, std::string> cache(2, 4);
+
+    cache.put(1, "One");
+    cache.put(2, "Two");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "One");
+
+    // 回放缓冲区后，key 2 是最久未使用的
+    cache.flush();
+    cache.put(3, "Three");
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(cache.get(3), "Three");
+    EXPECT_EQ(cache.size(), 2u);
+
+    cache.remove(1);
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+// 即使不显式回放，淘汰时也会先回放被选中节点所在段的缓冲区
+TEST(BufferedLruCacheTest, EvictionSeesBufferedAccess) {
+    BufferedLruCache<int, int> cache(2, 1);
+    cache.put(1, 1);
+    cache.put(2, 2);
+
+    int value = 0;
+    EXPECT_TRUE(cache.get(1, value));
+    cache.put(3, 3); // key 1 的访问在缓冲区里，应淘汰 key 2
+
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_FALSE(cache.get(2, value));
+}
+
+// 多线程读写，读者不拿全局锁
+TEST(BufferedLruCacheTest, ConcurrentAccess) {
+    BufferedLruCache<int, int> cache(256, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            for (int i = 0; i < 5000; ++i) {
+                int key = (t * 7919 + i) % 512;
+                int value = -1;
+                if (cache.get(key, value)) {
+                    EXPECT_EQ(value, key);
+                } else {
+                    cache.put(key, key);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_LE(cache.size(), 256u);
+}
+
+// 移动构造在 hold 为 true 时阻塞。put 新 key 时在只持有链表锁、不持有段锁的时候移动值，
+// 用它让另一个线程一直占着链表锁，读者的回放因此拿不到锁
+struct SlowMove {
+    int v = 0;
+    static inline std::atomic<bool> hold{false};
+    static inline std::atomic<bool> holding{false};
+
+    SlowMove() = default;
+    explicit SlowMove(int x) : v(x) {}
+    SlowMove(const SlowMove&) = default;
+    SlowMove& operator=(const SlowMove&) = default;
+    SlowMove& operator=(SlowMove&&) = default;
+    SlowMove(SlowMove&& other) noexcept : v(other.v) {
+        if (hold.load()) {
+            holding = true;
+            while (hold.load()) std::this_thread::yield();
+        }
+    }
+};
+
+// 缓冲区满而链表锁又被占着：丢弃这次提升并计数，get 照常返回值，不等锁
+TEST(BufferedLruCacheTest, FullBufferDropsPromotionWithoutBlocking) {
+    BufferedLruCache<int, SlowMove> cache(64, 1);
+    SlowMove one(1);
+    cache.put(1, one);
+
+    SlowMove::hold = true;
+    std::thread writer([&cache]() {
+        SlowMove two(2);
+        cache.put(2, two);
+    });
+    // 断言失败提前返回时也要放开写者并 join，否则线程析构时 std::terminate
+    struct ReleaseWriter {
+        std::thread& writer;
+        ~ReleaseWriter() {
+            SlowMove::hold = false;
+            if (writer.joinable()) writer.join();
+        }
+    } release{writer};
+    while (!SlowMove::holding.load()) std::this_thread::yield();
+
+    uint64_t before = cache.droppedPromotions();
+    SlowMove value;
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(cache.get(1, value));
+        EXPECT_EQ(value.v, 1);
+    }
+    // 一个段的缓冲区只有 32 个槽，多出来的访问全部被丢弃
+    EXPECT_GE(cache.droppedPromotions(), before + 100 - 32);
+
+    SlowMove::hold = false;
+    writer.join();
+    cache.flush();
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_EQ(value.v, 2);
+    EXPECT_EQ(cache.size(), 2u);
+}
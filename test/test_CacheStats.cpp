@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "HashLruCache.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+#include "LruKCache.h"
+
+using namespace KamaCache;
+
+// 这个测试目标编译时定义了 KAMACACHE_ENABLE_STATS
+static_assert(kStatsEnabled, "test_CacheStats must be built with KAMACACHE_ENABLE_STATS");
+// 开关是类型的一部分：打开统计时缓存类位于 stats_on 命名空间，和关闭统计的翻译单元不会混用同一个定义
+static_assert(std::is_same<LruCache<int, int>, stats_on::LruCache<int, int>>::value,
+              "stats-enabled caches must live in the stats_on inline namespace");
+
+// LruCache 的各项计数
+TEST(CacheStatsTest, LruCacheCounters) {
+    LruCache<int, int> cache(2);
+    int value = 0;
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(1, 10);                  // 更新
+    EXPECT_TRUE(cache.get(1, value));  // 命中
+    EXPECT_FALSE(cache.get(3, value)); // 未命中
+    cache.put(3, 3);                   // 淘汰 key 2
+    cache.remove(3);
+
+    CacheStatsSnapshot snap = cache.stats();
+    EXPECT_EQ(snap.hits, 1u);
+    EXPECT_EQ(snap.misses, 1u);
+    EXPECT_EQ(snap.inserts, 3u);
+    EXPECT_EQ(snap.updates, 1u);
+    EXPECT_EQ(snap.evictions, 1u);
+    EXPECT_EQ(snap.removals, 1u);
+    EXPECT_DOUBLE_EQ(snap.hitRatio(), 0.5);
+
+    // 每次 get/put 都记录一次耗时和一次等锁耗时（remove 只有等锁）
+    EXPECT_EQ(snap.getLatency.count(), 2u);
+    EXPECT_EQ(snap.putLatency.count(), 4u);
+    EXPECT_EQ(snap.lockWait.count(), 7u);
+}
+
+// 批量接口按 key 计数
+TEST(CacheStatsTest, BatchCounters) {
+    LfuCache<int, int> cache(4);
+    int keys[] = {1, 2, 3};
+    int values[] = {1, 2, 3};
+    cache.putMany(keys, values, 3);
+
+    int probe[] = {1, 2, 9, 10};
+    int out[4];
+    bool hits[4];
+    EXPECT_EQ(cache.getMany(probe, 4, out, hits), 2u);
+
+    CacheStatsSnapshot snap = cache.stats();
+    EXPECT_EQ(snap.inserts, 3u);
+    EXPECT_EQ(snap.hits, 2u);
+    EXPECT_EQ(snap.misses, 2u);
+}
+
+// LRU-K 只把进入主缓存算作插入
+TEST(CacheStatsTest, LruKCountsResidentOnly) {
+    LruKCache<int, int> cache(1, 4, 2);
+    int value = 0;
+    cache.put(1, 1);                   // 只进入历史记录
+    EXPECT_TRUE(cache.get(1, value));  // 第 2 次访问，晋升
+    cache.put(2, 2);
+    cache.put(2, 2);                   // 晋升，淘汰 key 1
+
+    CacheStatsSnapshot snap = cache.stats();
+    EXPECT_EQ(snap.inserts, 2u);
+    EXPECT_EQ(snap.evictions, 1u);
+    EXPECT_EQ(snap.hits, 1u);
+}
+
+// 分片缓存汇总所有分片，多线程下计数不丢失
+TEST(CacheStatsTest, ConcurrentShardedCounters) {
+    HashLruCache<int, int> cache(1000, 4);
+    const int threads = 4;
+    const int perThread = 10000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&cache, t] {
+            int value = 0;
+            for (int i = 0; i < perThread; ++i) {
+                int key = (i * 31 + t) % 2000;
+                if (!cache.get(key, value)) cache.put(key, key);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    CacheStatsSnapshot snap = cache.stats();
+    EXPECT_EQ(snap.hits + snap.misses, uint64_t(threads) * perThread);
+    EXPECT_EQ(snap.getLatency.count(), uint64_t(threads) * perThread);
+    EXPECT_EQ(snap.inserts + snap.updates, snap.misses);
+}
+
+// 对数分桶和分位数
+TEST(CacheStatsTest, HistogramBuckets) {
+    EXPECT_EQ(LatencyHistogram::bucketOf(0), 0u);
+    EXPECT_EQ(LatencyHistogram::bucketOf(1), 1u);
+    EXPECT_EQ(LatencyHistogram::bucketOf(3), 2u);
+    EXPECT_EQ(LatencyHistogram::bucketOf(1000), 10u);
+    EXPECT_EQ(LatencyHistogram::bucketOf(~uint64_t(0)), kLatencyBuckets - 1);
+
+    LatencyHistogram h;
+    h.buckets[LatencyHistogram::bucketOf(100)] = 99;
+    h.buckets[LatencyHistogram::bucketOf(5000)] = 1;
+    EXPECT_EQ(h.percentile(0.5), 127u);
+    EXPECT_EQ(h.percentile(1.0), 8191u);
+}
+
+// TTL 到期回收单独计数，不算作淘汰
+TEST(CacheStatsTest, ExpirationCounter) {
+    LruCache<int, int> cache(4);
+    cache.put(1, 1, std::chrono::milliseconds(5));
+    cache.put(2, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(cache.purgeExpired(), 1u);
+
+    CacheStatsSnapshot snap = cache.stats();
+    EXPECT_EQ(snap.expirations, 1u);
+    EXPECT_EQ(snap.evictions, 0u);
+}
@@ -0,0 +1,361 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "FileTier.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+
+using namespace KamaCache;
+
+static FileTierOptions smallTier() {
+    FileTierOptions options;
+    options.directory = ::testing::TempDir();
+    options.segmentBytes = 4096;
+    options.maxBytes = 1 << 20;
+    return options;
+}
+
+TEST(FileTierTest, OfferTakeErase) {
+    FileTier<int, std::string> tier(smallTier());
+    ASSERT_TRUE(tier.ok());
+    tier.offer(1, "one");
+    tier.offer(2, "two");
+    tier.offer(3, "three");
+
+    // 还在待写队列中也能取到
+    std::string value;
+    EXPECT_TRUE(tier.take(1, value));
+    EXPECT_EQ(value, "one");
+
+    tier.flush();
+    EXPECT_EQ(tier.stats().entries, 2u);
+    EXPECT_TRUE(tier.take(2, value));
+    EXPECT_EQ(value, "two");
+    // 取出即删除
+    EXPECT_FALSE(tier.take(2, value));
+
+    tier.erase(3);
+    EXPECT_FALSE(tier.take(3, value));
+    EXPECT_EQ(tier.stats().entries, 0u);
+}
+
+// 写线程编码、写盘期间取回同一批条目：拿到的是完整的值，之后不会再从磁盘读到它
+TEST(FileTierTest, TakeWhileBatchIsBeingWritten) {
+    FileTierOptions options = smallTier();
+    options.segmentBytes = 1 << 20;
+    options.maxBytes = 64 << 20;
+    FileTier<int, std::string> tier(options);
+    for (int round = 0; round < 20; ++round) {
+        for (int key = 0; key < 300; ++key) tier.offer(key, std::string(1000, static_cast<char>('a' + key % 26)));
+        std::string value;
+        for (int key = 0; key < 300; ++key) {
+            ASSERT_TRUE(tier.take(key, value)) << key;
+            EXPECT_EQ(value, std::string(1000, static_cast<char>('a' + key % 26)));
+        }
+        tier.flush();
+        EXPECT_EQ(tier.stats().entries, 0u);
+    }
+}
+
+// 同一个 key 再次下沉：只保留最新的值
+TEST(FileTierTest, NewerOfferWins) {
+    FileTier<int, std::string> tier(smallTier());
+    tier.offer(7, "old");
+    tier.flush();
+    tier.offer(7, "new");
+    tier.flush();
+    std::string value;
+    EXPECT_TRUE(tier.take(7, value));
+    EXPECT_EQ(value, "new");
+    EXPECT_FALSE(tier.take(7, value));
+}
+
+// 大部分记录被取走后，稀疏的段被压缩，剩下的记录仍然能读到
+TEST(FileTierTest, CompactsSparseSegments) {
+    FileTier<int, std::string> tier(smallTier());
+    std::string payload(100, 'x');
+    for (int key = 0; key < 400; ++key) tier.offer(key, payload + std::to_string(key));
+    tier.flush();
+    size_t before = tier.stats().diskBytes;
+
+    std::string value;
+    for (int key = 0; key < 400; ++key) {
+        if (key % 10 != 0) {
+            EXPECT_TRUE(tier.take(key, value));
+        }
+    }
+    tier.offer(-1, "wake"); // 回收在写线程处理完一批之后进行
+    tier.flush();
+
+    FileTierStats stats = tier.stats();
+    EXPECT_GT(stats.compactions, 0u);
+    EXPECT_LT(stats.diskBytes, before / 2);
+    for (int key = 0; key < 400; key += 10) {
+        ASSERT_TRUE(tier.take(key, value)) << key;
+        EXPECT_EQ(value, payload + std::to_string(key));
+    }
+}
+
+// 总大小超限时丢弃最旧的段
+TEST(FileTierTest, RespectsMaxBytes) {
+    FileTierOptions options = smallTier();
+    options.maxBytes = 16 * 1024;
+    FileTier<int, std::string> tier(options);
+    std::string payload(200, 'y');
+    for (int key = 0; key < 1000; ++key) {
+        tier.offer(key, payload);
+        if (key % 100 == 99) tier.flush();
+    }
+    tier.flush();
+
+    FileTierStats stats = tier.stats();
+    EXPECT_GT(stats.evicted, 0u);
+    EXPECT_LE(stats.diskBytes, options.maxBytes + options.segmentBytes);
+    std::string value;
+    EXPECT_FALSE(tier.take(0, value));  // 最旧的条目随段丢弃
+    EXPECT_TRUE(tier.take(999, value)); // 最新的还在
+}
+
+// LruCache 挂上二级缓存：被淘汰的条目在未命中时取回并放回内存
+TEST(FileTierTest, LruCacheSpillsAndPromotes) {
+    auto tier = std::make_shared<FileTier<int, std::string>>(smallTier());
+    LruCache<int, std::string> cache(10);
+    cache.setSecondTier(tier);
+    for (int key = 0; key < 100; ++key) cache.put(key, "v" + std::to_string(key));
+    tier->flush();
+    EXPECT_EQ(tier->stats().entries, 90u);
+
+    std::string value;
+    EXPECT_TRUE(cache.get(5, value));
+    EXPECT_EQ(value, "v5");
+    // 已经回到内存，二级缓存里不再有它
+    std::string tierValue;
+    EXPECT_FALSE(tier->take(5, tierValue));
+    EXPECT_TRUE(cache.visit(5, [](const std::string& v) { EXPECT_EQ(v, "v5"); }));
+
+    // 批量读取也会查二级缓存
+    int keys[3] = {6, 7, 1000};
+    std::string values[3];
+    bool hits[3];
+    EXPECT_EQ(cache.getMany(keys, 3, values, hits), 2u);
+    EXPECT_TRUE(hits[0]);
+    EXPECT_EQ(values[1], "v7");
+    EXPECT_FALSE(hits[2]);
+}
+
+// remove 之后二级缓存里的旧值不能再被读到
+TEST(FileTierTest, RemoveInvalidatesSecondTier) {
+    auto tier = std::make_shared<FileTier<int, std::string>>(smallTier());
+    LruCache<int, std::string> cache(2);
+    cache.setSecondTier(tier);
+    cache.put(1, "a");
+    cache.put(2, "b");
+    cache.put(3, "c"); // 1 下沉
+    cache.remove(1);
+    tier->flush();
+    std::string value;
+    EXPECT_FALSE(cache.get(1, value));
+}
+
+// 写入同样作废二级缓存里的旧值：新值过期之后，旧值不能被读回来
+TEST(FileTierTest, TtlWriteInvalidatesSecondTier) {
+    auto tier = std::make_shared<FileTier<int, int>>(smallTier());
+    LruCache<int, int> lru(1);
+    lru.setSecondTier(tier);
+    lru.put(1, 100);
+    lru.put(2, 200); // 1 下沉
+    tier->flush();
+    lru.put(1, 111, std::chrono::milliseconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int value = 0;
+    EXPECT_FALSE(lru.get(1, value));
+
+    auto lfuTier = std::make_shared<FileTier<int, int>>(smallTier());
+    LfuCache<int, int> lfu(1);
+    lfu.setSecondTier(lfuTier);
+    lfu.put(1, 100);
+    lfu.put(2, 200);
+    lfuTier->flush();
+    lfu.put(1, 111, std::chrono::milliseconds(5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(lfu.get(1, value));
+}
+
+// 新值太重被拒绝时，二级缓存里的旧值也已作废
+TEST(FileTierTest, RejectedWriteInvalidatesSecondTier) {
+    auto weigher = [](const int&, const std::string& v) { return v.size(); };
+    auto tier = std::make_shared<FileTier<int, std::string>>(smallTier());
+    LruCache<int, std::string> lru(2, weigher);
+    lru.setSecondTier(tier);
+    lru.put(1, "a");
+    lru.put(2, "b");
+    lru.put(3, "c"); // 1 下沉
+    tier->flush();
+    lru.put(1, "too heavy");
+    std::string value;
+    EXPECT_FALSE(lru.get(1, value));
+
+    auto lfuTier = std::make_shared<FileTier<int, std::string>>(smallTier());
+    LfuCache<int, std::string> lfu(2, weigher);
+    lfu.setSecondTier(lfuTier);
+    lfu.put(1, "a");
+    lfu.put(2, "b");
+    lfu.put(3, "c");
+    lfuTier->flush();
+    int keys[1] = {1};
+    std::string values[1] = {"too heavy"};
+    lfu.putMany(keys, values, 1);
+    EXPECT_FALSE(lfu.get(1, value));
+}
+
+// 内存中的二级缓存，take 在 gate 打开之前阻塞，用来在取回途中插入别的操作
+class GatedTier : public CacheTier<int, int> {
+public:
+    void offer(const int& key, int value) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[key] = value;
+    }
+    bool take(const int& key, int& value) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return false;
+        value = it->second;
+        entries_.erase(it);
+        ++taking_;
+        cv_.notify_all();
+        cv_.wait(lock, [this]() { return open_; });
+        return true;
+    }
+    void erase(const int& key) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.erase(key);
+    }
+    void waitTaking() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return taking_ > 0; });
+    }
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<int, int> entries_;
+    int taking_ = 0;
+    bool open_ = false;
+};
+
+// 取回途中删除的是别的 key：取回的条目照常放回内存，不会从两级缓存中一起丢失；
+// 删除的是同一个 key 时才不放回
+template <typename Cache>
+static void expectRemoveDuringTake() {
+    for (int target : {1, 2}) {
+        auto tier = std::make_shared<GatedTier>();
+        Cache cache(4);
+        cache.setSecondTier(tier);
+        cache.put(2, 20);
+        tier->offer(1, 10);
+
+        int value = 0;
+        std::thread reader([&]() { EXPECT_TRUE(cache.get(1, value)); });
+        tier->waitTaking();
+        cache.remove(target == 1 ? 1 : 2);
+        tier->open();
+        reader.join();
+        EXPECT_EQ(value, 10);
+
+        int again = 0;
+        EXPECT_EQ(cache.get(1, again), target != 1) << "removed key " << target;
+    }
+}
+
+TEST(FileTierTest, RemoveDuringTakeOnlyDropsThatKey) {
+    expectRemoveDuringTake<LruCache<int, int>>();
+    expectRemoveDuringTake<LfuCache<int, int>>();
+}
+
+// 取回途中同一个 key 被重新写入、又被淘汰进二级缓存：取回的旧值不能放回内存盖住新值
+template <typename Cache>
+static void expectPutAndEvictDuringTake() {
+    auto tier = std::make_shared<GatedTier>();
+    Cache cache(1);
+    cache.setSecondTier(tier);
+    tier->offer(1, 10);
+
+    int value = 0;
+    std::thread reader([&]() { EXPECT_TRUE(cache.get(1, value)); });
+    tier->waitTaking();
+    cache.put(1, 11);
+    cache.put(2, 20); // 淘汰 1，11 进入二级缓存
+    tier->open();
+    reader.join();
+    EXPECT_EQ(value, 10);
+
+    int again = 0;
+    EXPECT_TRUE(cache.get(1, again));
+    EXPECT_EQ(again, 11);
+}
+
+TEST(FileTierTest, PutAndEvictDuringTakeKeepsNewerValue) {
+    expectPutAndEvictDuringTake<LruCache<int, int>>();
+    expectPutAndEvictDuringTake<LfuCache<int, int>>();
+}
+
+// 带 TTL 的条目不下沉
+TEST(FileTierTest, TtlEntriesAreNotSpilled) {
+    auto tier = std::make_shared<FileTier<int, int>>(smallTier());
+    LruCache<int, int> cache(1);
+    cache.setSecondTier(tier);
+    cache.put(1, 1, std::chrono::milliseconds(60000));
+    cache.put(2, 2);
+    tier->flush();
+    int value = 0;
+    EXPECT_FALSE(cache.get(1, value));
+}
+
+TEST(FileTierTest, LfuCacheSpillsAndPromotes) {
+    auto tier = std::make_shared<FileTier<std::string, int>>(smallTier());
+    LfuCache<std::string, int> cache(4);
+    cache.setSecondTier(tier);
+    for (int i = 0; i < 20; ++i) cache.put("k" + std::to_string(i), i);
+    tier->flush();
+    int value = 0;
+    // 异构查找同样会查二级缓存
+    EXPECT_TRUE(cache.get(std::string_view("k3"), value));
+    EXPECT_EQ(value, 3);
+    EXPECT_FALSE(cache.get(std::string_view("k99"), value));
+}
+
+// 多线程读写：取回的值总是该 key 写入过的值
+TEST(FileTierTest, ConcurrentAccess) {
+    auto tier = std::make_shared<FileTier<int, int>>(smallTier());
+    LruCache<int, int> cache(64);
+    cache.setSecondTier(tier);
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, &wrong, t]() {
+            for (int i = 0; i < 5000; ++i) {
+                int key = (i * 31 + t) % 500;
+                int value = 0;
+                if (cache.get(key, value)) {
+                    if (value != key * 3) ++wrong;
+                } else {
+                    cache.put(key, key * 3);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(wrong.load(), 0);
+}
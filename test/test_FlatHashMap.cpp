@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "FlatHashMap.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+
+using namespace KamaCache;
+
+TEST(FlatHashMapTest, BasicOperations) {
+    FlatHashMap<int, int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.find(1) == map.end());
+
+    EXPECT_TRUE(map.emplace(1, 10).second);
+    EXPECT_TRUE(map.emplace(2, 20).second);
+    // 已存在的 key 不覆盖
+    auto result = map.emplace(1, 11);
+    EXPECT_FALSE(result.second);
+    EXPECT_EQ(result.first->second, 10);
+
+    EXPECT_EQ(map.size(), 2u);
+    EXPECT_EQ(map.find(2)->second, 20);
+    EXPECT_EQ(map.count(3), 0u);
+
+    EXPECT_EQ(map.erase(1), 1u);
+    EXPECT_EQ(map.erase(1), 0u);
+    EXPECT_EQ(map.size(), 1u);
+    map.erase(map.find(2));
+    EXPECT_TRUE(map.empty());
+}
+
+// 随机插入和删除，与 std::unordered_map 的结果逐步对比。
+// 小容量、高装载率下反复删除，覆盖向前移动跨过数组末尾的情况
+TEST(FlatHashMapTest, MatchesUnorderedMapUnderChurn) {
+    FlatHashMap<uint64_t, uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::mt19937_64 rng(42);
+
+    for (int i = 0; i < 200000; ++i) {
+        // 键按 1024 的倍数取，std::hash 的低位全部相同
+        uint64_t key = (rng() % 300) * 1024;
+        if (rng() % 3 == 0) {
+            EXPECT_EQ(map.erase(key), expected.erase(key));
+        } else if (map.emplace(key, i).second) {
+            expected.emplace(key, i);
+        }
+        ASSERT_EQ(map.size(), expected.size());
+    }
+
+    for (const auto& entry : expected) {
+        auto it = map.find(entry.first);
+        ASSERT_TRUE(it != map.end());
+        EXPECT_EQ(it->second, entry.second);
+    }
+    size_t visited = 0;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        EXPECT_EQ(expected.at(it->first), it->second);
+        ++visited;
+    }
+    EXPECT_EQ(visited, expected.size());
+}
+
+// 删除不留墓碑：反复插入删除不同的 key，槽位数不增长
+TEST(FlatHashMapTest, ChurnDoesNotGrowTable) {
+    FlatHashMap<int, int> map;
+    map.reserve(1000);
+    size_t capacity = map.capacity();
+    for (int i = 0; i < 100000; ++i) {
+        map.emplace(i, i);
+        if (i >= 1000) map.erase(i - 1000);
+    }
+    EXPECT_EQ(map.size(), 1000u);
+    EXPECT_EQ(map.capacity(), capacity);
+    for (int i = 99000; i < 100000; ++i) {
+        EXPECT_EQ(map.find(i)->second, i);
+    }
+}
+
+// 元素被删除、覆盖和清空时都正确析构
+TEST(FlatHashMapTest, ReleasesValues) {
+    auto value = std::make_shared<int>(7);
+    {
+        FlatHashMap<int, std::shared_ptr<int>> map;
+        for (int i = 0; i < 100; ++i) map.emplace(i, value);
+        EXPECT_EQ(value.use_count(), 101);
+        for (int i = 0; i < 50; ++i) map.erase(i);
+        EXPECT_EQ(value.use_count(), 51);
+        map.clear();
+        EXPECT_EQ(value.use_count(), 1);
+        EXPECT_TRUE(map.find(60) == map.end());
+        for (int i = 0; i < 10; ++i) map.emplace(i, value);
+    }
+    EXPECT_EQ(value.use_count(), 1);
+}
+
+// 字符串 key 可以直接用 string_view / const char* 查找
+TEST(FlatHashMapTest, HeterogeneousLookup) {
+    FlatHashMap<std::string, int> map;
+    for (int i = 0; i < 100; ++i) map.emplace("key" + std::to_string(i), i);
+
+    std::string_view view("key42");
+    auto it = findKey(map, view);
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(it->second, 42);
+    EXPECT_EQ(map.count("key7"), 1u);
+    EXPECT_EQ(map.erase(std::string_view("key7")), 1u);
+    EXPECT_EQ(map.count("key7"), 0u);
+}
+
+// 缓存在淘汰频繁时仍然正确：容量远小于 key 空间，每次写入都会淘汰
+TEST(FlatHashMapTest, CachesUnderEvictionChurn) {
+    LruCache<int, int> lru(64);
+    LfuCache<int, int> lfu(64);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 50000; ++i) {
+        int key = static_cast<int>(rng() % 1000);
+        lru.put(key, key * 2);
+        lfu.put(key, key * 2);
+        int value = 0;
+        if (lru.get(key, value)) {
+            EXPECT_EQ(value, key * 2);
+        }
+        if (lfu.get(key, value)) {
+            EXPECT_EQ(value, key * 2);
+        }
+    }
+
+    size_t lruHits = 0;
+    size_t lfuHits = 0;
+    for (int key = 0; key < 1000; ++key) {
+        int value = 0;
+        lruHits += lru.get(key, value);
+        lfuHits += lfu.get(key, value);
+    }
+    EXPECT_LE(lruHits, 64u);
+    EXPECT_LE(lfuHits, 64u);
+    EXPECT_GT(lruHits, 0u);
+}
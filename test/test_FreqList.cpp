@@ -1,5 +1,5 @@
 #include <gtest/gtest.h>
-#include "/home/ubuntu/Cpp-Cache/LfuCache.h"  // 头文件路径
+#include "LfuCache.h"  // 头文件路径
 
 using namespace KamaCache;
 
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "HashLruCache.h"
+
+using namespace KamaCache;
+
+// 测试 HashLruCache 的基本插入和访问功能
+TEST(HashLruCacheTest, BasicOperations) {
+    // 总容量为 4，分成 2 个分片
+    HashLruCache<int, std::string> cache(4, 2);
+    EXPECT_EQ(cache.sliceNum(), 2u);
+
+    cache.put(1, "One");
+    cache.put(2, "Two");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "One");
+    EXPECT_EQ(cache.get(2), "Two");
+
+    cache.remove(1);
+    EXPECT_FALSE(cache.get(1, value));
+}
+
+// 与 HashLruCache 选分片的方式一致：混合后哈希的高 32 位对分片数取模
+static size_t sliceOf(int key, size_t sliceNum) {
+    return static_cast<size_t>(mixHash(static_cast<uint64_t>(std::hash<int>{}(key))) >> 32) % sliceNum;
+}
+
+// 每个分片独立淘汰：一个分片写满只淘汰它自己的 key
+TEST(HashLruCacheTest, PerSliceEviction) {
+    HashLruCache<int, int> cache(4, 2); // 每个分片容量为 2
+
+    std::vector<int> same, other;
+    for (int k = 0; same.size() < 3 || other.empty(); ++k) {
+        if (sliceOf(k, 2) == 0) {
+            if (same.size() < 3) same.push_back(k);
+        } else if (other.empty()) {
+            other.push_back(k);
+        }
+    }
+
+    cache.put(same[0], 0);
+    cache.put(same[1], 1);
+    cache.put(other[0], 2);
+    cache.put(same[2], 3); // 分片 0 已满，淘汰 same[0]
+
+    int value = 0;
+    EXPECT_FALSE(cache.get(same[0], value));
+    EXPECT_TRUE(cache.get(same[1], value));
+    EXPECT_TRUE(cache.get(same[2], value));
+    EXPECT_TRUE(cache.get(other[0], value)); // 另一个分片不受影响
+}
+
+// 步长等于分片数的整数 key 也要均匀分到各个分片，不能只用上其中一个分片的容量
+TEST(HashLruCacheTest, StridedKeysSpreadAcrossSlices) {
+    HashLruCache<uint64_t, uint64_t> cache(1000, 8);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        cache.put(i * 8, i);
+    }
+    size_t kept = 0;
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        if (cache.get(i * 8, value)) ++kept;
+    }
+    // 每个分片容量 125，哈希不可能完全均匀，但绝大部分容量应该用得上
+    EXPECT_GT(kept, 850u);
+}
+
+// 多线程并发读写
+TEST(HashLruCacheTest, ConcurrentAccess) {
+    HashLruCache<int, int> cache(1024, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                int key = t * 1000 + i;
+                cache.put(key, key);
+                int value = -1;
+                if (cache.get(key, value)) {
+                    EXPECT_EQ(value, key);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+}
+
+// 批量接口按分片分组后，结果顺序仍与输入一致
+TEST(HashLruCacheTest, BatchOperations) {
+    HashLruCache<int, int> cache(64, 4);
+    std::vector<int> keys, values;
+    for (int i = 0; i < 32; ++i) {
+        keys.push_back(i);
+        values.push_back(i * 10);
+    }
+    cache.putMany(keys.data(), values.data(), keys.size());
+
+    int lookup[] = {5, 100, 17, 31};
+    int out[4] = {0, 0, 0, 0};
+    bool hits[4];
+    EXPECT_EQ(cache.getMany(lookup, 4, out, hits), 3u);
+    EXPECT_TRUE(hits[0]);
+    EXPECT_FALSE(hits[1]);
+    EXPECT_EQ(out[0], 50);
+    EXPECT_EQ(out[2], 170);
+    EXPECT_EQ(out[3], 310);
+}
+
+// 同一批里重复的 key 按输入顺序写入，最后一次生效；监听器里再次调用批量接口也不会弄乱外层的分组
+TEST(HashLruCacheTest, BatchDuplicatesAndReentrantListener) {
+    HashLruCache<int, int> cache(8, 4);
+    std::vector<int> keys, values;
+    for (int i = 0; i < 200; ++i) {
+        keys.push_back(i % 50);
+        values.push_back(i);
+    }
+    int reentered = 0;
+    cache.setRemovalListener([&cache, &reentered](std::vector<RemovalNotification<int, int>>& batch) {
+        int probe[3] = {1, 2, 3};
+        int out[3];
+        bool hits[3];
+        reentered += static_cast<int>(batch.size());
+        cache.getMany(probe, 3, out, hits);
+    });
+    cache.putMany(keys.data(), values.data(), keys.size());
+    EXPECT_GT(reentered, 0);
+
+    std::vector<int> out(keys.size(), -1);
+    std::unique_ptr<bool[]> hits(new bool[keys.size()]);
+    cache.getMany(keys.data(), keys.size(), out.data(), hits.get());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (hits[i]) {
+            EXPECT_EQ(out[i], 150 + keys[i]) << i;
+        }
+    }
+}
+
+// 按权重限制容量：总权重均分到各个分片
+TEST(HashLruCacheTest, WeightBoundedCapacity) {
+    HashLruCache<int, std::string> cache(20, [](const int&, const std::string& v) { return v.size(); }, 2);
+    for (int i = 0; i < 100; ++i) {
+        cache.put(i, "abc");
+    }
+    EXPECT_LE(cache.totalWeight(), 20u);
+    EXPECT_GT(cache.totalWeight(), 0u);
+}
+
+// 单个条目的上限是一个分片的预算：比 sliceWeight() 重的条目被拒绝，即使它放得进总预算
+TEST(HashLruCacheTest, EntryHeavierThanSliceIsRejected) {
+    HashLruCache<int, std::string> cache(20, [](const int&, const std::string& v) { return v.size(); }, 4);
+    EXPECT_EQ(cache.sliceWeight(), 5u);
+    cache.put(1, std::string(5, 'a'));
+    cache.put(2, std::string(6, 'b'));
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_FALSE(cache.get(2, value));
+}
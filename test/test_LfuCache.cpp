@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+#include "LfuCache.h"
+
+using namespace KamaCache;
+
+// 测试 LfuCache 的基本插入、访问和按频次淘汰
+TEST(LfuCacheTest, BasicOperations) {
+    LfuCache<int, std::string> cache(2);
+
+    cache.put(1, "One");
+    cache.put(2, "Two");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value)); // key 1 频次变为 2
+    EXPECT_EQ(value, "One");
+
+    cache.put(3, "Three"); // 淘汰频次最低的 key 2
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(cache.get(3), "Three");
+}
+
+// 老化：曾经的热点长期不被访问后，频次会衰减并最终被淘汰
+TEST(LfuCacheTest, AgingDecaysOldHotKeys) {
+    LfuCache<int, int> cache(3, 4);
+    int value = 0;
+
+    cache.put(1, 1);
+    for (int i = 0; i < 50; ++i) cache.get(1, value);
+
+    cache.put(2, 2);
+    cache.put(3, 3);
+    for (int i = 0; i < 200; ++i) {
+        cache.get(2, value);
+        cache.get(3, value);
+    }
+
+    // 没有老化时 key 1 频次最高，会保留；老化后它的有效频次最低
+    cache.put(4, 4);
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_TRUE(cache.get(4, value));
+}
+
+// 老化之后新插入的节点仍然按频次参与淘汰
+TEST(LfuCacheTest, EvictionAfterAging) {
+    LfuCache<int, int> cache(2, 2);
+    int value = 0;
+    for (int round = 0; round < 100; ++round) {
+        cache.put(round, round);
+        EXPECT_TRUE(cache.get(round, value));
+        EXPECT_EQ(value, round);
+    }
+    EXPECT_TRUE(cache.get(99, value));
+    EXPECT_FALSE(cache.get(0, value));
+}
+
+// 随机操作下与一个朴素的 LFU 模型对比（关闭老化）：
+// 淘汰频次最小的节点，同频次时淘汰最早进入该频次的节点
+TEST(LfuCacheTest, MatchesReferenceModel) {
+    const int capacity = 16;
+    LfuCache<int, int> cache(capacity, 1 << 30);
+    std::map<int, std::pair<long, long>> model; // key -> (频次, 进入该频次的序号)
+    long seq = 0;
+    unsigned rng = 12345;
+
+    for (int i = 0; i < 20000; ++i) {
+        rng = rng * 1103515245 + 12345;
+        int key = (rng >> 16) % 40;
+        int value = 0;
+        bool hit = cache.get(key, value);
+        auto it = model.find(key);
+        ASSERT_EQ(hit, it != model.end());
+        if (hit) {
+            EXPECT_EQ(value, key);
+            it->second = {it->second.first + 1, seq++};
+            continue;
+        }
+        if (static_cast<int>(model.size()) == capacity) {
+            auto victim = model.begin();
+            for (auto m = model.begin(); m != model.end(); ++m) {
+                if (m->second < victim->second) victim = m;
+            }
+            model.erase(victim);
+        }
+        cache.put(key, key);
+        model[key] = {1, seq++};
+    }
+}
+
+// 批量接口同样更新访问频次
+TEST(LfuCacheTest, BatchOperations) {
+    LfuCache<int, int> cache(2);
+    int keys[] = {1, 2};
+    int values[] = {10, 20};
+    cache.putMany(keys, values, 2);
+
+    int lookup[] = {1, 1, 3};
+    int out[3];
+    bool hits[3];
+    EXPECT_EQ(cache.getMany(lookup, 3, out, hits), 2u);
+    EXPECT_FALSE(hits[2]);
+    EXPECT_EQ(out[0], 10);
+
+    // key 1 的频次更高，淘汰 key 2
+    cache.put(3, 30);
+    int value = 0;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_FALSE(cache.get(2, value));
+}
+
+// 异构查找、零拷贝读取和原地构造
+TEST(LfuCacheTest, HeterogeneousLookupAndVisit) {
+    LfuCache<std::string, std::string> cache(2);
+    cache.emplace("alpha", 2, 'x');
+    cache.put("beta", "B");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(std::string_view("alpha"), value));
+    EXPECT_EQ(value, "xx");
+
+    // visit 同样增加访问频次：beta 被访问过，淘汰频次更低的 alpha 之外的 key
+    EXPECT_TRUE(cache.visit(std::string_view("beta"), [](const std::string& v) { EXPECT_EQ(v, "B"); }));
+    EXPECT_TRUE(cache.visit(std::string_view("beta"), [](const std::string&) {}));
+    cache.put("gamma", "G"); // alpha 频次 2，beta 频次 3，淘汰 alpha
+    EXPECT_FALSE(cache.get(std::string_view("alpha"), value));
+    EXPECT_TRUE(cache.get(std::string_view("beta"), value));
+}
+
+// TTL：到期的条目被主动回收，频次再高也一样
+TEST(LfuCacheTest, TtlExpiration) {
+    LfuCache<int, int> cache(2);
+    cache.put(1, 1, std::chrono::milliseconds(20));
+    int value = 0;
+    for (int i = 0; i < 5; ++i) cache.get(1, value);
+    cache.put(2, 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(cache.purgeExpired(), 1u);
+    EXPECT_FALSE(cache.get(1, value));
+
+    // 空出来的位置可以直接使用，不淘汰 key 2
+    cache.put(3, 3);
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(3, value));
+
+    // 重新 put 带新的 TTL：旧的到期记录不会误删新条目
+    cache.put(3, 30, std::chrono::milliseconds(20));
+    cache.put(3, 31, std::chrono::hours(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(cache.purgeExpired(), 0u);
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_EQ(value, 31);
+}
+
+// 反复用 TTL 覆盖同一批 key：时间轮里的记录数不超过条目数；推后的到期时间在旧记录触发后仍然生效
+TEST(LfuCacheTest, TtlOverwritesKeepWheelBounded) {
+    LfuCache<int, int> cache(10);
+    for (int i = 0; i < 10000; ++i) {
+        cache.put(i % 5, i, std::chrono::hours(1));
+    }
+    EXPECT_LE(cache.scheduledExpirations(), 5u);
+
+    cache.put(100, 1, std::chrono::milliseconds(20));
+    cache.put(100, 2, std::chrono::milliseconds(200));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(cache.purgeExpired(), 0u); // 20ms 的记录触发时按 200ms 放回去
+    int value = 0;
+    EXPECT_TRUE(cache.get(100, value));
+    EXPECT_EQ(value, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_EQ(cache.purgeExpired(), 1u);
+}
+
+// 按权重限制容量：淘汰频次最低的数据直到放得下，超过总容量的条目被拒绝
+TEST(LfuCacheTest, WeightBoundedCapacity) {
+    LfuCache<int, std::string> cache(10, [](const int&, const std::string& v) { return v.size(); });
+
+    cache.put(1, "aaaa");
+    cache.put(2, "bbbb");
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value)); // 1 的频次更高
+    EXPECT_EQ(cache.totalWeight(), 8u);
+
+    cache.put(3, "cccc");
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_EQ(cache.totalWeight(), 8u);
+
+    cache.put(4, std::string(11, 'd'));
+    EXPECT_FALSE(cache.get(4, value));
+    EXPECT_EQ(cache.totalWeight(), 8u);
+
+    cache.put(1, std::string(11, 'a'));
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.totalWeight(), 4u);
+}
+
+// 覆盖成更重的值：被更新的条目即使频次最低也保留，淘汰的是其他条目
+TEST(LfuCacheTest, HeavierUpdateKeepsUpdatedEntry) {
+    LfuCache<int, int> cache(10, [](const int&, const int& v) { return static_cast<size_t>(v); });
+    std::vector<RemovalNotification<int, int>> seen;
+    cache.setRemovalListener([&](std::vector<RemovalNotification<int, int>>& batch) {
+        seen.insert(seen.end(), batch.begin(), batch.end());
+    });
+
+    cache.put(1, 1);
+    cache.put(2, 1);
+    int value = 0;
+    for (int i = 0; i < 5; ++i) EXPECT_TRUE(cache.get(2, value)); // 2 的频次远高于 1
+
+    cache.put(1, 10);
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, 10);
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_EQ(cache.totalWeight(), 10u);
+
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen[0].key, 1);
+    EXPECT_EQ(seen[0].cause, RemovalCause::Replaced);
+    EXPECT_EQ(seen[1].key, 2);
+    EXPECT_EQ(seen[1].cause, RemovalCause::Evicted);
+}
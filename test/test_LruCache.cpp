@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
-#include "/home/ubuntu/Cpp-Cache/LruCache.h" // 包含你的 LruCache 头文件
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "LruCache.h" // 包含你的 LruCache 头文件
 
 using namespace KamaCache;
 
@@ -27,3 +32,206 @@ TEST(LruCacheTest, BasicOperations) {
     EXPECT_TRUE(cache.get(3, value));  // Key 3 应该存在
     EXPECT_EQ(value, "Three");
 }
+
+// 测试批量接口：getMany 命中位图和 putMany 的淘汰顺序与逐个调用一致
+TEST(LruCacheTest, BatchOperations) {
+    LruCache<int, std::string> cache(3);
+
+    int keys[] = {1, 2, 3};
+    std::string values[] = {"One", "Two", "Three"};
+    cache.putMany(keys, values, 3);
+
+    int lookup[] = {3, 4, 1};
+    std::string out[3];
+    bool hits[3];
+    EXPECT_EQ(cache.getMany(lookup, 3, out, hits), 2u);
+    EXPECT_TRUE(hits[0]);
+    EXPECT_FALSE(hits[1]);
+    EXPECT_TRUE(hits[2]);
+    EXPECT_EQ(out[0], "Three");
+    EXPECT_EQ(out[2], "One");
+
+    // key 2 是最久未使用的
+    int more[] = {4};
+    std::string moreValues[] = {"Four"};
+    cache.putMany(more, moreValues, 1);
+    std::string value;
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(4, value));
+}
+
+// 异构查找、零拷贝读取和原地构造
+TEST(LruCacheTest, HeterogeneousLookupAndVisit) {
+    LruCache<std::string, std::string> cache(2);
+    cache.emplace("alpha", 3, 'a'); // value 原地构造为 "aaa"
+    cache.put("beta", "B");
+
+    std::string value;
+    std::string_view key = "alpha";
+    EXPECT_TRUE(cache.get(key, value)); // 用 string_view 查找 std::string key
+    EXPECT_EQ(value, "aaa");
+
+    size_t length = 0;
+    EXPECT_TRUE(cache.visit(std::string_view("beta"), [&length](const std::string& v) {
+        length = v.size();
+    }));
+    EXPECT_EQ(length, 1u);
+    EXPECT_FALSE(cache.visit("gamma", [](const std::string&) {}));
+
+    // 通过基类接口调用 visit
+    KICachePolicy<std::string, std::string>& policy = cache;
+    std::string seen;
+    EXPECT_TRUE(policy.visit("alpha", [&seen](const std::string& v) { seen = v; }));
+    EXPECT_EQ(seen, "aaa");
+}
+
+// 默认不开启统计：stats() 返回全零快照
+TEST(LruCacheTest, StatsDisabledByDefault) {
+    EXPECT_FALSE(kStatsEnabled);
+    LruCache<int, int> cache(2);
+    int value = 0;
+    cache.put(1, 1);
+    cache.get(1, value);
+    EXPECT_EQ(cache.stats().hits, 0u);
+    EXPECT_EQ(cache.stats().getLatency.count(), 0u);
+}
+
+// TTL：到期的条目被主动回收，不再占用容量；不带 TTL 的 put 会取消过期
+TEST(LruCacheTest, TtlExpiration) {
+    LruCache<int, std::string> cache(3);
+    cache.put(1, "One", std::chrono::milliseconds(20));
+    cache.put(2, "Two", std::chrono::milliseconds(20));
+    cache.put(3, "Three");
+    cache.put(2, "Two");  // 改回不过期
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(3, value));
+
+    // key 1 已经被回收，插入新数据不会淘汰 key 2、3
+    cache.put(4, "Four");
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_TRUE(cache.get(4, value));
+}
+
+// 维护接口一次批量回收所有到期条目
+TEST(LruCacheTest, PurgeExpired) {
+    LruCache<int, int> cache(100);
+    for (int i = 0; i < 50; ++i) {
+        cache.put(i, i, std::chrono::milliseconds(10));
+    }
+    cache.put(100, 100, std::chrono::hours(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_EQ(cache.purgeExpired(), 50u);
+    EXPECT_EQ(cache.purgeExpired(), 0u);
+
+    int value = 0;
+    EXPECT_TRUE(cache.get(100, value));
+}
+
+// 反复用 TTL 覆盖同一批 key：时间轮里的记录数不超过条目数；推后的到期时间在旧记录触发后仍然生效
+TEST(LruCacheTest, TtlOverwritesKeepWheelBounded) {
+    LruCache<int, int> cache(10);
+    for (int i = 0; i < 10000; ++i) {
+        cache.put(i % 5, i, std::chrono::hours(1));
+    }
+    EXPECT_LE(cache.scheduledExpirations(), 5u);
+
+    cache.put(100, 1, std::chrono::milliseconds(20));
+    cache.put(100, 2, std::chrono::milliseconds(200));
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    int value = 0;
+    EXPECT_TRUE(cache.get(100, value)); // 20ms 的记录触发时按 200ms 放回去
+    EXPECT_EQ(value, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_FALSE(cache.get(100, value));
+}
+
+// 按权重限制容量：淘汰到放得下为止，超过总容量的条目被拒绝
+TEST(LruCacheTest, WeightBoundedCapacity) {
+    LruCache<int, std::string> cache(10, [](const int&, const std::string& v) { return v.size(); });
+
+    cache.put(1, "aaaa");
+    cache.put(2, "bbbb");
+    EXPECT_EQ(cache.totalWeight(), 8u);
+
+    // 需要 6：只淘汰最久未使用的 1 就放得下（8 - 4 + 6 = 10），2 保留
+    cache.put(3, "cccccc");
+    std::string value;
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_EQ(cache.totalWeight(), 10u);
+
+    // 比整个缓存还重：不写入，也不淘汰已有数据
+    cache.put(4, std::string(11, 'd'));
+    EXPECT_FALSE(cache.get(4, value));
+    EXPECT_EQ(cache.totalWeight(), 10u);
+
+    // 覆盖成更重的值：淘汰其他数据腾出空间
+    cache.put(3, "cccccccc");
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_EQ(cache.totalWeight(), 8u);
+
+    // 覆盖成超重的值：旧值也被删除
+    cache.put(3, std::string(11, 'c'));
+    EXPECT_FALSE(cache.get(3, value));
+    EXPECT_EQ(cache.totalWeight(), 0u);
+}
+
+// replace 只替换已存在的条目，不改变 LRU 顺序
+TEST(LruCacheTest, ReplaceOnlyIfPresent) {
+    LruCache<int, std::string> cache(2);
+    EXPECT_FALSE(cache.replace(1, "one"));
+    std::string value;
+    EXPECT_FALSE(cache.get(1, value));
+
+    cache.put(1, "one");
+    cache.put(2, "two");
+    EXPECT_TRUE(cache.replace(1, "uno"));
+    cache.put(3, "three"); // 1 仍然是最久未使用的
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_TRUE(cache.replace(2, "dos"));
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_EQ(value, "dos");
+}
+
+// 按需填充回放一遍 key 序列（和 trace_sim 一样：get 未命中就 put），返回三次中最快的一次
+static double replaySeconds(const std::vector<uint64_t>& keys) {
+    double best = 1e9;
+    for (int round = 0; round < 3; ++round) {
+        LruCache<uint64_t, uint64_t> cache(static_cast<int>(keys.size() / 2));
+        auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < 2; ++pass) {
+            for (uint64_t key : keys) {
+                uint64_t value;
+                if (!cache.get(key, value)) cache.put(key, key);
+            }
+        }
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+// SHARDS 采样留下的 key 在索引里仍然均匀分布：每次访问不比未采样的 key 慢。
+// 采样和索引用到哈希的同一段位时，被采样的 key 挤在少数几个桶上，回放慢上百倍
+TEST(LruCacheTest, SampledKeysReplayNoSlower) {
+    const size_t n = 10000;
+    const uint64_t threshold = kSampleModulus / 1000; // 采样率 0.001
+    std::vector<uint64_t> sampled, unsampled;
+    for (uint64_t key = 0; sampled.size() < n; ++key) {
+        if (sampledHash(mixHash(key), threshold)) sampled.push_back(key);
+    }
+    for (uint64_t key = 0; key < n; ++key) unsampled.push_back(key);
+
+    double sampledTime = replaySeconds(sampled);
+    double unsampledTime = replaySeconds(unsampled);
+    // 两组 key 个数相同；放宽到 3 倍，只挡住分布退化，不受计时抖动影响
+    EXPECT_LT(sampledTime, unsampledTime * 3) << sampledTime << "s vs " << unsampledTime << "s";
+}
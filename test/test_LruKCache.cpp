@@ -1,5 +1,5 @@
 #include <gtest/gtest.h>
-#include "/home/ubuntu/Cpp-Cache/LruKCache.h"
+#include "LruKCache.h"
 
 using namespace KamaCache;
 
@@ -12,21 +12,55 @@ TEST(LruKCacheTest, BasicOperations) {
     cache.put(2, "Two");
 
     std::string value;
-    EXPECT_FALSE(cache.get(1, value)); // 尚未满足 k 次访问，主缓存中没有数据
+    // 只 put 过一次，尚未满足 k 次访问，主缓存中没有数据
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.historySize(), 2u);
 
-    // 多次访问 key=1，满足 k 次访问条件
-    cache.get(1);
-    cache.get(1);
+    // 第 2 次访问满足 k 次访问条件，直接用 put 时暂存的值晋升到主缓存
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "One");
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.historySize(), 1u);
 
-    // 调试信息
-    std::cout << "After accessing key 1 twice, cache state: \n";
+    cache.get(1);
     EXPECT_TRUE(cache.get(1, value));
-    std::cout << "Key 1 value: " << value << "\n";
+    EXPECT_EQ(value, "One");
 
-    // 插入更多数据，触发缓存淘汰策略
+    // 插入更多数据，第 2 次访问后同样进入主缓存
     cache.put(3, "Three");
-    EXPECT_TRUE(cache.get(3, value));  // 添加调试信息
-    std::cout << "Key 3 value: " << value << "\n";
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_EQ(value, "Three");
+}
+
+// 只被 get 过、从没 put 过的 key 没有值，达到 k 次也不会进入主缓存
+TEST(LruKCacheTest, GetOnlyKeyIsNotPromoted) {
+    LruKCache<int, std::string> cache(2, 3, 2);
+
+    std::string value;
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.size(), 0u);
+
+    // 之后的 put 会带上累计的访问次数，直接进入主缓存
+    cache.put(1, "One");
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "One");
+}
+
+// 主缓存满时淘汰最久未使用的常驻数据，历史记录不受影响
+TEST(LruKCacheTest, ResidentEviction) {
+    LruKCache<int, int> cache(2, 4, 2);
+    for (int key = 1; key <= 3; ++key) {
+        cache.put(key, key * 10);
+        cache.put(key, key * 10);
+    }
+
+    int value = 0;
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_FALSE(cache.get(1, value)); // 1 是最久未使用的常驻数据，已被淘汰
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_EQ(value, 30);
 }
 
 // 测试历史记录的容量限制
@@ -42,3 +76,78 @@ TEST(LruKCacheTest, HistoryCapacityLimit) {
     std::string value;
     EXPECT_FALSE(cache.get(1, value));
 }
+
+// 主缓存按权重限制容量，历史记录仍按个数限制
+TEST(LruKCacheTest, WeightBoundedCapacity) {
+    LruKCache<int, std::string> cache(10, 10, 2, [](const int&, const std::string& v) { return v.size(); });
+    std::string value;
+
+    cache.put(1, "aaaa");
+    cache.put(1, "aaaa");
+    cache.put(2, "bbbb");
+    cache.put(2, "bbbb");
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.totalWeight(), 8u);
+
+    // 晋升需要 6：淘汰最久未使用的 1
+    cache.put(3, "cccccc");
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_EQ(value, "cccccc");
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.totalWeight(), 10u);
+
+    // 超重的值不能晋升，主缓存不受影响
+    cache.put(4, std::string(11, 'd'));
+    cache.put(4, std::string(11, 'd'));
+    EXPECT_FALSE(cache.get(4, value));
+    EXPECT_EQ(cache.totalWeight(), 10u);
+}
+
+// 历史记录里暂存的值也按权重计入预算：超出时挤掉最旧的历史节点，比预算还重的值不暂存
+TEST(LruKCacheTest, StashedValuesAreWeighed) {
+    LruKCache<int, std::string> cache(10, 100, 2, [](const int&, const std::string& v) { return v.size(); });
+    std::string value;
+
+    cache.put(1, "aaaa");
+    cache.put(2, "bbbb");
+    EXPECT_EQ(cache.historyWeight(), 8u);
+    cache.put(3, "cccc"); // 超出预算：挤掉最旧的 1
+    EXPECT_EQ(cache.historyWeight(), 8u);
+    EXPECT_EQ(cache.historySize(), 2u);
+    EXPECT_FALSE(cache.get(1, value)); // 1 只剩这一次访问的记录，没有值可以晋升
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_EQ(value, "bbbb");
+    EXPECT_EQ(cache.historyWeight(), 4u); // 2 晋升后不再计入历史预算
+
+    // 比整个预算还重：只记访问次数，不暂存
+    cache.put(5, std::string(11, 'e'));
+    EXPECT_EQ(cache.historyWeight(), 4u);
+    EXPECT_FALSE(cache.get(5, value));
+
+    // 重新暂存同一个 key 时按新值计重
+    cache.put(3, "cc");
+    EXPECT_EQ(cache.size(), 2u); // 第 2 次访问：3 直接晋升
+    EXPECT_EQ(cache.historyWeight(), 0u);
+
+    // 大量只 put 一次的重值：暂存的总权重始终不超过预算
+    for (int i = 100; i < 200; ++i) {
+        cache.put(i, std::string(3, 'x'));
+        EXPECT_LE(cache.historyWeight(), 10u);
+    }
+}
+
+// getOrPut：未命中后的填充和这次访问合起来只算一次
+TEST(LruKCacheTest, GetOrPutCountsOneAccess) {
+    LruKCache<int, std::string> cache(2, 4, 2);
+    std::string value = "One";
+    EXPECT_FALSE(cache.getOrPut(1, value)); // 第 1 次访问，值暂存进历史记录
+    EXPECT_EQ(cache.size(), 0u);
+
+    value = "ignored";
+    EXPECT_FALSE(cache.getOrPut(1, value)); // 第 2 次访问，晋升（值来自调用者，仍算未命中）
+    EXPECT_EQ(cache.size(), 1u);
+
+    value.clear();
+    EXPECT_TRUE(cache.getOrPut(1, value));
+    EXPECT_EQ(value, "ignored");
+}
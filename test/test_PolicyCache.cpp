@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "LruCache.h"
+#include "PolicyCache.h"
+#include "SingleFlight.h"
+
+using namespace KamaCache;
+
+using LocalLru = PolicyCache<int, int, LruEviction, NoLock, KeyHash<int>, std::allocator<int>, NoStats>;
+
+// 单线程组合：没有虚函数表，锁是空类型
+static_assert(!std::is_polymorphic<LocalLru>::value, "PolicyCache must not have a vtable");
+static_assert(std::is_empty<NoLock::Mutex>::value, "NoLock should not take any space");
+
+// 统计分配次数的分配器
+static std::atomic<int> gNodeAllocations{0};
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        ++gNodeAllocations;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+TEST(PolicyCacheTest, PutGetUpdateRemove) {
+    PolicyCache<std::string, int> cache(10);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    int value = 0;
+    EXPECT_TRUE(cache.get("a", value));
+    EXPECT_EQ(value, 1);
+    EXPECT_EQ(cache.get("b"), 2);
+    EXPECT_FALSE(cache.get("c", value));
+
+    cache.put("a", 11);
+    EXPECT_EQ(cache.get("a"), 11);
+    EXPECT_EQ(cache.size(), 2u);
+
+    cache.remove("a");
+    EXPECT_FALSE(cache.get("a", value));
+    EXPECT_EQ(cache.size(), 1u);
+
+    // 透明查找：用 const char* 查 std::string 的 key
+    EXPECT_TRUE(cache.visit("b", [](const int& v) { EXPECT_EQ(v, 2); }));
+}
+
+TEST(PolicyCacheTest, ZeroCapacity) {
+    LocalLru cache(0);
+    cache.put(1, 1);
+    int value = 0;
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+// LRU 组合和 LruCache 的淘汰顺序完全一致
+TEST(PolicyCacheTest, LruMatchesLruCache) {
+    LocalLru cache(100);
+    LruCache<int, int> reference(100);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 300);
+    for (int i = 0; i < 20000; ++i) {
+        int key = dist(rng);
+        int a = 0;
+        int b = 0;
+        bool hitA = cache.get(key, a);
+        bool hitB = reference.get(key, b);
+        ASSERT_EQ(hitA, hitB) << "op " << i;
+        if (hitA) {
+            ASSERT_EQ(a, b);
+        } else {
+            cache.put(key, key * 2);
+            reference.put(key, key * 2);
+        }
+    }
+}
+
+// CLOCK：被访问过的条目得到第二次机会
+TEST(PolicyCacheTest, ClockKeepsReferencedEntries) {
+    PolicyCache<int, int, ClockEviction, NoLock> cache(8);
+    for (int key = 0; key < 8; ++key) cache.put(key, key);
+    int value = 0;
+    for (int key = 0; key < 4; ++key) EXPECT_TRUE(cache.get(key, value));
+
+    for (int key = 100; key < 104; ++key) cache.put(key, key);
+
+    for (int key = 0; key < 4; ++key) EXPECT_TRUE(cache.get(key, value)) << key;
+    for (int key = 4; key < 8; ++key) EXPECT_FALSE(cache.get(key, value)) << key;
+    for (int key = 100; key < 104; ++key) EXPECT_TRUE(cache.get(key, value)) << key;
+}
+
+// 缓存满了以后被淘汰的节点原地复用，不再分配
+TEST(PolicyCacheTest, ReusesEvictedNodes) {
+    PolicyCache<int, int, LruEviction, NoLock, KeyHash<int>, CountingAllocator<int>> cache(64);
+    for (int key = 0; key < 64; ++key) cache.put(key, key);
+    int allocations = gNodeAllocations.load();
+    for (int key = 64; key < 10000; ++key) cache.put(key, key);
+    EXPECT_EQ(gNodeAllocations.load(), allocations);
+    EXPECT_EQ(cache.size(), 64u);
+}
+
+// 分片：每个分片的容量是总容量的 1/N
+TEST(PolicyCacheTest, StripedStaysWithinCapacity) {
+    PolicyCache<uint64_t, uint64_t, LruEviction, StripedLock<8>> cache(800);
+    for (uint64_t key = 0; key < 100000; ++key) cache.put(key, key);
+    EXPECT_LE(cache.size(), 800u);
+    EXPECT_GT(cache.size(), 700u);
+    uint64_t value = 0;
+    EXPECT_TRUE(cache.get(99999, value));
+    EXPECT_EQ(value, 99999u);
+}
+
+// 通过 KICachePolicy 接口使用，包括经由 getOrLoad 读穿
+TEST(PolicyCacheTest, AdapterThroughInterface) {
+    PolicyCacheAdapter<PolicyCache<int, std::string>> adapter(4);
+    KICachePolicy<int, std::string>& cache = adapter;
+    cache.put(1, "one");
+    EXPECT_EQ(cache.get(1), "one");
+    SingleFlight<int, std::string> flight;
+    int loads = 0;
+    EXPECT_EQ(getOrLoad(cache, flight, 2, [&loads](const int&) { ++loads; return std::string("two"); }), "two");
+    EXPECT_EQ(getOrLoad(cache, flight, 2, [&loads](const int&) { ++loads; return std::string("two"); }), "two");
+    EXPECT_EQ(loads, 1);
+    EXPECT_EQ(adapter.cache().size(), 2u);
+}
+
+template <typename Cache>
+void runConcurrent(Cache& cache) {
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, &wrong, t]() {
+            for (uint64_t i = 0; i < 50000; ++i) {
+                uint64_t key = (i * 31 + t) % 1000;
+                if (i % 3 == 0) {
+                    cache.put(key, key * 3);
+                } else {
+                    uint64_t value = 0;
+                    if (cache.get(key, value) && value != key * 3) ++wrong;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(wrong.load(), 0);
+    EXPECT_LE(cache.size(), cache.capacity());
+}
+
+TEST(PolicyCacheTest, ConcurrentMutexLru) {
+    PolicyCache<uint64_t, uint64_t, LruEviction, MutexLock> cache(256);
+    runConcurrent(cache);
+}
+
+// CLOCK + 读写锁：get 只拿读锁
+TEST(PolicyCacheTest, ConcurrentSharedClock) {
+    PolicyCache<uint64_t, uint64_t, ClockEviction, SharedMutexLock> cache(256);
+    runConcurrent(cache);
+}
+
+TEST(PolicyCacheTest, ConcurrentStriped) {
+    PolicyCache<uint64_t, uint64_t, ClockEviction, StripedLock<8, SharedMutexLock>> cache(256);
+    runConcurrent(cache);
+}
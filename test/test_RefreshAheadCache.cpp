@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "LfuCache.h"
+#include "RefreshAheadCache.h"
+
+using namespace KamaCache;
+using namespace std::chrono_literals;
+
+// 等待条件成立，最多等 timeout
+template <typename Pred>
+static bool waitFor(Pred pred, std::chrono::milliseconds timeout = 2000ms) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+// 超过刷新阈值的条目被访问时，读者拿到旧值，后台换上新值
+TEST(RefreshAheadCacheTest, StaleHitReturnsOldValueAndRefreshes) {
+    std::atomic<int> version{1};
+    RefreshAheadCache<int, int> cache(16, [&version](const int& key) {
+        return key * 100 + version.load();
+    }, 20ms);
+
+    cache.put(1, 101);
+    int value = 0;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, 101);
+    EXPECT_EQ(cache.refreshes(), 0u); // 还没到阈值
+
+    version = 2;
+    std::this_thread::sleep_for(30ms);
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, 101); // 读者不等待加载
+
+    ASSERT_TRUE(waitFor([&]() { return cache.refreshes() == 1; }));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, 102);
+}
+
+// loader 失败时保留旧值
+TEST(RefreshAheadCacheTest, FailedRefreshKeepsOldValue) {
+    RefreshAheadCache<int, int, LfuCache> cache(16, [](const int&) -> int {
+        throw std::runtime_error("backend down");
+    }, 1ms);
+
+    cache.put(1, 10);
+    std::this_thread::sleep_for(5ms);
+    int value = 0;
+    EXPECT_TRUE(cache.get(1, value));
+    ASSERT_TRUE(waitFor([&]() { return cache.failedRefreshes() == 1; }));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, 10);
+}
+
+// 队列有上限：慢后端时多余的刷新被放弃，同一个 key 不重复排队
+TEST(RefreshAheadCacheTest, BoundedQueueDropsExcessRefreshes) {
+    std::atomic<bool> release{false};
+    std::atomic<int> loads{0};
+    RefreshAheadCache<int, int> cache(64, [&](const int& key) {
+        loads.fetch_add(1);
+        while (!release.load()) std::this_thread::sleep_for(1ms);
+        return key;
+    }, 1ms, 1, 4);
+
+    for (int key = 0; key < 20; ++key) cache.put(key, key);
+    std::this_thread::sleep_for(5ms);
+
+    int value;
+    for (int round = 0; round < 3; ++round) {
+        for (int key = 0; key < 20; ++key) cache.get(key, value);
+    }
+    // 一个在执行，最多四个在排队
+    EXPECT_LE(cache.pendingRefreshes(), 5u);
+    EXPECT_GT(cache.droppedRefreshes(), 0u);
+
+    release = true;
+    ASSERT_TRUE(waitFor([&]() { return cache.pendingRefreshes() == 0; }));
+    EXPECT_LE(loads.load(), 5);
+}
+
+// 刷新期间被删除的 key 不会被刷新结果重新放回缓存
+TEST(RefreshAheadCacheTest, RemovedKeyIsNotResurrected) {
+    std::atomic<bool> release{false};
+    RefreshAheadCache<int, int> cache(16, [&](const int& key) {
+        while (!release.load()) std::this_thread::sleep_for(1ms);
+        return key;
+    }, 1ms);
+
+    cache.put(1, 1);
+    std::this_thread::sleep_for(5ms);
+    int value;
+    EXPECT_TRUE(cache.get(1, value));
+    ASSERT_TRUE(waitFor([&]() { return cache.pendingRefreshes() == 1; }));
+    cache.remove(1);
+    release = true;
+    ASSERT_TRUE(waitFor([&]() { return cache.pendingRefreshes() == 0; }));
+    EXPECT_FALSE(cache.get(1, value));
+}
+
+// 刷新期间 put 了新值（或者删除后重新 put）：加载出来的旧结果不能覆盖它
+template <template <typename, typename> class Cache>
+static void expectPutDuringRefreshWins() {
+    std::atomic<bool> release{false};
+    RefreshAheadCache<int, int, Cache> cache(16, [&](const int& key) {
+        while (!release.load()) std::this_thread::sleep_for(1ms);
+        return key * 100;
+    }, 50ms, 1);
+
+    cache.put(1, 1);
+    cache.put(2, 2);
+    std::this_thread::sleep_for(60ms);
+    int value = 0;
+    EXPECT_TRUE(cache.get(1, value));
+    ASSERT_TRUE(waitFor([&]() { return cache.pendingRefreshes() == 1; }));
+    cache.put(1, 11);
+    release = true;
+    ASSERT_TRUE(waitFor([&]() { return cache.pendingRefreshes() == 0; }));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, 11);
+    EXPECT_EQ(cache.refreshes(), 0u);
+
+    release = false;
+    EXPECT_TRUE(cache.get(2, value));
+    ASSERT_TRUE(waitFor([&]() { return cache.pendingRefreshes() == 1; }));
+    cache.remove(2);
+    cache.put(2, 22);
+    release = true;
+    ASSERT_TRUE(waitFor([&]() { return cache.pendingRefreshes() == 0; }));
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_EQ(value, 22);
+    EXPECT_EQ(cache.refreshes(), 0u);
+}
+
+TEST(RefreshAheadCacheTest, PutDuringRefreshWins) {
+    expectPutDuringRefreshWins<LruCache>();
+    expectPutDuringRefreshWins<LfuCache>();
+}
+
+// 后台刷新不算一次访问：不改变 LRU 顺序
+TEST(RefreshAheadCacheTest, RefreshDoesNotTouchEvictionOrder) {
+    std::atomic<bool> release{false};
+    RefreshAheadCache<int, int> cache(2, [&](const int& key) {
+        while (!release.load()) std::this_thread::sleep_for(1ms);
+        return key * 10;
+    }, 50ms, 1);
+
+    cache.put(1, 1);
+    std::this_thread::sleep_for(60ms);
+    cache.put(2, 2);
+    int value = 0;
+    EXPECT_TRUE(cache.get(1, value)); // 1 过时，安排刷新
+    EXPECT_TRUE(cache.get(2, value)); // 2 成为最近访问的
+    release = true;
+    ASSERT_TRUE(waitFor([&]() { return cache.refreshes() == 1; }));
+
+    cache.put(3, 3); // 最久未访问的仍然是 1
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_EQ(value, 2);
+}
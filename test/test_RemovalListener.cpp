@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ArcCache.h"
+#include "BufferedLruCache.h"
+#include "HashLruCache.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+#include "LruKCache.h"
+#include "PolicyCache.h"
+#include "RefreshAheadCache.h"
+#include "S3FifoCache.h"
+#include "SetAssocCache.h"
+#include "SlabLruCache.h"
+#include "WTinyLfuCache.h"
+
+using namespace KamaCache;
+
+// 收集监听器收到的通知，可以被多个线程同时调用
+template <typename Key, typename Value>
+struct Recorder {
+    std::mutex mutex;
+    std::vector<RemovalNotification<Key, Value>> seen;
+    std::vector<size_t> batchSizes;
+
+    RemovalListener<Key, Value> listener() {
+        return [this](std::vector<RemovalNotification<Key, Value>>& batch) {
+            std::lock_guard<std::mutex> lock(mutex);
+            batchSizes.push_back(batch.size());
+            for (auto& n : batch) seen.push_back(n);
+        };
+    }
+
+    size_t count(RemovalCause cause) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t total = 0;
+        for (auto& n : seen) total += n.cause == cause;
+        return total;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return seen.size();
+    }
+};
+
+TEST(RemovalListenerTest, LruCacheReportsEveryCause) {
+    LruCache<int, std::string> cache(2);
+    Recorder<int, std::string> recorder;
+    cache.setRemovalListener(recorder.listener());
+
+    cache.put(1, "a");
+    cache.put(2, "b");
+    cache.put(1, "a2");  // 覆盖
+    cache.put(3, "c");   // 淘汰 2
+    cache.remove(1);     // 删除
+    cache.put(4, "d", std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    cache.purgeExpired(); // 过期
+
+    ASSERT_EQ(recorder.seen.size(), 4u);
+    EXPECT_EQ(recorder.seen[0].key, 1);
+    EXPECT_EQ(recorder.seen[0].value, "a");
+    EXPECT_EQ(recorder.seen[0].cause, RemovalCause::Replaced);
+    EXPECT_EQ(recorder.seen[1].key, 2);
+    EXPECT_EQ(recorder.seen[1].cause, RemovalCause::Evicted);
+    EXPECT_EQ(recorder.seen[2].key, 1);
+    EXPECT_EQ(recorder.seen[2].value, "a2");
+    EXPECT_EQ(recorder.seen[2].cause, RemovalCause::Explicit);
+    EXPECT_EQ(recorder.seen[3].key, 4);
+    EXPECT_EQ(recorder.seen[3].cause, RemovalCause::Expired);
+}
+
+// 一次批量写入引起的淘汰只投递一批
+TEST(RemovalListenerTest, BatchesPerOperation) {
+    LruCache<int, int> cache(2);
+    Recorder<int, int> recorder;
+    cache.setRemovalListener(recorder.listener());
+
+    int keys[5] = {1, 2, 3, 4, 5};
+    int values[5] = {10, 20, 30, 40, 50};
+    cache.putMany(keys, values, 5);
+
+    ASSERT_EQ(recorder.batchSizes.size(), 1u);
+    EXPECT_EQ(recorder.batchSizes[0], 3u);
+    EXPECT_EQ(recorder.count(RemovalCause::Evicted), 3u);
+}
+
+// 监听器在缓存锁之外被调用：在监听器里再访问同一个缓存不会死锁
+TEST(RemovalListenerTest, ListenerMayReenterCache) {
+    LruCache<int, int> cache(2);
+    std::vector<int> reinserted;
+    cache.setRemovalListener([&](std::vector<RemovalNotification<int, int>>& batch) {
+        for (auto& n : batch) {
+            int value = 0;
+            EXPECT_FALSE(cache.get(n.key, value));
+            reinserted.push_back(n.key);
+            if (n.key == 1) cache.put(100, n.value); // 监听器里的写入引起的淘汰会投递新的一批
+        }
+    });
+
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(3, 3); // 淘汰 1，监听器写入 100 淘汰 2
+
+    EXPECT_EQ(reinserted, (std::vector<int>{1, 2}));
+    int value = 0;
+    EXPECT_TRUE(cache.get(100, value));
+    EXPECT_EQ(value, 1);
+}
+
+// Background：调用者不等待监听器
+TEST(RemovalListenerTest, BackgroundDeliveryDoesNotBlockCaller) {
+    LruCache<int, int> cache(1);
+    std::atomic<bool> release{false};
+    std::atomic<int> delivered{0};
+    std::thread::id listenerThread;
+    cache.setRemovalListener([&](std::vector<RemovalNotification<int, int>>& batch) {
+        listenerThread = std::this_thread::get_id();
+        while (!release.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        delivered += static_cast<int>(batch.size());
+    }, ListenerDelivery::Background);
+
+    // 监听器一直阻塞，写入仍然全部完成
+    for (int i = 0; i < 100; ++i) cache.put(i, i);
+    release = true;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (delivered.load() < 99 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(delivered.load(), 99);
+    EXPECT_NE(listenerThread, std::this_thread::get_id());
+}
+
+// 取消监听器之后不再通知
+TEST(RemovalListenerTest, ClearingListenerStopsNotifications) {
+    LfuCache<int, int> cache(1);
+    Recorder<int, int> recorder;
+    cache.setRemovalListener(recorder.listener());
+    cache.put(1, 1);
+    cache.put(2, 2);
+    EXPECT_EQ(recorder.size(), 1u);
+
+    cache.setRemovalListener(nullptr);
+    cache.put(3, 3);
+    cache.remove(3);
+    EXPECT_EQ(recorder.size(), 1u);
+}
+
+// 对每种策略：写入 capacity + extra 个不同的 key，淘汰通知的个数等于 extra；覆盖和删除各通知一次
+template <typename Cache>
+void checkPolicy(Cache& cache, int capacity, int extra) {
+    Recorder<int, int> recorder;
+    cache.setRemovalListener(recorder.listener());
+    for (int key = 0; key < capacity + extra; ++key) cache.put(key, key * 10);
+    EXPECT_EQ(recorder.count(RemovalCause::Evicted), static_cast<size_t>(extra));
+
+    int last = capacity + extra - 1;
+    cache.put(last, -1);
+    EXPECT_EQ(recorder.count(RemovalCause::Replaced), 1u);
+    cache.remove(last);
+    ASSERT_EQ(recorder.count(RemovalCause::Explicit), 1u);
+    EXPECT_EQ(recorder.seen.back().key, last);
+    EXPECT_EQ(recorder.seen.back().value, -1);
+
+    // 被淘汰的值和 key 对应
+    for (auto& n : recorder.seen) {
+        if (n.cause == RemovalCause::Evicted) {
+            EXPECT_EQ(n.value, n.key * 10);
+        }
+    }
+    cache.setRemovalListener(nullptr);
+}
+
+TEST(RemovalListenerTest, EveryPolicyReportsRemovals) {
+    { LfuCache<int, int> cache(8); checkPolicy(cache, 8, 5); }
+    { LruKCache<int, int> cache(8, 16, 1); checkPolicy(cache, 8, 5); }
+    { HashLruCache<int, int> cache(8, 1); checkPolicy(cache, 8, 5); }
+    { SlabLruCache<int, int> cache(8); checkPolicy(cache, 8, 5); }
+    { BufferedLruCache<int, int> cache(8); checkPolicy(cache, 8, 5); }
+    { ArcCache<int, int> cache(8); checkPolicy(cache, 8, 5); }
+    { WTinyLfuCache<int, int> cache(8); checkPolicy(cache, 8, 5); }
+    { S3FifoCache<int, int> cache(8); checkPolicy(cache, 8, 5); }
+    { SetAssocCache<int, int, 16> cache(16); checkPolicy(cache, 16, 5); }
+    { PolicyCache<int, int> cache(8); checkPolicy(cache, 8, 5); }
+    { PolicyCache<int, int, ClockEviction, StripedLock<2>> cache(8); checkPolicy(cache, 8, 5); }
+}
+
+// 通过 KICachePolicy 接口设置的监听器同样生效
+TEST(RemovalListenerTest, AdapterForwardsListener) {
+    PolicyCacheAdapter<PolicyCache<int, int>> adapter(2);
+    KICachePolicy<int, int>& cache = adapter;
+    Recorder<int, int> recorder;
+    cache.setRemovalListener(recorder.listener());
+    cache.put(1, 1);
+    cache.put(2, 2);
+    cache.put(3, 3);
+    ASSERT_EQ(recorder.size(), 1u);
+    EXPECT_EQ(recorder.seen[0].key, 1);
+}
+
+// 分片缓存：所有分片的通知经过同一个 notifier，Background 时只有一个通知线程
+TEST(RemovalListenerTest, HashLruCacheBackgroundAcrossSlices) {
+    Recorder<int, int> recorder;
+    std::mutex threadsMutex;
+    std::vector<std::thread::id> threads;
+    {
+        HashLruCache<int, int> cache(16, 4);
+        auto record = recorder.listener();
+        cache.setRemovalListener([&, record](std::vector<RemovalNotification<int, int>>& batch) {
+            {
+                std::lock_guard<std::mutex> lock(threadsMutex);
+                threads.push_back(std::this_thread::get_id());
+            }
+            record(batch);
+        }, ListenerDelivery::Background);
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&cache, t]() {
+                for (int i = 0; i < 1000; ++i) cache.put(t * 1000 + i, i);
+            });
+        }
+        for (auto& writer : writers) writer.join();
+    } // 析构时投递完剩下的通知
+
+    EXPECT_GE(recorder.count(RemovalCause::Evicted), 4000u - 16u);
+    for (auto& id : threads) EXPECT_EQ(id, threads.front());
+}
+
+// RefreshAheadCache 通知的是值本身，不带加载时间
+TEST(RemovalListenerTest, RefreshAheadCacheUnwrapsEntries) {
+    RefreshAheadCache<int, std::string> cache(1, [](const int& key) { return std::to_string(key); },
+                                              std::chrono::milliseconds(60000));
+    Recorder<int, std::string> recorder;
+    cache.setRemovalListener(recorder.listener());
+    cache.put(1, "one");
+    cache.put(2, "two");
+    cache.remove(2);
+
+    ASSERT_EQ(recorder.size(), 2u);
+    EXPECT_EQ(recorder.seen[0].value, "one");
+    EXPECT_EQ(recorder.seen[0].cause, RemovalCause::Evicted);
+    EXPECT_EQ(recorder.seen[1].value, "two");
+    EXPECT_EQ(recorder.seen[1].cause, RemovalCause::Explicit);
+}
+
+// 多线程写入和删除：每个 key 的通知都只出现一次
+TEST(RemovalListenerTest, ConcurrentNotificationsAreComplete) {
+    Recorder<int, int> recorder;
+    {
+        LruCache<int, int> cache(32);
+        cache.setRemovalListener(recorder.listener());
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&cache, t]() {
+                for (int i = 0; i < 2000; ++i) {
+                    int key = t * 2000 + i;
+                    cache.put(key, key);
+                    if (i % 3 == 0) cache.remove(key);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+    }
+    // 缓存析构时不通知剩下的条目：8000 个 key 里最多 32 个没有出现
+    std::vector<int> times(8000, 0);
+    for (auto& n : recorder.seen) ++times[n.key];
+    size_t missing = 0;
+    for (int count : times) {
+        EXPECT_LE(count, 1);
+        missing += count == 0;
+    }
+    EXPECT_LE(missing, 32u);
+}
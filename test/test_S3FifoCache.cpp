@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LruCache.h"
+#include "S3FifoCache.h"
+
+using namespace KamaCache;
+
+TEST(S3FifoCacheTest, PutGetUpdateRemove) {
+    S3FifoCache<int, std::string> cache(10);
+    cache.put(1, "one");
+    cache.put(2, "two");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "one");
+    EXPECT_EQ(cache.get(2), "two");
+    EXPECT_FALSE(cache.get(3, value));
+
+    cache.put(1, "uno");
+    EXPECT_EQ(cache.get(1), "uno");
+    EXPECT_EQ(cache.size(), 2u);
+
+    cache.remove(1);
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.size(), 1u);
+
+    // 删除后重新写入同一个 key
+    cache.put(1, "again");
+    EXPECT_EQ(cache.get(1), "again");
+}
+
+TEST(S3FifoCacheTest, StaysWithinCapacity) {
+    S3FifoCache<int, int> cache(100);
+    for (int key = 0; key < 10000; ++key) {
+        cache.put(key, key);
+        if (key % 7 == 0) cache.remove(key);
+    }
+    EXPECT_LE(cache.size(), 100u);
+    EXPECT_EQ(cache.get(9999), 9999);
+
+    S3FifoCache<int, int> empty(0);
+    empty.put(1, 1);
+    int value = 0;
+    EXPECT_FALSE(empty.get(1, value));
+}
+
+// 只访问一次的扫描在 small 队列里就被淘汰，不会冲掉 main 中的热点数据；LRU 则会全部丢失
+TEST(S3FifoCacheTest, ScanResistance) {
+    S3FifoCache<int, int> s3fifo(100);
+    LruCache<int, int> lru(100);
+    int value = 0;
+    for (int round = 0; round < 3; ++round) {
+        for (int key = 0; key < 50; ++key) {
+            if (!s3fifo.get(key, value)) s3fifo.put(key, key);
+            if (!lru.get(key, value)) lru.put(key, key);
+        }
+    }
+    for (int key = 1000; key < 1500; ++key) {
+        s3fifo.put(key, key);
+        lru.put(key, key);
+    }
+
+    int s3fifoHits = 0;
+    int lruHits = 0;
+    for (int key = 0; key < 50; ++key) {
+        s3fifoHits += s3fifo.get(key, value);
+        lruHits += lru.get(key, value);
+    }
+    EXPECT_EQ(s3fifoHits, 50);
+    EXPECT_EQ(lruHits, 0);
+}
+
+// 刚从 small 淘汰的 key 再次写入时，ghost 让它直接进入 main
+TEST(S3FifoCacheTest, GhostHitGoesToMain) {
+    S3FifoCache<int, int> cache(100); // small 队列 10 个
+    cache.put(-1, -1);
+    for (int key = 0; key < 120; ++key) cache.put(key, key);
+    int value = 0;
+    EXPECT_FALSE(cache.get(-1, value));
+
+    cache.put(-1, -1);
+    // 之后的一次性写入只在 small 中轮转，main 中的 -1 不受影响
+    for (int key = 1000; key < 1500; ++key) cache.put(key, key);
+    EXPECT_TRUE(cache.get(-1, value));
+
+    // 对照：没有进过 ghost 的 key 会被同样的写入冲掉
+    for (int key = 2000; key < 2500; ++key) cache.put(key, key);
+    EXPECT_FALSE(cache.get(1499, value));
+}
+
+TEST(S3FifoCacheTest, ConcurrentAccess) {
+    S3FifoCache<int, int> cache(512, 8);
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, &wrong, t]() {
+            for (int i = 0; i < 50000; ++i) {
+                int key = (i * 13 + t * 7) % 2000;
+                switch (i % 5) {
+                case 0:
+                    cache.put(key, key * 2);
+                    break;
+                case 1:
+                    cache.remove(key);
+                    break;
+                default: {
+                    int value = 0;
+                    if (cache.get(key, value) && value != key * 2) ++wrong;
+                }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(wrong.load(), 0);
+    EXPECT_LE(cache.size(), 512u + 4u);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "SetAssocCache.h"
+
+using namespace KamaCache;
+
+// 编译期选择：小的平凡可拷贝类型用组相联缓存，其他类型退回 LruCache
+static_assert(std::is_same<CompactLruCache<uint64_t, uint64_t>, SetAssocCache<uint64_t, uint64_t>>::value,
+              "POD keys should use SetAssocCache");
+static_assert(std::is_same<CompactLruCache<std::string, int>, LruCache<std::string, int>>::value,
+              "string keys should fall back to LruCache");
+
+TEST(SetAssocCacheTest, PutGetUpdateRemove) {
+    SetAssocCache<uint64_t, uint64_t> cache(100);
+    EXPECT_EQ(cache.capacity(), 112u); // 向上取整到 16 的倍数
+
+    cache.put(1, 10);
+    cache.put(2, 20);
+    uint64_t value = 0;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, 10u);
+    EXPECT_EQ(cache.get(2), 20u);
+    EXPECT_FALSE(cache.get(3, value));
+
+    cache.put(1, 11);
+    EXPECT_EQ(cache.get(1), 11u);
+    EXPECT_EQ(cache.size(), 2u);
+
+    cache.remove(1);
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.size(), 1u);
+
+    bool visited = cache.visit(2, [](const uint64_t& v) { EXPECT_EQ(v, 20u); });
+    EXPECT_TRUE(visited);
+}
+
+TEST(SetAssocCacheTest, ZeroCapacity) {
+    SetAssocCache<int, int> cache(0);
+    cache.put(1, 1);
+    int value = 0;
+    EXPECT_FALSE(cache.get(1, value));
+
+    int keys[2] = {1, 2};
+    int values[2] = {1, 2};
+    bool hits[2] = {true, true};
+    cache.putMany(keys, values, 2);
+    EXPECT_EQ(cache.getMany(keys, 2, values, hits), 0u);
+    EXPECT_FALSE(hits[0]);
+}
+
+// 写入远多于容量的 key：条目数不超过容量，最近写入的 key 都能找到
+TEST(SetAssocCacheTest, StaysWithinCapacity) {
+    SetAssocCache<uint64_t, uint64_t, 8> cache(1000);
+    for (uint64_t key = 0; key < 100000; ++key) {
+        cache.put(key, key * 2);
+    }
+    EXPECT_LE(cache.size(), cache.capacity());
+    // 哈希均匀时绝大多数组都是满的
+    EXPECT_GT(cache.size(), cache.capacity() * 9 / 10);
+
+    uint64_t value = 0;
+    EXPECT_TRUE(cache.get(99999, value));
+    EXPECT_EQ(value, 99999u * 2);
+}
+
+// CLOCK：组满时先淘汰访问位为 0 的路，被访问过的条目得到第二次机会
+TEST(SetAssocCacheTest, ClockKeepsReferencedEntries) {
+    SetAssocCache<int, int, 8> cache(8); // 只有一个组
+    for (int key = 0; key < 8; ++key) cache.put(key, key);
+    int value = 0;
+    for (int key = 0; key < 4; ++key) EXPECT_TRUE(cache.get(key, value));
+
+    for (int key = 100; key < 104; ++key) cache.put(key, key);
+
+    for (int key = 0; key < 4; ++key) EXPECT_TRUE(cache.get(key, value)) << key;
+    for (int key = 4; key < 8; ++key) EXPECT_FALSE(cache.get(key, value)) << key;
+    for (int key = 100; key < 104; ++key) EXPECT_TRUE(cache.get(key, value)) << key;
+}
+
+TEST(SetAssocCacheTest, BatchOperations) {
+    SetAssocCache<uint64_t, uint64_t> cache(1024);
+    std::vector<uint64_t> keys(100);
+    std::vector<uint64_t> values(100);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        keys[i] = i * 7;
+        values[i] = i;
+    }
+    cache.putMany(keys.data(), values.data(), keys.size());
+
+    keys.push_back(1000001); // 未命中的 key
+    std::vector<uint64_t> out(keys.size());
+    std::unique_ptr<bool[]> hits(new bool[keys.size()]);
+    EXPECT_EQ(cache.getMany(keys.data(), keys.size(), out.data(), hits.get()), 100u);
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_TRUE(hits[i]);
+        EXPECT_EQ(out[i], i);
+    }
+    EXPECT_FALSE(hits[100]);
+}
+
+// 多线程读写：同一组上的操作由组锁串行化，读到的值总是完整写入的值
+TEST(SetAssocCacheTest, ConcurrentAccess) {
+    SetAssocCache<uint64_t, uint64_t> cache(256);
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, &wrong, t]() {
+            for (uint64_t i = 0; i < 50000; ++i) {
+                uint64_t key = (i * 31 + t) % 1000;
+                if (i % 3 == 0) {
+                    cache.put(key, key * 3);
+                } else if (i % 1000 == 1) {
+                    if (cache.size() > cache.capacity()) ++wrong; // 和写入并发统计条目数
+                } else {
+                    uint64_t value = 0;
+                    if (cache.get(key, value) && value != key * 3) ++wrong;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(wrong.load(), 0);
+    EXPECT_LE(cache.size(), cache.capacity());
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "ArcCache.h"
+#include "HashLruCache.h"
+#include "LfuCache.h"
+#include "LruCache.h"
+#include "LruKCache.h"
+#include "SingleFlight.h"
+#include "WTinyLfuCache.h"
+
+using namespace KamaCache;
+
+// 多个线程同时对同一批 key 调用 getOrLoad：每个 key 只应该调用一次后端
+static void expectOneLoadPerKey(KICachePolicy<int, int>& cache) {
+    const int kKeys = 8;
+    const int kThreads = 16;
+    std::vector<std::atomic<int>> loads(kKeys);
+    std::atomic<int> wrong{0};
+    SingleFlight<int, int> flight;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&]() {
+            for (int key = 0; key < kKeys; ++key) {
+                int value = getOrLoad(cache, flight, key, [&loads](const int& k) {
+                    loads[k].fetch_add(1);
+                    // 慢后端：让其他线程在加载期间到达
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    return k * 10;
+                });
+                if (value != key * 10) wrong.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(wrong.load(), 0);
+    for (int key = 0; key < kKeys; ++key) {
+        EXPECT_EQ(loads[key].load(), 1) << "key " << key;
+    }
+}
+
+TEST(SingleFlightTest, OneLoadPerKeyForEveryPolicy) {
+    LruCache<int, int> lru(64);
+    expectOneLoadPerKey(lru);
+
+    HashLruCache<int, int> hashLru(64, 4);
+    expectOneLoadPerKey(hashLru);
+
+    LfuCache<int, int> lfu(64);
+    expectOneLoadPerKey(lfu);
+
+    ArcCache<int, int> arc(64);
+    expectOneLoadPerKey(arc);
+
+    WTinyLfuCache<int, int> tinyLfu(64);
+    expectOneLoadPerKey(tinyLfu);
+
+    LruKCache<int, int> lruK(64, 64, 1);
+    expectOneLoadPerKey(lruK);
+}
+
+// 加载后的值写入缓存，之后直接命中
+TEST(SingleFlightTest, LoadedValueIsCached) {
+    LruCache<int, std::string> cache(4);
+    SingleFlight<int, std::string> flight;
+    int loads = 0;
+    auto loader = [&loads](const int& key) {
+        ++loads;
+        return std::to_string(key);
+    };
+    EXPECT_EQ(getOrLoad(cache, flight, 1, loader), "1");
+    EXPECT_EQ(getOrLoad(cache, flight, 1, loader), "1");
+    EXPECT_EQ(loads, 1);
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "1");
+}
+
+// loader 抛异常：这一轮所有等待者都收到异常，结果不写入缓存，下一次重新加载
+TEST(SingleFlightTest, LoaderExceptionPropagatesToWaiters) {
+    LruCache<int, int> cache(4);
+    SingleFlight<int, int> flight;
+    std::atomic<int> loads{0};
+    std::atomic<int> failures{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&]() {
+            try {
+                getOrLoad(cache, flight, 7, [&loads](const int&) -> int {
+                    loads.fetch_add(1);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    throw std::runtime_error("backend down");
+                });
+            } catch (const std::runtime_error&) {
+                failures.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(failures.load(), 8);
+    EXPECT_LT(loads.load(), 8); // 至少有一部分调用者等到了同一次失败
+    int value;
+    EXPECT_FALSE(cache.get(7, value));
+
+    // 后端恢复后重新加载
+    EXPECT_EQ(getOrLoad(cache, flight, 7, [](const int&) { return 70; }), 70);
+    EXPECT_TRUE(cache.get(7, value));
+}
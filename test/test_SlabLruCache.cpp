@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include "SlabLruCache.h"
+
+using namespace KamaCache;
+
+// 测试 SlabLruCache 的基本插入、访问和淘汰
+TEST(SlabLruCacheTest, BasicOperations) {
+    SlabLruCache<int, std::string> cache(2);
+
+    cache.put(1, "One");
+    cache.put(2, "Two");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "One");
+
+    // key 2 是最久未使用的，插入 key 3 时被淘汰
+    cache.put(3, "Three");
+    EXPECT_FALSE(cache.get(2, value));
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(cache.get(3), "Three");
+    EXPECT_EQ(cache.size(), 2u);
+}
+
+// 删除后的槽位可以被重新使用
+TEST(SlabLruCacheTest, RemoveReusesSlot) {
+    SlabLruCache<int, int> cache(2);
+    cache.put(1, 10);
+    cache.put(2, 20);
+    cache.remove(1);
+    EXPECT_EQ(cache.size(), 1u);
+
+    cache.put(3, 30); // 使用空闲槽位，不淘汰 key 2
+    int value = 0;
+    EXPECT_TRUE(cache.get(2, value));
+    EXPECT_EQ(value, 20);
+    EXPECT_TRUE(cache.get(3, value));
+    EXPECT_EQ(value, 30);
+
+    // 更新已有 key 的值
+    cache.put(2, 21);
+    EXPECT_EQ(cache.get(2), 21);
+}
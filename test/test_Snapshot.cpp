@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "LfuCache.h"
+#include "LruCache.h"
+#include "LruKCache.h"
+
+using namespace KamaCache;
+
+// 非平凡类型通过特化 Serializer 写入快照
+struct Profile {
+    std::string name;
+    int age;
+};
+
+namespace KamaCache {
+template <>
+struct Serializer<Profile> {
+    static void write(SnapshotWriter& out, const Profile& p) {
+        Serializer<std::string>::write(out, p.name);
+        out.writePod(p.age);
+    }
+    static bool read(SnapshotReader& in, Profile& p) {
+        return Serializer<std::string>::read(in, p.name) && in.readPod(p.age);
+    }
+};
+} // namespace KamaCache
+
+static std::string snapshotPath(const char* name) {
+    return std::string("kamacache_") + name + ".snap";
+}
+
+// LRU 顺序在恢复后保持不变：最久未使用的仍然最先被淘汰
+TEST(SnapshotTest, LruRoundTripKeepsRecencyOrder) {
+    std::string path = snapshotPath("lru");
+    {
+        LruCache<int, std::string> cache(3);
+        cache.put(1, "One");
+        cache.put(2, "Two");
+        cache.put(3, "Three");
+        std::string value;
+        cache.get(1, value); // 顺序变为 2, 3, 1
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+
+    LruCache<int, std::string> restored(3);
+    ASSERT_TRUE(restored.loadSnapshot(path));
+    EXPECT_EQ(restored.totalWeight(), 3u);
+    restored.put(4, "Four"); // 淘汰 2
+    std::string value;
+    EXPECT_FALSE(restored.get(2, value));
+    EXPECT_TRUE(restored.get(1, value));
+    EXPECT_EQ(value, "One");
+    EXPECT_TRUE(restored.get(3, value));
+    std::remove(path.c_str());
+}
+
+// 恢复到更小的缓存：只保留最近使用的一端
+TEST(SnapshotTest, LruRestoreIntoSmallerCache) {
+    std::string path = snapshotPath("lru_small");
+    {
+        LruCache<int, int> cache(10);
+        for (int i = 0; i < 10; ++i) cache.put(i, i * i);
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+    LruCache<int, int> restored(4);
+    ASSERT_TRUE(restored.loadSnapshot(path));
+    int value;
+    EXPECT_FALSE(restored.get(5, value));
+    for (int i = 6; i < 10; ++i) {
+        EXPECT_TRUE(restored.get(i, value));
+        EXPECT_EQ(value, i * i);
+    }
+    std::remove(path.c_str());
+}
+
+// 自定义 Serializer 和 TTL：剩余时间随快照保存，恢复后照常过期
+TEST(SnapshotTest, CustomSerializerAndTtl) {
+    std::string path = snapshotPath("ttl");
+    {
+        LruCache<int, Profile> cache(4);
+        cache.put(1, Profile{"alice", 30});
+        cache.put(2, Profile{"bob", 40}, std::chrono::milliseconds(30));
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+    LruCache<int, Profile> restored(4);
+    ASSERT_TRUE(restored.loadSnapshot(path));
+    Profile p;
+    EXPECT_TRUE(restored.get(1, p));
+    EXPECT_EQ(p.name, "alice");
+    EXPECT_EQ(p.age, 30);
+    EXPECT_TRUE(restored.get(2, p));
+    EXPECT_EQ(p.name, "bob");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_FALSE(restored.get(2, p));
+    EXPECT_TRUE(restored.get(1, p));
+    std::remove(path.c_str());
+}
+
+// LFU 恢复后频次不变：低频的数据先被淘汰
+TEST(SnapshotTest, LfuRoundTripKeepsFrequencies) {
+    std::string path = snapshotPath("lfu");
+    {
+        LfuCache<int, std::string> cache(3);
+        cache.put(1, "One");
+        cache.put(2, "Two");
+        cache.put(3, "Three");
+        std::string value;
+        for (int i = 0; i < 3; ++i) cache.get(1, value);
+        for (int i = 0; i < 2; ++i) cache.get(3, value);
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+
+    LfuCache<int, std::string> restored(3);
+    ASSERT_TRUE(restored.loadSnapshot(path));
+    restored.put(4, "Four"); // 淘汰频次最低的 2
+    std::string value;
+    EXPECT_FALSE(restored.get(2, value));
+    restored.put(5, "Five"); // 4 和 5 都是新数据，淘汰 4
+    EXPECT_FALSE(restored.get(4, value));
+    EXPECT_TRUE(restored.get(1, value));
+    EXPECT_EQ(value, "One");
+    EXPECT_TRUE(restored.get(3, value));
+    std::remove(path.c_str());
+}
+
+// LRU-K 恢复后历史访问次数不变：再访问一次就能晋升
+TEST(SnapshotTest, LruKRoundTripKeepsHistory) {
+    std::string path = snapshotPath("lruk");
+    {
+        LruKCache<int, std::string> cache(2, 4, 3);
+        cache.put(1, "One");
+        cache.put(1, "One");
+        cache.put(1, "One"); // 第 3 次访问晋升
+        cache.put(2, "Two");
+        cache.put(2, "Two"); // 历史中访问 2 次
+        std::string value;
+        cache.get(3, value); // 只 get 过，没有值
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+
+    LruKCache<int, std::string> restored(2, 4, 3);
+    ASSERT_TRUE(restored.loadSnapshot(path));
+    EXPECT_EQ(restored.size(), 1u);
+    EXPECT_EQ(restored.historySize(), 2u);
+    std::string value;
+    EXPECT_TRUE(restored.get(1, value));
+    EXPECT_EQ(value, "One");
+    EXPECT_TRUE(restored.get(2, value)); // 第 3 次访问，用暂存的值晋升
+    EXPECT_EQ(value, "Two");
+    EXPECT_FALSE(restored.get(3, value));
+    std::remove(path.c_str());
+}
+
+// 文件不存在、类型不匹配或被截断时加载失败
+TEST(SnapshotTest, RejectsMissingMismatchedAndTruncatedFiles) {
+    std::string path = snapshotPath("bad");
+    LruCache<int, int> lru(4);
+    EXPECT_FALSE(lru.loadSnapshot(path));
+
+    {
+        LfuCache<int, int> lfu(4);
+        lfu.put(1, 1);
+        ASSERT_TRUE(lfu.saveSnapshot(path));
+    }
+    EXPECT_FALSE(lru.loadSnapshot(path)); // LFU 的快照不能读进 LRU
+
+    {
+        LruCache<int, int> cache(4);
+        cache.put(1, 1);
+        cache.put(2, 2);
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+    std::FILE* file = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    ASSERT_EQ(::truncate(path.c_str(), size - 2), 0);
+    EXPECT_FALSE(lru.loadSnapshot(path));
+    int value;
+    EXPECT_TRUE(lru.get(1, value)); // 截断之前的条目保留
+    std::remove(path.c_str());
+}
+
+// 文件头里的条目数被改得很大：加载返回 false，不会按它预分配而抛出异常
+TEST(SnapshotTest, HugeHeaderCountIsRejected) {
+    std::string path = snapshotPath("huge");
+    auto weigher = [](const int&, const int&) { return size_t(1); };
+    auto corruptCount = [&path]() {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        ASSERT_NE(file, nullptr);
+        uint64_t count = uint64_t(1) << 60;
+        std::fseek(file, 16, SEEK_SET); // magic(8) + policy(4) + reserved(4)
+        std::fwrite(&count, sizeof(count), 1, file);
+        std::fclose(file);
+    };
+
+    {
+        LruCache<int, int> cache(4);
+        cache.put(1, 1);
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+    corruptCount();
+    LruCache<int, int> lru(100, weigher);
+    EXPECT_FALSE(lru.loadSnapshot(path));
+    int value;
+    EXPECT_TRUE(lru.get(1, value));
+
+    {
+        LfuCache<int, int> cache(4);
+        cache.put(1, 1);
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+    corruptCount();
+    LfuCache<int, int> lfu(100, weigher);
+    EXPECT_FALSE(lfu.loadSnapshot(path));
+    EXPECT_TRUE(lfu.get(1, value));
+
+    {
+        LruKCache<int, int> cache(4, 4, 1);
+        cache.put(1, 1);
+        ASSERT_TRUE(cache.saveSnapshot(path));
+    }
+    corruptCount();
+    LruKCache<int, int> lruK(100, 4, 1, weigher);
+    EXPECT_FALSE(lruK.loadSnapshot(path));
+    EXPECT_TRUE(lruK.get(1, value));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+#include "TimingWheel.h"
+
+using namespace KamaCache;
+
+// 推进到 nowTick，返回到期的 key
+static std::vector<int> advanceTo(TimingWheel<int>& wheel, uint64_t nowTick) {
+    std::vector<int> fired;
+    wheel.advance(nowTick, [&fired](const int& key, uint64_t) { fired.push_back(key); });
+    return fired;
+}
+
+// 各层的记录都在到期 tick 准时触发，不早也不晚
+TEST(TimingWheelTest, FiresAtDeadlineOnEveryLevel) {
+    TimingWheel<int> wheel;
+    wheel.schedule(1, 5);          // 第 0 层
+    wheel.schedule(2, 70);         // 第 1 层
+    wheel.schedule(3, 5000);       // 第 2 层
+    wheel.schedule(4, 300000);     // 第 3 层
+    EXPECT_EQ(wheel.size(), 4u);
+
+    EXPECT_TRUE(advanceTo(wheel, 4).empty());
+    EXPECT_EQ(advanceTo(wheel, 5), std::vector<int>{1});
+    EXPECT_TRUE(advanceTo(wheel, 69).empty());
+    EXPECT_EQ(advanceTo(wheel, 70), std::vector<int>{2});
+    EXPECT_TRUE(advanceTo(wheel, 4999).empty());
+    EXPECT_EQ(advanceTo(wheel, 5000), std::vector<int>{3});
+    EXPECT_TRUE(advanceTo(wheel, 299999).empty());
+    EXPECT_EQ(advanceTo(wheel, 300000), std::vector<int>{4});
+    EXPECT_TRUE(wheel.empty());
+}
+
+// 超出最高层范围的记录先停在最高层，cascade 后仍然准时触发
+TEST(TimingWheelTest, DeadlineBeyondWheelSpan) {
+    TimingWheel<int> wheel;
+    const uint64_t far = (uint64_t(1) << 24) + 12345;
+    wheel.schedule(7, far);
+    EXPECT_TRUE(advanceTo(wheel, far - 1).empty());
+    EXPECT_EQ(advanceTo(wheel, far), std::vector<int>{7});
+}
+
+// 一次推进跨过多个到期时间，同一个 tick 的记录一起交出
+TEST(TimingWheelTest, BatchAdvance) {
+    TimingWheel<int> wheel;
+    for (int i = 0; i < 100; ++i) {
+        wheel.schedule(i, 10 + i % 3);
+    }
+    wheel.schedule(1000, 500);
+    EXPECT_EQ(advanceTo(wheel, 20).size(), 100u);
+    EXPECT_EQ(wheel.size(), 1u);
+
+    // 过去的到期时间最早在下一个 tick 触发
+    wheel.schedule(2000, 3);
+    EXPECT_EQ(advanceTo(wheel, 21), std::vector<int>{2000});
+}
+
+// clear 丢掉所有层上的记录，之后登记的记录照常到期
+TEST(TimingWheelTest, ClearDropsEveryLevel) {
+    TimingWheel<int> wheel;
+    wheel.schedule(1, 5);
+    wheel.schedule(2, 100);
+    wheel.schedule(3, 10000);
+    wheel.schedule(4, (uint64_t(1) << 20) + 7);
+    wheel.clear();
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_TRUE(advanceTo(wheel, uint64_t(1) << 21).empty());
+
+    wheel.schedule(5, (uint64_t(1) << 21) + 70);
+    EXPECT_EQ(advanceTo(wheel, (uint64_t(1) << 21) + 70), std::vector<int>{5});
+    EXPECT_TRUE(wheel.empty());
+}
+
+// 长时间空闲后推进：只在有记录到期或需要 cascade 的 tick 停下，耗时和跨过的 tick 数无关
+TEST(TimingWheelTest, LongIdleGapIsCheap) {
+    TimingWheel<int> wheel;
+    wheel.schedule(1, 5);
+    wheel.schedule(2, 3600000);       // 1 ms 的 tick：1 小时
+    wheel.schedule(3, 36000000);      // 10 小时，超出最高层范围
+    const uint64_t year = 365ull * 24 * 3600 * 1000;
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(advanceTo(wheel, year), (std::vector<int>{1, 2, 3}));
+    // 逐 tick 推进需要 3e10 次循环（分钟级）；跳跃只需要几百次
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_TRUE(wheel.empty());
+
+    // 跳跃之后登记的记录仍然准时触发
+    wheel.schedule(4, year + 100);
+    EXPECT_TRUE(advanceTo(wheel, year + 99).empty());
+    EXPECT_EQ(advanceTo(wheel, year + 100), std::vector<int>{4});
+}
+
+// 随机登记和推进，和“到期 tick 一到就触发”的参考模型比较
+TEST(TimingWheelTest, MatchesReferenceModel) {
+    TimingWheel<int> wheel;
+    std::mt19937_64 rng(5);
+    std::map<int, uint64_t> expected; // key -> 应该触发的 tick
+    uint64_t now = 0;
+    int nextKey = 0;
+    for (int round = 0; round < 2000; ++round) {
+        int schedules = static_cast<int>(rng() % 4);
+        for (int i = 0; i < schedules; ++i) {
+            // 距离覆盖各层以及超出最高层范围
+            uint64_t delta = rng() % (uint64_t(1) << (6 * (1 + rng() % 5)));
+            uint64_t deadline = now + delta;
+            wheel.schedule(nextKey, deadline);
+            expected[nextKey++] = std::max(deadline, now + 1);
+        }
+        uint64_t step = rng() % 2 == 0 ? rng() % 100 : rng() % (uint64_t(1) << (6 * (1 + rng() % 4)));
+        now += step;
+        std::vector<int> fired;
+        wheel.advance(now, [&](const int& key, uint64_t deadline) {
+            fired.push_back(key);
+            EXPECT_LE(deadline, now);
+        });
+        for (int key : fired) {
+            ASSERT_TRUE(expected.count(key)) << key;
+            EXPECT_LE(expected[key], now) << key;
+            expected.erase(key);
+        }
+        for (auto& item : expected) ASSERT_GT(item.second, now) << item.first;
+    }
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "WTinyLfuCache.h"
+#include "LruCache.h"
+
+using namespace KamaCache;
+
+// 测试 WTinyLfuCache 的基本插入、访问和删除
+TEST(WTinyLfuCacheTest, BasicOperations) {
+    WTinyLfuCache<int, std::string> cache(10);
+
+    cache.put(1, "One");
+    cache.put(2, "Two");
+
+    std::string value;
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "One");
+    EXPECT_EQ(cache.get(2), "Two");
+
+    cache.put(1, "Uno");
+    EXPECT_TRUE(cache.get(1, value));
+    EXPECT_EQ(value, "Uno");
+
+    cache.remove(1);
+    EXPECT_FALSE(cache.get(1, value));
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+// 容量不会被超出
+TEST(WTinyLfuCacheTest, CapacityLimit) {
+    WTinyLfuCache<int, int> cache(50);
+    for (int i = 0; i < 1000; ++i) {
+        cache.put(i, i);
+        EXPECT_LE(cache.size(), 50u);
+    }
+}
+
+// sketch 的频率估计随访问增长，饱和在 15
+TEST(WTinyLfuCacheTest, SketchCountsAccesses) {
+    CountMinSketch sketch(1000);
+    EXPECT_EQ(sketch.frequency(42), 0u);
+    for (int i = 0; i < 3; ++i) sketch.increment(42);
+    EXPECT_GE(sketch.frequency(42), 3u);
+    for (int i = 0; i < 20; ++i) sketch.increment(42);
+    EXPECT_EQ(sketch.frequency(42), 15u);
+
+    sketch.reset();
+    EXPECT_EQ(sketch.frequency(42), 7u);
+}
+
+// 热点数据访问多次后，一次性扫描的候选者频率更低，无法把热点挤出主缓存
+TEST(WTinyLfuCacheTest, AdmissionRejectsColdCandidates) {
+    WTinyLfuCache<int, int> cache(100);
+    int value = 0;
+    for (int round = 0; round < 5; ++round) {
+        for (int k = 0; k < 90; ++k) {
+            if (!cache.get(k, value)) cache.put(k, k);
+        }
+    }
+    for (int k = 100000; k < 100300; ++k) {
+        if (!cache.get(k, value)) cache.put(k, k);
+    }
+
+    int hot = 0;
+    for (int k = 0; k < 90; ++k) {
+        if (cache.get(k, value)) ++hot;
+    }
+    EXPECT_GE(hot, 85);
+}
+
+// 热点数据 + 一次性扫描的混合负载：W-TinyLFU 的命中率应明显高于 LRU
+TEST(WTinyLfuCacheTest, ResistsScans) {
+    const int capacity = 100;
+    WTinyLfuCache<int, int> tiny(capacity);
+    LruCache<int, int> lru(capacity);
+
+    int tinyHits = 0, lruHits = 0;
+    int scanKey = 100000;
+    for (int round = 0; round < 50; ++round) {
+        for (int k = 0; k < 50; ++k) {
+            int value;
+            if (tiny.get(k, value)) ++tinyHits; else tiny.put(k, k);
+            if (lru.get(k, value)) ++lruHits; else lru.put(k, k);
+        }
+        for (int i = 0; i < 100; ++i, ++scanKey) {
+            int value;
+            if (!tiny.get(scanKey, value)) tiny.put(scanKey, scanKey);
+            if (!lru.get(scanKey, value)) lru.put(scanKey, scanKey);
+        }
+    }
+    EXPECT_GT(tinyHits, lruHits * 2);
+}